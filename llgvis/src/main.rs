@@ -13,7 +13,7 @@ use std::{
 };
 
 use esp::{ByteBufferExtRead, ByteReader};
-use structs::PlayerLog;
+use structs::{PlayerLog, PlayerLogData};
 
 mod structs;
 mod visualizer;
@@ -27,6 +27,81 @@ fn filter_noise(log: &mut PlayerLog) {
         data.0.position.0 > min && data.0.position.1 > min && data.1.position.0 > min && data.1.position.1 > min
     });
     log.lerp_skipped.retain(|data| data.position.0 > min && data.position.1 > min);
+    log.legacy_lerped.retain(|data| data.position.0 > min && data.position.1 > min);
+}
+
+struct Smoothness {
+    steps: usize,
+    frozen: usize,
+    mean_velocity_change: f64,
+    max_step: f64,
+}
+
+// how smooth the movement of a series of shown positions is, in order of local time.
+// frozen steps are frames where the player didn't move at all, velocity change is the jerkiness.
+fn smoothness(points: &[&PlayerLogData]) -> Smoothness {
+    let mut points = points.to_vec();
+    points.sort_by(|a, b| a.local_timestamp.total_cmp(&b.local_timestamp));
+
+    let mut result = Smoothness {
+        steps: 0,
+        frozen: 0,
+        mean_velocity_change: 0.0,
+        max_step: 0.0,
+    };
+
+    let mut last_velocity: Option<f64> = None;
+    let mut velocity_change_sum = 0.0;
+    let mut velocity_changes = 0usize;
+
+    for pair in points.windows(2) {
+        let dt = f64::from(pair[1].local_timestamp - pair[0].local_timestamp);
+        if dt <= 0.0 {
+            continue;
+        }
+
+        let dx = f64::from(pair[1].position.0 - pair[0].position.0);
+        let dy = f64::from(pair[1].position.1 - pair[0].position.1);
+        let step = dx.hypot(dy);
+
+        result.steps += 1;
+        result.max_step = result.max_step.max(step);
+
+        if step < 0.01 {
+            result.frozen += 1;
+        }
+
+        let velocity = dx / dt;
+        if let Some(last) = last_velocity {
+            velocity_change_sum += (velocity - last).abs();
+            velocity_changes += 1;
+        }
+
+        last_velocity = Some(velocity);
+    }
+
+    if velocity_changes > 0 {
+        result.mean_velocity_change = velocity_change_sum / velocity_changes as f64;
+    }
+
+    result
+}
+
+fn print_smoothness(name: &str, points: &[&PlayerLogData]) {
+    if points.is_empty() {
+        println!("{name}: no data");
+        return;
+    }
+
+    let s = smoothness(points);
+    println!(
+        "{name}: {} steps, {} frozen ({:.1}%), mean x velocity change {:.2} units/s, largest step {:.2} units",
+        s.steps,
+        s.frozen,
+        s.frozen as f64 * 100.0 / s.steps.max(1) as f64,
+        s.mean_velocity_change,
+        s.max_step
+    );
 }
 
 fn main() -> Result<(), Box<dyn Error>> {
@@ -62,15 +137,29 @@ fn main() -> Result<(), Box<dyn Error>> {
     .unwrap();
 
     println!(
-        "log entries: {} real, {} extrapolated, {} visual, {} skipped",
+        "log entries: {} real, {} extrapolated, {} visual, {} skipped, {} legacy visual",
         player_log.real.len(),
         player_log.real_extrapolated.len(),
         player_log.lerped.len(),
-        player_log.lerp_skipped.len()
+        player_log.lerp_skipped.len(),
+        player_log.legacy_lerped.len()
     );
 
     filter_noise(player_log);
+
+    // what was shown with the snapshot buffer (interpolated and held frames) versus the old two frame interpolation
+    let shown = player_log.lerped.iter().chain(player_log.lerp_skipped.iter()).collect::<Vec<_>>();
+    let legacy = player_log.legacy_lerped.iter().collect::<Vec<_>>();
+    print_smoothness("snapshot buffer", &shown);
+    print_smoothness("legacy interpolation", &legacy);
+
+    if let Some(last) = player_log.playout.last() {
+        let avg_delay = player_log.playout.iter().map(|p| f64::from(p.delay)).sum::<f64>() / player_log.playout.len() as f64;
+        println!("playout delay: avg {:.1}ms, last {:.1}ms (jitter {:.1}ms)", avg_delay * 1000.0, last.delay * 1000.0, last.jitter * 1000.0);
+    }
+
     visualizer::draw(player_log)?;
+    visualizer::draw_playout(player_log)?;
 
     // dump all into a text file
 
@@ -128,6 +217,20 @@ fn main() -> Result<(), Box<dyn Error>> {
         .as_str();
     }
 
+    data += "\n\n\n-----Legacy interpolated data points-----\n";
+    for (n, point) in player_log.legacy_lerped.iter().enumerate() {
+        data += format!(
+            "[{n}] [{}, {}, d: {}] - x: {}, y: {}, rot: {}\n",
+            point.local_timestamp,
+            point.timestamp,
+            (point.timestamp - point.local_timestamp).abs(),
+            point.position.0,
+            point.position.1,
+            point.rotation
+        )
+        .as_str();
+    }
+
     data += "\n\n\n-----Skipped data points-----\n";
     for (n, point) in player_log.lerp_skipped.iter().enumerate() {
         data += format!(
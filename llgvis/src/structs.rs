@@ -9,10 +9,20 @@ pub struct PlayerLogData {
     pub rotation: f32,
 }
 
+#[derive(Decodable, Clone)]
+pub struct PlayoutLogData {
+    pub local_timestamp: f32,
+    pub playout_time: f32,
+    pub delay: f32,
+    pub jitter: f32,
+}
+
 #[derive(Decodable, Clone)]
 pub struct PlayerLog {
     pub real: Vec<PlayerLogData>,
     pub real_extrapolated: Vec<(PlayerLogData, PlayerLogData)>,
     pub lerped: Vec<PlayerLogData>,
     pub lerp_skipped: Vec<PlayerLogData>,
+    pub legacy_lerped: Vec<PlayerLogData>,
+    pub playout: Vec<PlayoutLogData>,
 }
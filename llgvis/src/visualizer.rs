@@ -5,7 +5,11 @@ use plotters::{
     chart::ChartBuilder,
     drawing::IntoDrawingArea,
     element::Circle,
-    style::{full_palette::LIGHTBLUE, ShapeStyle, BLACK, BLUE, GREEN, RED, WHITE},
+    series::LineSeries,
+    style::{
+        full_palette::{LIGHTBLUE, ORANGE},
+        ShapeStyle, BLACK, BLUE, GREEN, RED, WHITE,
+    },
 };
 
 use crate::structs::PlayerLog;
@@ -70,6 +74,15 @@ pub fn draw(log: &PlayerLog) -> Result<(), Box<dyn Error>> {
         )
     }))?;
 
+    // draw what the old two frame interpolation would have shown (orange)
+    chart.draw_series(log.legacy_lerped.iter().map(|data| {
+        Circle::new(
+            (data.position.0 as f64, data.position.1 as f64),
+            1,
+            Into::<ShapeStyle>::into(ORANGE).filled(),
+        )
+    }))?;
+
     // draw real frames (green)
     chart.draw_series(log.real.iter().map(|data| {
         Circle::new(
@@ -108,3 +121,41 @@ pub fn draw(log: &PlayerLog) -> Result<(), Box<dyn Error>> {
 
     Ok(())
 }
+
+// playout delay (black) and jitter (red) in milliseconds over local time
+pub fn draw_playout(log: &PlayerLog) -> Result<(), Box<dyn Error>> {
+    let (Some(first), Some(last)) = (log.playout.first(), log.playout.last()) else {
+        return Ok(());
+    };
+
+    let t_min = first.local_timestamp as f64;
+    let t_max = (last.local_timestamp as f64).max(t_min + 1.0);
+    let ms_max = log
+        .playout
+        .iter()
+        .map(|p| p.delay.max(p.jitter) as f64 * 1000.0)
+        .fold(10.0, f64::max);
+
+    let root = BitMapBackend::new("playout_plot.png", (1200, 400)).into_drawing_area();
+    root.fill(&WHITE)?;
+
+    let mut chart = ChartBuilder::on(&root)
+        .margin(10)
+        .x_label_area_size(40)
+        .y_label_area_size(40)
+        .build_cartesian_2d(t_min..t_max, 0.0..(ms_max * 1.1))?;
+
+    chart.configure_mesh().draw()?;
+
+    chart.draw_series(LineSeries::new(
+        log.playout.iter().map(|p| (p.local_timestamp as f64, p.delay as f64 * 1000.0)),
+        &BLACK,
+    ))?;
+
+    chart.draw_series(LineSeries::new(
+        log.playout.iter().map(|p| (p.local_timestamp as f64, p.jitter as f64 * 1000.0)),
+        &RED,
+    ))?;
+
+    Ok(())
+}
@@ -77,6 +77,18 @@ Result<DecodedOpusData> AudioDecoder::decode(const EncodedOpusData& data) {
     return this->decode(data.ptr, data.length);
 }
 
+Result<size_t> AudioDecoder::decodeInto(const byte* data, size_t length, float* out, size_t outSamples, bool fec) {
+    // for concealment and fec, opus needs the exact duration of the missing frame
+    int samples = (data && !fec) ? outSamples / channels : frameSize;
+    _res = opus_decode_float(decoder, data, data ? length : 0, out, samples, fec ? 1 : 0);
+
+    if (_res < 0) {
+        GLOBED_UNWRAP(this->errcheck("opus_decode_float"));
+    }
+
+    return Ok(static_cast<size_t>(_res) * channels);
+}
+
 Result<> AudioDecoder::setSampleRate(int sampleRate) {
     this->sampleRate = sampleRate;
     return this->remakeDecoder();
@@ -37,6 +37,12 @@ public:
     // After you no longer need the decoded data, you must call `data.freeData()`, or (preferrably, for explicitness) `AudioDecoder::freeData(data)`
     [[nodiscard]] Result<DecodedOpusData> decode(const EncodedOpusData& data);
 
+    // Decodes the given Opus data into `out`, which must have room for `outSamples` samples (at least `frameSize * channels`).
+    // Returns the amount of samples written. Unlike `decode`, this does not allocate.
+    // If `data` is nullptr, opus packet loss concealment fills in a frame in place of a lost one.
+    // If `fec` is true, `data` must be the frame that follows the lost one, and the lost frame is recovered from its forward error correction data.
+    [[nodiscard]] Result<size_t> decodeInto(const util::data::byte* data, size_t length, float* out, size_t outSamples, bool fec = false);
+
     static void freeData(DecodedOpusData& data) {
         data.freeData();
     }
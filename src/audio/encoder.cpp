@@ -2,6 +2,8 @@
 
 #ifdef GLOBED_VOICE_SUPPORT
 
+#include "frame_pool.hpp"
+
 #include <opus.h>
 
 using namespace util::data;
@@ -9,7 +11,11 @@ using namespace util::data;
 void EncodedOpusData::freeData() {
     GLOBED_REQUIRE(ptr != nullptr, "attempting to double free an instance of EncodedOpusData")
 
-    delete[] ptr;
+    if (pooled) {
+        OpusFramePool::get().release(ptr);
+    } else if (!borrowed) {
+        delete[] ptr;
+    }
 
 #ifdef GLOBED_DEBUG
     // to try and prevent misuse
@@ -23,7 +29,7 @@ template<> void ByteBuffer::customEncode(const EncodedOpusData& data) {
     this->rawWriteBytes(data.ptr, data.length);
 }
 
-template<> ByteBuffer::DecodeResult<EncodedOpusData> ByteBuffer::customDecode() {
+template<> ByteReader::DecodeResult<EncodedOpusData> ByteReader::customDecode() {
     EncodedOpusData out;
 
     GLOBED_UNWRAP_INTO(this->readU32(), out.length);
@@ -33,11 +39,20 @@ template<> ByteBuffer::DecodeResult<EncodedOpusData> ByteBuffer::customDecode()
         return Err(DecodeError::DataTooLong);
     }
 
-    out.ptr = new util::data::byte[out.length];
+    // borrow the data straight from the packet buffer if possible
+    if (this->isBorrowing()) {
+        GLOBED_UNWRAP_INTO(this->readBytesView(out.length), auto view);
+        out.ptr = const_cast<util::data::byte*>(view.data());
+        out.borrowed = true;
+        return Ok(out);
+    }
+
+    out.ptr = OpusFramePool::get().acquire();
+    out.pooled = true;
 
     auto result = this->readBytesInto(out.ptr, out.length);
     if (result.isErr()) {
-        delete[] out.ptr;
+        OpusFramePool::get().release(out.ptr);
         out.ptr = nullptr;
         return Err(std::move(result.unwrapErr()));
     }
@@ -86,19 +101,31 @@ AudioEncoder& AudioEncoder::operator=(AudioEncoder&& other) noexcept {
 
 Result<EncodedOpusData> AudioEncoder::encode(const float* data) {
     EncodedOpusData out;
-    size_t bytes = sizeof(float) * frameSize / 4; // the /4 is arbitrary, could experiment with it
-    out.ptr = new byte[bytes];
+    out.ptr = OpusFramePool::get().acquire();
+    out.pooled = true;
 
-    out.length = opus_encode_float(encoder, data, frameSize, out.ptr, bytes);
-    if (out.length < 0) {
-        delete[] out.ptr;
-        _res = out.length;
-        GLOBED_UNWRAP(this->errcheck("opus_encode_float"));
+    // frames bigger than this would be rejected by the receiver anyway
+    auto result = this->encodeInto(data, out.ptr, VOICE_MAX_BYTES_IN_FRAME);
+    if (result.isErr()) {
+        OpusFramePool::get().release(out.ptr);
+        return Err(std::move(result.unwrapErr()));
     }
 
+    out.length = result.unwrap();
+
     return Ok(out);
 }
 
+Result<size_t> AudioEncoder::encodeInto(const float* data, byte* out, size_t outBytes) {
+    opus_int32 length = opus_encode_float(encoder, data, frameSize, out, outBytes);
+    if (length < 0) {
+        _res = length;
+        GLOBED_UNWRAP(this->errcheck("opus_encode_float"));
+    }
+
+    return Ok(static_cast<size_t>(length));
+}
+
 Result<> AudioEncoder::setSampleRate(int sampleRate) {
     this->sampleRate = sampleRate;
     return this->remakeEncoder();
@@ -146,7 +173,15 @@ Result<> AudioEncoder::remakeEncoder() {
     }
 
     encoder = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_VOIP, &_res);
-    return this->errcheck("opus_encoder_create");
+    GLOBED_UNWRAP(this->errcheck("opus_encoder_create"));
+
+    // embed a low bitrate copy of the previous frame into every frame, so the receiver can recover a single lost frame.
+    // opus only spends bits on it when it expects some packet loss.
+    _res = opus_encoder_ctl(encoder, OPUS_SET_INBAND_FEC(1));
+    GLOBED_UNWRAP(this->errcheck("AudioEncoder::remakeEncoder (inband fec)"));
+
+    _res = opus_encoder_ctl(encoder, OPUS_SET_PACKET_LOSS_PERC(VOICE_EXPECTED_PACKET_LOSS));
+    return this->errcheck("AudioEncoder::remakeEncoder (packet loss)");
 }
 
 Result<> AudioEncoder::errcheck(const char* where) {
@@ -7,6 +7,8 @@
 #include <data/bytebuffer.hpp>
 
 constexpr size_t VOICE_MAX_BYTES_IN_FRAME = 1000;
+// packet loss percentage the encoder is tuned for, higher values spend more bits on forward error correction
+constexpr int VOICE_EXPECTED_PACKET_LOSS = 5;
 
 struct OpusEncoder;
 
@@ -14,6 +16,10 @@ class EncodedOpusData {
 public:
     util::data::byte* ptr;
     int64_t length;
+    // if true, `ptr` points into a received packet buffer and is not owned by this object
+    bool borrowed = false;
+    // if true, `ptr` was taken from the `OpusFramePool` and is returned there when freed
+    bool pooled = false;
 
     void freeData();
 };
@@ -31,9 +37,13 @@ public:
     AudioEncoder& operator=(AudioEncoder&& other) noexcept;
 
     // Encode the given PCM samples with Opus. The amount of samples passed must be equal to `frameSize` passed in the constructor.
+    // The output buffer is taken from the `OpusFramePool`.
     // After you no longer need the encoded data, you must call `data.freeData()`, or (preferrably, for explicitness) `AudioEncoder::freeData(data)`
     [[nodiscard]] Result<EncodedOpusData> encode(const float* data);
 
+    // Encode the given PCM samples with Opus into `out`, which must be at least `outBytes` bytes long. Returns the length of the encoded data.
+    [[nodiscard]] Result<size_t> encodeInto(const float* data, util::data::byte* out, size_t outBytes);
+
     // Free the underlying buffer of the encoded frame
     static void freeData(EncodedOpusData& data) {
         data.freeData();
@@ -34,6 +34,7 @@ void EncodedAudioFrame::clear() {
     }
 
     frames.clear();
+    sequence.reset();
 }
 
 size_t EncodedAudioFrame::size() const {
@@ -48,13 +49,25 @@ const std::vector<EncodedOpusData>& EncodedAudioFrame::getFrames() const {
     return frames;
 }
 
+std::optional<uint32_t> EncodedAudioFrame::getSequence() const {
+    return sequence;
+}
+
+void EncodedAudioFrame::setSequence(uint32_t sequence) {
+    this->sequence = sequence;
+}
+
 template<> void ByteBuffer::customEncode(const EncodedAudioFrame& frame) {
     GLOBED_REQUIRE(
         frame.frames.size() <= frame._capacity,
         fmt::format("tried to encode an EncodedAudioFrame with {} frames when at most {} is permitted", frame.frames.size(), frame._capacity)
     )
 
-    // first encode all opus frames
+    if (this->getProtocol() >= VOICE_SEQUENCE_PROTOCOL) {
+        this->writeU32(frame.sequence.value_or(0));
+    }
+
+    // then encode all opus frames
     for (auto& frame : frame.frames) {
         this->writeValue<std::optional<EncodedOpusData>>(frame);
     }
@@ -66,8 +79,13 @@ template<> void ByteBuffer::customEncode(const EncodedAudioFrame& frame) {
     }
 }
 
-template<> ByteBuffer::DecodeResult<EncodedAudioFrame> ByteBuffer::customDecode() {
+template<> ByteReader::DecodeResult<EncodedAudioFrame> ByteReader::customDecode() {
     EncodedAudioFrame eframe;
+    eframe.frames.reserve(EncodedAudioFrame::VOICE_MAX_FRAMES_IN_AUDIO_FRAME);
+
+    if (this->getProtocol() >= VOICE_SEQUENCE_PROTOCOL) {
+        GLOBED_UNWRAP_INTO(this->readU32(), eframe.sequence);
+    }
 
     for (size_t i = 0; i < EncodedAudioFrame::VOICE_MAX_FRAMES_IN_AUDIO_FRAME; i++) {
         auto result = this->readValue<std::optional<EncodedOpusData>>();
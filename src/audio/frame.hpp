@@ -5,6 +5,9 @@
 
 #include "encoder.hpp"
 
+// first protocol version where audio frames carry the sequence number of their first opus frame
+inline constexpr uint16_t VOICE_SEQUENCE_PROTOCOL = 15;
+
 // Represents an audio frame that contains multiple encoded opus frames
 class EncodedAudioFrame {
 public:
@@ -44,9 +47,15 @@ public:
     // extract all frames
     const std::vector<EncodedOpusData>& getFrames() const;
 
+    // sequence number of the first opus frame, the following frames are numbered consecutively.
+    // only sent for `VOICE_SEQUENCE_PROTOCOL` and newer, `std::nullopt` if the sender is older.
+    std::optional<uint32_t> getSequence() const;
+    void setSequence(uint32_t sequence);
+
 protected:
     mutable std::vector<EncodedOpusData> frames;
     size_t _capacity;
+    std::optional<uint32_t> sequence;
 };
 
 
@@ -0,0 +1,50 @@
+#include "frame_pool.hpp"
+
+#ifdef GLOBED_VOICE_SUPPORT
+
+#include "encoder.hpp"
+
+using namespace util::data;
+
+byte* OpusFramePool::acquire() {
+    {
+        auto idleBufs = idle.lock();
+
+        if (!idleBufs->empty()) {
+            auto buf = idleBufs->back();
+            idleBufs->pop_back();
+            return buf;
+        }
+    }
+
+    allocated.fetch_add(1, std::memory_order_relaxed);
+    return new byte[VOICE_MAX_BYTES_IN_FRAME];
+}
+
+void OpusFramePool::release(byte* buf) {
+    {
+        auto idleBufs = idle.lock();
+
+        if (idleBufs->size() < MAX_IDLE) {
+            // reserve once, so that returning a buffer never allocates either
+            if (idleBufs->capacity() < MAX_IDLE) {
+                idleBufs->reserve(MAX_IDLE);
+            }
+
+            idleBufs->push_back(buf);
+            return;
+        }
+    }
+
+    delete[] buf;
+}
+
+size_t OpusFramePool::idleCount() {
+    return idle.lock()->size();
+}
+
+size_t OpusFramePool::allocationCount() {
+    return allocated.load(std::memory_order_relaxed);
+}
+
+#endif // GLOBED_VOICE_SUPPORT
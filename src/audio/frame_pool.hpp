@@ -0,0 +1,36 @@
+#pragma once
+#include <defs/platform.hpp>
+
+#ifdef GLOBED_VOICE_SUPPORT
+
+#include <atomic>
+#include <asp/sync.hpp>
+
+#include <util/data.hpp>
+#include <util/singleton.hpp>
+
+// Pool of buffers for encoded opus frames, each `VOICE_MAX_BYTES_IN_FRAME` bytes long.
+// Shared by the record path (encoded frames) and the playback path (received frames that could not borrow from the packet),
+// so that the voice pipeline does not hit the heap for every frame. Thread safe.
+class OpusFramePool : public SingletonLeakBase<OpusFramePool> {
+public:
+    // max amount of idle buffers kept in the pool, enough for a few seconds of voice from a full room
+    static constexpr size_t MAX_IDLE = 256;
+
+    // Get a buffer of `VOICE_MAX_BYTES_IN_FRAME` bytes, contents are unspecified.
+    util::data::byte* acquire();
+
+    // Return a buffer obtained from `acquire` to the pool.
+    void release(util::data::byte* buf);
+
+    size_t idleCount();
+
+    // total amount of buffers the pool had to allocate, stops growing once the pool has warmed up
+    size_t allocationCount();
+
+private:
+    asp::Mutex<std::vector<util::data::byte*>> idle;
+    std::atomic_size_t allocated = 0;
+};
+
+#endif // GLOBED_VOICE_SUPPORT
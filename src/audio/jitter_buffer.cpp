@@ -0,0 +1,257 @@
+#include "jitter_buffer.hpp"
+
+#ifdef GLOBED_VOICE_SUPPORT
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace util::data;
+
+// signed distance from `b` to `a`, correct across wraparound
+static int32_t seqDiff(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b);
+}
+
+VoiceJitterBuffer::VoiceJitterBuffer(double frameDuration)
+    : slots(std::make_unique<Slot[]>(CAPACITY)), frameDuration(frameDuration) {
+    this->clearSlots();
+}
+
+void VoiceJitterBuffer::push(uint32_t sequence, std::span<const EncodedOpusData> frames, double now) {
+    if (frames.empty()) return;
+
+    stats.received += frames.size();
+
+    // RFC 3550 style interarrival jitter, a running mean of the difference between the transit times of consecutive packets.
+    // the transit time is relative to the sender's clock, a packet is complete once its last frame has been recorded.
+    if (!haveTransit) {
+        transitBase = sequence;
+    }
+
+    double transit = now - seqDiff(sequence + static_cast<uint32_t>(frames.size()), transitBase) * frameDuration;
+    double transitDiff = transit - lastTransit;
+
+    // sequence numbers don't advance while the speaker is silent, so when they start talking again the transit time jumps.
+    // that is a new talk spurt rather than jitter.
+    bool newSpurt = !haveTransit || (!playing && buffered == 0 && transitDiff > MAX_DELAY_FRAMES * frameDuration);
+
+    if (newSpurt) {
+        // the frames concealed at the end of the last spurt weren't lost, nobody was talking
+        started = false;
+        bufferingSince = now;
+    } else {
+        stats.concealed += dryConcealed;
+        jitter += (std::abs(transitDiff) - jitter) / 16.0;
+    }
+
+    dryConcealed = 0;
+    lastTransit = transit;
+    haveTransit = true;
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        uint32_t seq = sequence + static_cast<uint32_t>(i);
+        auto& frame = frames[i];
+
+        if (started) {
+            int32_t offset = seqDiff(seq, nextSeq);
+
+            if (offset < -static_cast<int32_t>(CAPACITY) || offset >= static_cast<int32_t>(CAPACITY)) {
+                // way out of range, most likely the sender restarted. start over from this frame
+                this->clearSlots();
+                started = false;
+                playing = false;
+                bufferingSince = now;
+            } else if (offset < 0) {
+                stats.late++;
+                continue;
+            }
+        }
+
+        if (frame.length <= 0 || static_cast<size_t>(frame.length) > VOICE_MAX_BYTES_IN_FRAME) continue;
+
+        auto& slot = this->slotFor(seq);
+
+        if (slot.filled) {
+            if (slot.sequence == seq) {
+                stats.duplicate++;
+                continue;
+            }
+
+            // a frame so old that it would have been played long ago, make room
+            stats.dropped++;
+            buffered--;
+        }
+
+        slot.sequence = seq;
+        slot.length = static_cast<uint16_t>(frame.length);
+        slot.filled = true;
+        std::memcpy(slot.data, frame.ptr, frame.length);
+        buffered++;
+    }
+}
+
+VoiceJitterBuffer::Output VoiceJitterBuffer::pop(double now) {
+    if (!playing) {
+        if (buffered == 0 || now - bufferingSince < this->getTargetDelay()) {
+            return {};
+        }
+
+        uint32_t oldest = this->oldestSequence();
+
+        // the frames we ran dry on never showed up
+        if (started && seqDiff(oldest, nextSeq) > 0) {
+            stats.skipped += seqDiff(oldest, nextSeq);
+        }
+
+        nextSeq = oldest;
+        started = true;
+        playing = true;
+    }
+
+    if (this->has(nextSeq)) {
+        auto& slot = this->slotFor(nextSeq);
+
+        Output out {
+            .action = Action::Play,
+            .sequence = nextSeq,
+            .data = slot.data,
+            .length = slot.length,
+        };
+
+        this->take(nextSeq++);
+        stats.played++;
+        this->trackDepth();
+
+        return out;
+    }
+
+    if (buffered == 0) {
+        if (dryConcealed >= MAX_DRY_CONCEAL_FRAMES) {
+            // most likely the speaker stopped talking, wait for the next spurt
+            playing = false;
+            bufferingSince = now;
+            return {};
+        }
+
+        // only counted once we know whether the speaker is still talking
+        dryConcealed++;
+
+        return Output {
+            .action = Action::Conceal,
+            .sequence = nextSeq++,
+        };
+    }
+
+    // the frame is lost or late, if the one after it is here we can recover it from the FEC data
+    Output out {
+        .action = Action::Conceal,
+        .sequence = nextSeq,
+    };
+
+    if (this->has(nextSeq + 1)) {
+        auto& next = this->slotFor(nextSeq + 1);
+        out.action = Action::Recover;
+        out.data = next.data;
+        out.length = next.length;
+        stats.recovered++;
+    } else {
+        stats.concealed++;
+    }
+
+    nextSeq++;
+
+    return out;
+}
+
+bool VoiceJitterBuffer::isDry() const {
+    return playing && buffered == 0;
+}
+
+size_t VoiceJitterBuffer::size() const {
+    return buffered;
+}
+
+double VoiceJitterBuffer::getTargetDelay() const {
+    // with uniformly distributed delays, the mean transit difference is a third of the spread
+    return std::clamp(frameDuration + 3.0 * jitter, MIN_DELAY_FRAMES * frameDuration, MAX_DELAY_FRAMES * frameDuration);
+}
+
+double VoiceJitterBuffer::getJitter() const {
+    return jitter;
+}
+
+const VoiceJitterBuffer::Stats& VoiceJitterBuffer::getStats() const {
+    return stats;
+}
+
+void VoiceJitterBuffer::reset() {
+    this->clearSlots();
+
+    started = false;
+    playing = false;
+    dryConcealed = 0;
+    haveTransit = false;
+    jitter = 0.0;
+    windowFrames = 0;
+    windowMinDepth = CAPACITY;
+}
+
+VoiceJitterBuffer::Slot& VoiceJitterBuffer::slotFor(uint32_t sequence) {
+    return slots[sequence % CAPACITY];
+}
+
+bool VoiceJitterBuffer::has(uint32_t sequence) {
+    auto& slot = this->slotFor(sequence);
+    return slot.filled && slot.sequence == sequence;
+}
+
+void VoiceJitterBuffer::take(uint32_t sequence) {
+    this->slotFor(sequence).filled = false;
+    buffered--;
+}
+
+uint32_t VoiceJitterBuffer::oldestSequence() {
+    bool found = false;
+    uint32_t oldest = 0;
+
+    for (size_t i = 0; i < CAPACITY; i++) {
+        auto& slot = slots[i];
+        if (!slot.filled) continue;
+
+        if (!found || seqDiff(slot.sequence, oldest) < 0) {
+            oldest = slot.sequence;
+            found = true;
+        }
+    }
+
+    return oldest;
+}
+
+void VoiceJitterBuffer::clearSlots() {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        slots[i].filled = false;
+    }
+
+    buffered = 0;
+}
+
+void VoiceJitterBuffer::trackDepth() {
+    windowMinDepth = std::min(windowMinDepth, buffered);
+
+    if (++windowFrames < DRIFT_WINDOW_FRAMES) return;
+
+    // the buffer never went below this depth over the whole window, so that much delay isn't needed.
+    // drop a single frame at a time, which is barely audible, rather than all of the excess at once
+    size_t targetFrames = static_cast<size_t>(std::ceil(this->getTargetDelay() / frameDuration));
+
+    if (windowMinDepth > targetFrames + 1 && this->has(nextSeq)) {
+        this->take(nextSeq++);
+        stats.dropped++;
+    }
+
+    windowFrames = 0;
+    windowMinDepth = CAPACITY;
+}
+
+#endif // GLOBED_VOICE_SUPPORT
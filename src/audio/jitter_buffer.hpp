@@ -0,0 +1,129 @@
+#pragma once
+#include <defs/platform.hpp>
+
+#ifdef GLOBED_VOICE_SUPPORT
+
+#include "encoder.hpp"
+
+#include <memory>
+#include <span>
+
+/*
+* Per-speaker jitter buffer. Received opus frames are stored by their sequence number and taken out
+* in order, one for every frame of audio the stream plays. Frames that never arrived are recovered with opus FEC,
+* or concealed with opus PLC. Playback of a talk spurt starts once the buffer has held audio for the target delay,
+* which follows the measured interarrival jitter, and frames are dropped if the buffer keeps more audio than needed
+* (the sender's clock running faster than ours, or the jitter going down).
+*
+* Nothing in here reads the clock, the time (in seconds, from any fixed point) is passed to `push` and `pop`,
+* so recorded arrival traces replay deterministically. Not thread safe, nothing is allocated after construction.
+*/
+class VoiceJitterBuffer {
+public:
+    // in frames, almost 4 seconds of audio with 60ms frames
+    static constexpr size_t CAPACITY = 64;
+    static constexpr size_t MIN_DELAY_FRAMES = 1;
+    static constexpr size_t MAX_DELAY_FRAMES = 8;
+    // how many frames are concealed once the buffer runs dry, before assuming that the speaker stopped talking
+    static constexpr size_t MAX_DRY_CONCEAL_FRAMES = 3;
+    // the lowest buffer depth is checked every this many played frames, to detect a buildup of delay
+    static constexpr size_t DRIFT_WINDOW_FRAMES = 50;
+
+    enum class Action {
+        Play,    // decode `data`
+        Recover, // `data` is the frame after the lost one, decode it with FEC to recover the lost frame
+        Conceal, // the frame is lost, decode with opus PLC
+        Wait,    // nothing to play, either buffering or the speaker is silent
+    };
+
+    struct Output {
+        Action action = Action::Wait;
+        // the sequence number of the frame that this output stands for, meaningless for `Wait`
+        uint32_t sequence = 0;
+        // valid until the next `push`
+        const util::data::byte* data = nullptr;
+        size_t length = 0;
+    };
+
+    struct Stats {
+        size_t received = 0;
+        size_t played = 0;
+        size_t recovered = 0;
+        size_t concealed = 0;
+        // frames skipped when playback resumed after the buffer ran dry
+        size_t skipped = 0;
+        // frames that arrived after their turn to be played
+        size_t late = 0;
+        size_t duplicate = 0;
+        // frames dropped to bring the delay down
+        size_t dropped = 0;
+    };
+
+    // `frameDuration` is the duration of one opus frame, in seconds
+    VoiceJitterBuffer(double frameDuration);
+
+    VoiceJitterBuffer(const VoiceJitterBuffer&) = delete;
+    VoiceJitterBuffer& operator=(const VoiceJitterBuffer&) = delete;
+    VoiceJitterBuffer(VoiceJitterBuffer&&) noexcept = default;
+    VoiceJitterBuffer& operator=(VoiceJitterBuffer&&) noexcept = default;
+
+    // store the frames of one received packet, `sequence` is the sequence number of the first frame, `now` the time of arrival.
+    // frames longer than `VOICE_MAX_BYTES_IN_FRAME` are ignored.
+    void push(uint32_t sequence, std::span<const EncodedOpusData> frames, double now);
+
+    // take out the next frame to be played at `now`
+    Output pop(double now);
+
+    // true if playback is ongoing but there are no frames to play next, `pop` will start concealing
+    bool isDry() const;
+    // amount of stored frames
+    size_t size() const;
+
+    // how long the buffer waits before starting to play a talk spurt, in seconds
+    double getTargetDelay() const;
+    // estimated interarrival jitter, in seconds
+    double getJitter() const;
+    const Stats& getStats() const;
+
+    // forget all frames and the jitter estimate
+    void reset();
+
+private:
+    struct Slot {
+        uint32_t sequence;
+        uint16_t length;
+        bool filled;
+        util::data::byte data[VOICE_MAX_BYTES_IN_FRAME];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    double frameDuration;
+    size_t buffered = 0;
+
+    bool started = false; // `nextSeq` is valid
+    bool playing = false;
+    uint32_t nextSeq = 0;
+    double bufferingSince = 0.0;
+    // frames concealed after running dry, they were not lost if the speaker simply stopped talking.
+    // added to the stats if the next packet continues the same talk spurt
+    size_t dryConcealed = 0;
+
+    bool haveTransit = false;
+    uint32_t transitBase = 0;
+    double lastTransit = 0.0;
+    double jitter = 0.0;
+
+    size_t windowFrames = 0;
+    size_t windowMinDepth = CAPACITY;
+
+    Stats stats;
+
+    Slot& slotFor(uint32_t sequence);
+    bool has(uint32_t sequence);
+    void take(uint32_t sequence);
+    uint32_t oldestSequence();
+    void clearSlots();
+    void trackDepth();
+};
+
+#endif // GLOBED_VOICE_SUPPORT
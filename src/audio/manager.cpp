@@ -556,11 +556,12 @@ Result<> GlobedAudioManager::audioThreadWork() {
     )
 
     if (recordingRaw) {
-        // raw recording, call the raw callback with the pcm data directly.
-        float* pcm = recordQueue.data();
-        size_t samples = recordQueue.size();
-        this->recordInvokeRawCallback(pcm, samples);
-        recordQueue.clear();
+        // raw recording, call the raw callback with the pcm data directly, a frame at a time.
+        float pcmbuf[VOICE_TARGET_FRAMESIZE];
+        while (size_t samples = std::min(recordQueue.size(), VOICE_TARGET_FRAMESIZE)) {
+            recordQueue.copyTo(pcmbuf, samples);
+            this->recordInvokeRawCallback(pcmbuf, samples);
+        }
     } else {
         // encoded recording, encode the data and push to the frame.
         if (recordQueue.size() >= VOICE_TARGET_FRAMESIZE) {
@@ -568,7 +569,12 @@ Result<> GlobedAudioManager::audioThreadWork() {
             recordQueue.copyTo(pcmbuf, VOICE_TARGET_FRAMESIZE);
 
             GLOBED_UNWRAP_INTO(encoder.encode(pcmbuf), auto opusFrame);
+            if (recordFrame.size() == 0) {
+                recordFrame.setSequence(recordSequence);
+            }
+
             GLOBED_UNWRAP(recordFrame.pushOpusFrame(opusFrame));
+            recordSequence++;
         }
 
         // if we are at capacity, or we just stopped passive recording, call the callback
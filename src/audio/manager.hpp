@@ -36,6 +36,7 @@ constexpr size_t VOICE_TARGET_SAMPLERATE = 24000;
 constexpr float VOICE_CHUNK_RECORD_TIME = 0.06f; // the audio buffer that is recorded at once (60ms)
 constexpr size_t VOICE_TARGET_FRAMESIZE = VOICE_TARGET_SAMPLERATE * VOICE_CHUNK_RECORD_TIME; // opus framesize
 constexpr size_t VOICE_CHANNELS = 1;
+constexpr size_t VOICE_STREAM_BUFFER_TIME = 2; // how many seconds of audio can be queued in a voice stream before samples are dropped
 constexpr int MAX_AUDIO_CHANNELS = 512;
 
 // This class might thread safe ?
@@ -138,9 +139,11 @@ private:
     size_t recordChunkSize = 0;
     std::function<void(const EncodedAudioFrame&)> recordCallback;
     std::function<void(const float*, size_t)> recordRawCallback;
-    AudioSampleQueue recordQueue;
+    AudioSampleQueue recordQueue{VOICE_TARGET_SAMPLERATE};
     unsigned int recordLastPosition = 0;
     EncodedAudioFrame recordFrame;
+    // sequence number of the next encoded opus frame, keeps counting across recordings
+    uint32_t recordSequence = 0;
 
     Result<> startRecordingInternal(bool passive = false);
     void recordContinueStream();
@@ -0,0 +1,115 @@
+#include "mixer.hpp"
+
+#ifdef GLOBED_VOICE_SUPPORT
+
+#include "manager.hpp"
+
+VoiceMixer::~VoiceMixer() {
+    if (sound) {
+        sound->setUserData(nullptr);
+    }
+
+    if (channel) {
+        channel->stop();
+    }
+
+    if (sound) {
+        sound->release();
+    }
+}
+
+void VoiceMixer::addStream(std::shared_ptr<AudioStream> stream) {
+    GLOBED_REQUIRE(stream->isMixed(), "attempting to add a non-mixed stream to the voice mixer")
+
+    streams.lock()->push_back(std::move(stream));
+    this->setPaused(false);
+}
+
+void VoiceMixer::removeStream(const AudioStream* stream) {
+    std::shared_ptr<AudioStream> removed;
+    bool empty;
+
+    {
+        auto s = streams.lock();
+        auto it = std::find_if(s->begin(), s->end(), [&](auto& st) { return st.get() == stream; });
+
+        if (it != s->end()) {
+            // don't destroy it while holding the lock
+            removed = std::move(*it);
+            s->erase(it);
+        }
+
+        empty = s->empty();
+    }
+
+    if (empty) {
+        this->setPaused(true);
+    }
+}
+
+void VoiceMixer::clear() {
+    std::vector<std::shared_ptr<AudioStream>> removed;
+    std::swap(removed, *streams.lock());
+
+    this->setPaused(true);
+}
+
+void VoiceMixer::setPaused(bool state) {
+    // a paused channel stops reading from the sound, so there is no callback mixing silence while nobody is in the mix
+    if (channel) {
+        channel->setPaused(state);
+    }
+}
+
+size_t VoiceMixer::streamCount() {
+    return streams.lock()->size();
+}
+
+void VoiceMixer::mix(float* out, size_t samples) {
+    std::fill_n(out, samples, 0.f);
+
+    // like FMOD mixing separate channels, the output is not clamped here
+    auto s = streams.lock();
+    for (auto& stream : *s) {
+        stream->mixInto(out, samples);
+    }
+}
+
+void VoiceMixer::start() {
+    if (sound) return;
+
+    FMOD_CREATESOUNDEXINFO exinfo = {};
+
+    exinfo.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
+    exinfo.numchannels = 1;
+    exinfo.format = FMOD_SOUND_FORMAT_PCMFLOAT;
+    exinfo.defaultfrequency = VOICE_TARGET_SAMPLERATE;
+    exinfo.userdata = this;
+    exinfo.length = sizeof(float) * exinfo.numchannels * exinfo.defaultfrequency * VOICE_CHUNK_RECORD_TIME;
+    // read a frame at a time, the streams only keep a couple of frames decoded ahead
+    exinfo.decodebuffersize = VOICE_TARGET_FRAMESIZE;
+
+    exinfo.pcmreadcallback = [](FMOD_SOUND* sound_, void* data, unsigned int len) -> FMOD_RESULT {
+        FMOD::Sound* sound = reinterpret_cast<FMOD::Sound*>(sound_);
+        VoiceMixer* mixer = nullptr;
+        sound->getUserData((void**)&mixer);
+
+        if (!mixer || !data) {
+            log::warn("voice mixer is nullptr in cb, ignoring");
+            return FMOD_OK;
+        }
+
+        mixer->mix(reinterpret_cast<float*>(data), len / sizeof(float));
+
+        return FMOD_OK;
+    };
+
+    auto& vm = GlobedAudioManager::get();
+
+    FMOD_RESULT res = vm.getSystem()->createStream(nullptr, FMOD_OPENUSER | FMOD_2D | FMOD_LOOP_NORMAL, &exinfo, &sound);
+    GLOBED_REQUIRE(res == FMOD_OK, GlobedAudioManager::formatFmodError(res, "System::createStream"))
+
+    channel = vm.playSound(sound);
+}
+
+#endif // GLOBED_VOICE_SUPPORT
@@ -0,0 +1,46 @@
+#pragma once
+#include <defs/geode.hpp>
+
+#ifdef GLOBED_VOICE_SUPPORT
+
+#include "stream.hpp"
+
+#include <asp/sync.hpp>
+
+/*
+* VoiceMixer plays the voices of all remote players through a single FMOD stream.
+* Every callback mixes the queues of all mixed `AudioStream`s (with their volume as the gain) into one output buffer,
+* instead of FMOD running a separate stream, channel and callback for every player.
+* The FMOD sound is only created once `start` is called, and its channel is paused whenever there are no streams to mix.
+*/
+class GLOBED_DLL VoiceMixer {
+public:
+    VoiceMixer() = default;
+    ~VoiceMixer();
+
+    VoiceMixer(const VoiceMixer&) = delete;
+    VoiceMixer& operator=(const VoiceMixer&) = delete;
+
+    // add a stream to the mix, it must be created as a mixed stream
+    void addStream(std::shared_ptr<AudioStream> stream);
+    void removeStream(const AudioStream* stream);
+    void clear();
+
+    size_t streamCount();
+
+    // create the FMOD sound and start playing, if not done already
+    void start();
+
+    // mix the next `samples` samples of every stream into `out`, overwriting it. called from the FMOD callback
+    void mix(float* out, size_t samples);
+
+private:
+    FMOD::Sound* sound = nullptr;
+    FMOD::Channel* channel = nullptr;
+    // locked by the FMOD callback for the duration of a mix, and briefly by the main thread when adding or removing streams
+    asp::Mutex<std::vector<std::shared_ptr<AudioStream>>> streams;
+
+    void setPaused(bool state);
+};
+
+#endif // GLOBED_VOICE_SUPPORT
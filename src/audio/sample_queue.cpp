@@ -2,39 +2,115 @@
 
 #ifdef GLOBED_VOICE_SUPPORT
 
-void AudioSampleQueue::writeData(const DecodedOpusData& data) {
-    this->writeData(data.ptr, data.length);
+#include <bit>
+
+AudioSampleQueue::AudioSampleQueue(size_t capacity) {
+    capacity = std::bit_ceil(std::max<size_t>(capacity, 1));
+
+    buf = std::make_unique<float[]>(capacity);
+    mask = capacity - 1;
+}
+
+AudioSampleQueue::AudioSampleQueue(AudioSampleQueue&& other) noexcept {
+    *this = std::move(other);
 }
 
-void AudioSampleQueue::writeData(const float* pcm, size_t length) {
-    buf.insert(buf.end(), pcm, pcm + length);
+AudioSampleQueue& AudioSampleQueue::operator=(AudioSampleQueue&& other) noexcept {
+    if (this != &other) {
+        buf = std::move(other.buf);
+        mask = other.mask;
+        head = other.head.load();
+        tail = other.tail.load();
+        overflowed = other.overflowed.load();
+        underrun = other.underrun.load();
+
+        other.mask = 0;
+        other.head = 0;
+        other.tail = 0;
+    }
+
+    return *this;
+}
+
+size_t AudioSampleQueue::writeData(const DecodedOpusData& data) {
+    return this->writeData(data.ptr, data.length);
+}
+
+size_t AudioSampleQueue::writeData(const float* pcm, size_t length) {
+    if (!buf) return 0;
+
+    size_t h = head.load(std::memory_order::relaxed);
+    size_t t = tail.load(std::memory_order::acquire);
+
+    size_t count = std::min(length, this->capacity() - (h - t));
+    if (count < length) {
+        overflowed.fetch_add(length - count, std::memory_order::relaxed);
+    }
+
+    // copy in up to two parts, if the samples wrap around the end
+    size_t start = h & mask;
+    size_t first = std::min(count, this->capacity() - start);
+    std::copy(pcm, pcm + first, buf.get() + start);
+    std::copy(pcm + first, pcm + count, buf.get());
+
+    head.store(h + count, std::memory_order::release);
+
+    return count;
 }
 
 size_t AudioSampleQueue::copyTo(float* dest, size_t samples) {
-    if (buf.size() < samples) {
-        size_t total = buf.size();
+    size_t t = tail.load(std::memory_order::relaxed);
+    size_t h = head.load(std::memory_order::acquire);
+
+    size_t count = std::min(samples, h - t);
+    if (count < samples) {
+        underrun.fetch_add(samples - count, std::memory_order::relaxed);
+    }
 
-        std::copy(buf.data(), buf.data() + total, dest);
-        buf.clear();
-        return total;
+    if (count > 0) {
+        size_t start = t & mask;
+        size_t first = std::min(count, this->capacity() - start);
+        std::copy(buf.get() + start, buf.get() + start + first, dest);
+        std::copy(buf.get(), buf.get() + (count - first), dest + first);
     }
 
-    std::copy(buf.data(), buf.data() + samples, dest);
-    buf.erase(buf.begin(), buf.begin() + samples);
+    tail.store(t + count, std::memory_order::release);
 
-    return samples;
+    return count;
 }
 
-size_t AudioSampleQueue::size() const {
-    return buf.size();
+size_t AudioSampleQueue::skip(size_t samples) {
+    size_t t = tail.load(std::memory_order::relaxed);
+    size_t h = head.load(std::memory_order::acquire);
+
+    size_t count = std::min(samples, h - t);
+    tail.store(t + count, std::memory_order::release);
+
+    return count;
 }
 
 void AudioSampleQueue::clear() {
-    buf.clear();
+    tail.store(head.load(std::memory_order::acquire), std::memory_order::release);
+}
+
+size_t AudioSampleQueue::size() const {
+    // load the tail first, the head can only grow in the meantime, so this never underflows
+    size_t t = tail.load(std::memory_order::acquire);
+    size_t h = head.load(std::memory_order::acquire);
+
+    return h - t;
+}
+
+size_t AudioSampleQueue::capacity() const {
+    return buf ? mask + 1 : 0;
+}
+
+size_t AudioSampleQueue::overflowCount() const {
+    return overflowed.load(std::memory_order::relaxed);
 }
 
-float* AudioSampleQueue::data() {
-    return buf.data();
+size_t AudioSampleQueue::underrunCount() const {
+    return underrun.load(std::memory_order::relaxed);
 }
 
-#endif // GLOBED_VOICE_SUPPORT
\ No newline at end of file
+#endif // GLOBED_VOICE_SUPPORT
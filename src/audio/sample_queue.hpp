@@ -5,26 +5,87 @@
 
 #include "decoder.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+/*
+* Fixed capacity ring of float samples, lock-free for a single producer and a single consumer.
+* The producer is whoever writes the samples (decoder, recording thread), the consumer is whoever reads them (usually an FMOD callback).
+* `writeData` is the only producer function, everything else (except the counters and `capacity`) must be called by the consumer.
+* Nothing is allocated after construction. Samples that don't fit are dropped and counted as overflow.
+*/
 class AudioSampleQueue {
 public:
-    AudioSampleQueue() {};
-    // enable copying
-    AudioSampleQueue(const AudioSampleQueue&) = default;
-    AudioSampleQueue& operator=(const AudioSampleQueue&) = default;
-    // enable moving
-    AudioSampleQueue(AudioSampleQueue&&) = default;
-    AudioSampleQueue& operator=(AudioSampleQueue&&) = default;
-
-    void writeData(const DecodedOpusData& data);
-    void writeData(const float* pcm, size_t length);
-    // contrary to the name, this will erase the samples from this queue after copying them to `dest`
+    static constexpr size_t DEFAULT_CAPACITY = 32768;
+
+    // capacity is rounded up to a power of two
+    AudioSampleQueue(size_t capacity = DEFAULT_CAPACITY);
+
+    AudioSampleQueue(const AudioSampleQueue&) = delete;
+    AudioSampleQueue& operator=(const AudioSampleQueue&) = delete;
+    // moving is not thread safe, neither queue may be in use at the time
+    AudioSampleQueue(AudioSampleQueue&&) noexcept;
+    AudioSampleQueue& operator=(AudioSampleQueue&&) noexcept;
+
+    // returns how many samples were written, the rest are dropped
+    size_t writeData(const DecodedOpusData& data);
+    size_t writeData(const float* pcm, size_t length);
+
+    // contrary to the name, this will erase the samples from this queue after copying them to `dest`.
+    // if there are less than `samples` available, the difference is counted as an underrun.
     size_t copyTo(float* dest, size_t samples);
-    size_t size() const;
+    // like `copyTo`, but instead of copying, calls `func(const float* pcm, size_t count)` with the samples where they are stored.
+    // `func` is called up to two times, if the samples wrap around the end of the ring.
+    template <typename F>
+    size_t consume(size_t samples, F&& func) {
+        size_t t = tail.load(std::memory_order::relaxed);
+        size_t h = head.load(std::memory_order::acquire);
+
+        size_t count = std::min(samples, h - t);
+        if (count < samples) {
+            underrun.fetch_add(samples - count, std::memory_order::relaxed);
+        }
+
+        if (count > 0) {
+            size_t start = t & mask;
+            size_t first = std::min(count, this->capacity() - start);
+            func(static_cast<const float*>(buf.get() + start), first);
+
+            if (first < count) {
+                func(static_cast<const float*>(buf.get()), count - first);
+            }
+        }
+
+        tail.store(t + count, std::memory_order::release);
+
+        return count;
+    }
+
+    // erase up to `samples` samples without reading them
+    size_t skip(size_t samples);
+    // erase all samples
     void clear();
-    float* data();
+
+    size_t size() const;
+    size_t capacity() const;
+
+    // total amount of samples dropped because the queue was full
+    size_t overflowCount() const;
+    // total amount of samples requested by `copyTo` that were not available
+    size_t underrunCount() const;
 
 private:
-    std::vector<float> buf;
+    std::unique_ptr<float[]> buf;
+    size_t mask = 0;
+
+    // both indices only ever grow (and wrap around), `head - tail` is the amount of stored samples.
+    // kept on separate cache lines, so the producer and the consumer don't fight over them
+    alignas(64) std::atomic_size_t head = 0; // written by the producer
+    alignas(64) std::atomic_size_t tail = 0; // written by the consumer
+
+    std::atomic_size_t overflowed = 0;
+    std::atomic_size_t underrun = 0;
 };
 
 #endif // GLOBED_VOICE_SUPPORT
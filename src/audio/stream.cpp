@@ -7,10 +7,16 @@
 
 using namespace asp::time;
 
-AudioStream::AudioStream(AudioDecoder&& decoder)
-    : decoder(std::move(decoder)),
-      estimator(std::move(VolumeEstimator(VOICE_TARGET_SAMPLERATE))),
+AudioStream::AudioStream(AudioDecoder&& decoder, bool mixed)
+    : queue(VOICE_TARGET_SAMPLERATE * VOICE_STREAM_BUFFER_TIME),
+      decoder(std::move(decoder)),
+      jitterBuffer(VOICE_CHUNK_RECORD_TIME),
+      mixed(mixed),
       lastPlaybackTime(SystemTime::now()) {
+    if (mixed) return;
+
+    estimator.emplace(VOICE_TARGET_SAMPLERATE);
+
     FMOD_CREATESOUNDEXINFO exinfo = {};
 
     exinfo.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
@@ -19,6 +25,8 @@ AudioStream::AudioStream(AudioDecoder&& decoder)
     exinfo.defaultfrequency = VOICE_TARGET_SAMPLERATE;
     exinfo.userdata = this;
     exinfo.length = sizeof(float) * exinfo.numchannels * exinfo.defaultfrequency * (VOICE_CHUNK_RECORD_TIME * 1);
+    // read a frame at a time, the jitter buffer only keeps a couple of frames decoded ahead
+    exinfo.decodebuffersize = VOICE_TARGET_FRAMESIZE;
 
     exinfo.pcmreadcallback = [](FMOD_SOUND* sound_, void* data, unsigned int len) -> FMOD_RESULT {
         FMOD::Sound* sound = reinterpret_cast<FMOD::Sound*>(sound_);
@@ -33,8 +41,8 @@ AudioStream::AudioStream(AudioDecoder&& decoder)
         // write data..
 
         size_t neededSamples = len / sizeof(float);
-        size_t copied = stream->queue.lock()->copyTo(reinterpret_cast<float*>(data), neededSamples);
-        stream->estimator.lock()->feedData(reinterpret_cast<const float*>(data), copied);
+        size_t copied = stream->queue.copyTo(reinterpret_cast<float*>(data), neededSamples);
+        stream->estimator->feedData(reinterpret_cast<const float*>(data), copied);
 
         if (copied != neededSamples) {
             stream->starving = true;
@@ -74,16 +82,18 @@ AudioStream::~AudioStream() {
     }
 }
 
-AudioStream::AudioStream(AudioStream&& other) noexcept {
+AudioStream::AudioStream(AudioStream&& other) noexcept : jitterBuffer(std::move(other.jitterBuffer)) {
+    mixed = other.mixed;
     sound = other.sound;
     channel = other.channel;
     lastPlaybackTime = other.lastPlaybackTime;
     other.sound = nullptr;
     other.channel = nullptr;
 
-    *queue.lock() = std::move(*other.queue.lock());
+    localSequence = other.localSequence;
+    queue = std::move(other.queue);
     decoder = std::move(other.decoder);
-    *estimator.lock() = std::move(*other.estimator.lock());
+    estimator = std::move(other.estimator);
 }
 
 AudioStream& AudioStream::operator=(AudioStream&& other) noexcept {
@@ -96,44 +106,102 @@ AudioStream& AudioStream::operator=(AudioStream&& other) noexcept {
             this->channel->stop();
         }
 
+        this->mixed = other.mixed;
         this->sound = other.sound;
         this->channel = other.channel;
 
         other.sound = nullptr;
         other.channel = nullptr;
 
-        *queue.lock() = std::move(*other.queue.lock());
+        localSequence = other.localSequence;
+        queue = std::move(other.queue);
         decoder = std::move(other.decoder);
-        *estimator.lock() = std::move(*other.estimator.lock());
+        jitterBuffer = std::move(other.jitterBuffer);
+        estimator = std::move(other.estimator);
     }
 
     return *this;
 }
 
 void AudioStream::start() {
-    if (this->channel) {
+    if (this->channel || mixed) {
         return;
     }
 
     this->channel = GlobedAudioManager::get().playSound(sound);
 }
 
-Result<> AudioStream::writeData(const EncodedAudioFrame& frame) {
-    const auto& frames = frame.getFrames();
-    for (const auto& opusFrame : frames) {
-        auto decodedFrame_ = decoder.decode(opusFrame);
-        GLOBED_UNWRAP_INTO(decodedFrame_, auto decodedFrame);
+bool AudioStream::isMixed() const {
+    return mixed;
+}
+
+void AudioStream::mixInto(float* out, size_t samples) {
+    float gain = volume.load(std::memory_order::relaxed);
+    float volumeSum = 0.f;
+    size_t offset = 0;
+
+    // mix straight from the queue, the loudness is calculated in the same pass
+    size_t copied = queue.consume(samples, [&](const float* pcm, size_t count) {
+        volumeSum += util::misc::mixPcm(out + offset, pcm, count, gain) * count;
+        offset += count;
+    });
+
+    mixLoudness.store(samples > 0 ? volumeSum / samples : 0.f, std::memory_order::relaxed);
+
+    if (copied != samples) {
+        starving = true;
+    } else {
+        starving = false;
+        lastPlaybackTime = SystemTime::now();
+    }
+}
+
+void AudioStream::pushFrames(const EncodedAudioFrame& frame, double now) {
+    // without sequence numbers, assume that frames arrive in order and none are lost
+    uint32_t sequence = frame.getSequence().value_or(localSequence);
+    localSequence = sequence + static_cast<uint32_t>(frame.size());
+
+    jitterBuffer.push(sequence, frame.getFrames(), now);
+}
 
-        queue.lock()->writeData(decodedFrame);
+Result<> AudioStream::pump(double now) {
+    constexpr size_t FRAME_SAMPLES = VOICE_TARGET_FRAMESIZE * VOICE_CHANNELS;
 
-        AudioDecoder::freeData(decodedFrame);
+    // decode straight into a stack buffer instead of allocating one for every frame
+    float pcm[FRAME_SAMPLES];
+
+    while (queue.size() < FRAME_SAMPLES * DECODE_AHEAD_FRAMES) {
+        // once the jitter buffer runs dry, the next packet might still make it in time, so only start concealing
+        // when the queue is about to run out as well
+        if (jitterBuffer.isDry() && queue.size() >= FRAME_SAMPLES / 2) {
+            break;
+        }
+
+        auto out = jitterBuffer.pop(now);
+        size_t samples = 0;
+
+        switch (out.action) {
+            case VoiceJitterBuffer::Action::Wait:
+                return Ok();
+            case VoiceJitterBuffer::Action::Play: {
+                GLOBED_UNWRAP_INTO(decoder.decodeInto(out.data, out.length, pcm, FRAME_SAMPLES), samples);
+            } break;
+            case VoiceJitterBuffer::Action::Recover: {
+                GLOBED_UNWRAP_INTO(decoder.decodeInto(out.data, out.length, pcm, FRAME_SAMPLES, true), samples);
+            } break;
+            case VoiceJitterBuffer::Action::Conceal: {
+                GLOBED_UNWRAP_INTO(decoder.decodeInto(nullptr, 0, pcm, FRAME_SAMPLES), samples);
+            } break;
+        }
+
+        queue.writeData(pcm, samples);
     }
 
     return Ok();
 }
 
 void AudioStream::writeData(const float* pcm, size_t samples) {
-    queue.lock()->writeData(pcm, samples);
+    queue.writeData(pcm, samples);
 }
 
 void AudioStream::setVolume(float volume) {
@@ -149,11 +217,14 @@ float AudioStream::getVolume() {
 }
 
 void AudioStream::updateEstimator(float dt) {
-    estimator.lock()->update(dt);
+    if (mixed) return;
+
+    estimator->update(dt);
 }
 
 float AudioStream::getLoudness() {
-    return estimator.lock()->getVolume() * this->volume;
+    float loudness = mixed ? mixLoudness.load(std::memory_order::relaxed) : estimator->getVolume();
+    return loudness * this->volume;
 }
 
 asp::time::SystemTime AudioStream::getLastPlaybackTime() {
@@ -4,17 +4,22 @@
 #ifdef GLOBED_VOICE_SUPPORT
 
 #include "frame.hpp"
+#include "jitter_buffer.hpp"
 #include "sample_queue.hpp"
 #include "decoder.hpp"
 #include "volume_estimator.hpp"
 
+#include <atomic>
+#include <optional>
+
 #include <asp/sync.hpp>
 #include <asp/time/SystemTime.hpp>
 #include <util/time.hpp>
 
 class GLOBED_DLL AudioStream {
 public:
-    AudioStream(AudioDecoder&& decoder);
+    // if `mixed` is true, the stream does not get its own FMOD sound, and has to be played through a `VoiceMixer` instead
+    AudioStream(AudioDecoder&& decoder, bool mixed = false);
     ~AudioStream();
 
     // prevent copying since we manually free the sound
@@ -25,10 +30,16 @@ public:
     AudioStream(AudioStream&& other) noexcept;
     AudioStream& operator=(AudioStream&& other) noexcept;
 
-    // start playing this stream
+    // start playing this stream (does nothing for mixed streams)
     void start();
-    // write an audio frame to this stream. returns error if opus decoding failed
-    Result<> writeData(const EncodedAudioFrame& frame);
+    bool isMixed() const;
+    // mix the next `samples` samples of this stream into `out`, scaled by the volume. used by `VoiceMixer`, on the FMOD thread
+    void mixInto(float* out, size_t samples);
+    // store the opus frames of a received audio frame in the jitter buffer, `now` is the time of arrival in seconds
+    void pushFrames(const EncodedAudioFrame& frame, double now);
+    // decode frames from the jitter buffer until enough audio is queued for playback. returns error if opus decoding failed.
+    // must be called regularly (at least every `VOICE_CHUNK_RECORD_TIME / 2`), from the same thread as `pushFrames`
+    Result<> pump(double now);
     // write raw audio data to this stream
     void writeData(const float* pcm, size_t samples);
 
@@ -46,12 +57,24 @@ public:
     asp::AtomicBool starving = false; // true if there aren't enough samples in the queue
 
 private:
+    // how many frames of audio `pump` keeps decoded ahead of playback, the rest stays in the jitter buffer
+    static constexpr size_t DECODE_AHEAD_FRAMES = 2;
+
     FMOD::Sound* sound = nullptr;
     FMOD::Channel* channel = nullptr;
-    asp::Mutex<AudioSampleQueue> queue;
+    // written by the decoder, read by the FMOD callback, lock-free
+    AudioSampleQueue queue;
     AudioDecoder decoder;
-    asp::Mutex<VolumeEstimator> estimator;
-    float volume = 0.f;
+    // only touched by the decode worker
+    VoiceJitterBuffer jitterBuffer;
+    // used in place of sequence numbers when the server doesn't forward them
+    uint32_t localSequence = 0;
+    // only for streams that play on their own, the loudness of mixed streams is computed by the mixer
+    std::optional<VolumeEstimator> estimator;
+    bool mixed;
+    // loudness of the last mixed chunk
+    std::atomic<float> mixLoudness = 0.f;
+    std::atomic<float> volume = 0.f;
     asp::time::SystemTime lastPlaybackTime;
 };
 
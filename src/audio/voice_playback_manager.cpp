@@ -4,14 +4,134 @@
 
 #ifdef GLOBED_VOICE_SUPPORT
 
-Result<> VoicePlaybackManager::playFrameStreamed(int playerId, const EncodedAudioFrame& frame) {
+#include <globed/tracing.hpp>
+#include <managers/error_queues.hpp>
+#include <managers/settings.hpp>
+
+#include <asp/time/Instant.hpp>
+#include <algorithm>
+
+using namespace asp::time;
+
+VoicePlaybackManager::VoicePlaybackManager() {
+    for (size_t i = 0; i < DECODE_WORKERS; i++) {
+        auto& worker = decodeWorkers[i];
+
+        worker.thread.setStartFunction([i] { geode::utils::thread::setName(fmt::format("Voice Decode Thread {}", i)); });
+        worker.thread.setLoopFunction([&worker](auto&) {
+            if (worker.streams.empty()) {
+                // nothing to play, sleep until someone starts talking
+                receiveFrame(worker, worker.queue.pop());
+            } else if (auto task = worker.queue.popTimeout(PUMP_INTERVAL)) {
+                receiveFrame(worker, task.value());
+            }
+
+            pumpStreams(worker);
+        });
+    }
+}
+
+VoicePlaybackManager::~VoicePlaybackManager() {
+    TRACE("[VoicePlaybackManager] waiting for decode threads to stop");
+    for (auto& worker : decodeWorkers) {
+        if (!worker.started) continue;
+
+        // wake the worker up in case it is waiting for a frame, the empty task is skipped
+        worker.thread.stop();
+        worker.queue.push(DecodeTask {});
+        worker.thread.stopAndWait();
+    }
+    TRACE("[VoicePlaybackManager] decode threads halted");
+}
+
+VoicePlaybackManager::DecodeWorker& VoicePlaybackManager::workerFor(int playerId) {
+    auto& worker = decodeWorkers[static_cast<unsigned int>(playerId) % DECODE_WORKERS];
+
+    if (!worker.started) {
+        worker.started = true;
+        worker.thread.start();
+    }
+
+    return worker;
+}
+
+void VoicePlaybackManager::queueFrameStreamed(int playerId, std::shared_ptr<const EncodedAudioFrame> frame) {
     // if the stream doesn't exist yet, create it
     if (!streams.contains(playerId)) {
         this->prepareStream(playerId);
     }
 
-    auto& stream = streams.at(playerId);
-    return stream->writeData(frame);
+    double arrival = playbackClock();
+
+    if (traceRecording) {
+        this->recordTrace(playerId, *frame, arrival);
+    }
+
+    auto& worker = this->workerFor(playerId);
+    worker.queue.push(DecodeTask {
+        .stream = streams.at(playerId),
+        .frame = std::move(frame),
+        .arrival = arrival,
+    });
+}
+
+void VoicePlaybackManager::setTraceRecording(bool state) {
+    traceRecording = state;
+
+    if (state) {
+        traceFolder = Mod::get()->getSaveDir() / "voice-traces";
+        (void) geode::utils::file::createDirectoryAll(traceFolder);
+    } else {
+        traceFiles.clear();
+    }
+}
+
+void VoicePlaybackManager::recordTrace(int playerId, const EncodedAudioFrame& frame, double arrival) {
+    auto it = traceFiles.find(playerId);
+    if (it == traceFiles.end()) {
+        it = traceFiles.emplace(playerId, std::ofstream(traceFolder / fmt::format("{}.txt", playerId), std::ios::app)).first;
+    }
+
+    auto& fs = it->second;
+    auto sequence = frame.getSequence();
+    fs << fmt::format("{} {} {:.3f}\n", sequence ? static_cast<int64_t>(sequence.value()) : -1, frame.size(), arrival * 1000.0);
+}
+
+void VoicePlaybackManager::receiveFrame(DecodeWorker& worker, const DecodeTask& task) {
+    // if the stream gets removed while we hold it, it will be released on this thread,
+    // that is fine as the audio thread already calls into FMOD off the main thread.
+    auto stream = task.stream.lock();
+    if (!stream) return;
+
+    stream->pushFrames(*task.frame, task.arrival);
+
+    bool known = std::any_of(worker.streams.begin(), worker.streams.end(), [&](auto& s) { return s.lock() == stream; });
+    if (!known) {
+        worker.streams.push_back(stream);
+    }
+}
+
+void VoicePlaybackManager::pumpStreams(DecodeWorker& worker) {
+    double now = playbackClock();
+
+    // forget the streams that were removed
+    std::erase_if(worker.streams, [](auto& s) { return s.expired(); });
+
+    for (auto& weak : worker.streams) {
+        auto stream = weak.lock();
+        if (!stream) continue;
+
+        auto result = stream->pump(now);
+
+        if (result.isErr()) {
+            ErrorQueues::get().debugWarn(std::string("Failed to play a voice frame: ") + result.unwrapErr());
+        }
+    }
+}
+
+double VoicePlaybackManager::playbackClock() {
+    static const Instant epoch = Instant::now();
+    return epoch.elapsed().micros() / 1'000'000.0;
 }
 
 void VoicePlaybackManager::playRawDataStreamed(int playerId, const float* pcm, size_t samples) {
@@ -24,7 +144,9 @@ void VoicePlaybackManager::playRawDataStreamed(int playerId, const float* pcm, s
 }
 
 void VoicePlaybackManager::stopAllStreams() {
+    mixer.clear();
     streams.clear();
+    traceFiles.clear();
 }
 
 void VoicePlaybackManager::prepareStream(int playerId) {
@@ -32,13 +154,29 @@ void VoicePlaybackManager::prepareStream(int playerId) {
 
     AudioDecoder decoder(VOICE_TARGET_SAMPLERATE, VOICE_TARGET_FRAMESIZE, VOICE_CHANNELS);
 
-    auto stream = std::make_unique<AudioStream>(std::move(decoder));
-    stream->start();
+    bool mixed = GlobedSettings::get().communication.voiceMixer;
+
+    auto stream = std::make_shared<AudioStream>(std::move(decoder), mixed);
+    if (mixed) {
+        mixer.addStream(stream);
+        mixer.start();
+    } else {
+        stream->start();
+    }
+
     streams.emplace(playerId, std::move(stream));
 }
 
 void VoicePlaybackManager::removeStream(int playerId) {
-    streams.erase(playerId);
+    auto it = streams.find(playerId);
+    if (it == streams.end()) return;
+
+    if (it->second->isMixed()) {
+        mixer.removeStream(it->second.get());
+    }
+
+    streams.erase(it);
+    traceFiles.erase(playerId);
 }
 
 bool VoicePlaybackManager::isSpeaking(int playerId) {
@@ -109,7 +247,10 @@ void VoicePlaybackManager::forEachStream(std::function<void(int, AudioStream&)>
 
 #else
 
+VoicePlaybackManager::VoicePlaybackManager() {}
+VoicePlaybackManager::~VoicePlaybackManager() {}
 void VoicePlaybackManager::playRawDataStreamed(int playerId, const float* pcm, size_t samples) {}
+void VoicePlaybackManager::setTraceRecording(bool state) {}
 void VoicePlaybackManager::stopAllStreams() {}
 void VoicePlaybackManager::prepareStream(int playerId) {}
 void VoicePlaybackManager::removeStream(int playerId) {}
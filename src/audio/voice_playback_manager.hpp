@@ -2,21 +2,41 @@
 #include <defs/platform.hpp>
 #include <defs/minimal_geode.hpp>
 
+#include "mixer.hpp"
 #include "stream.hpp"
 #include <util/singleton.hpp>
 
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+#include <asp/sync/Channel.hpp>
+#include <asp/thread/Thread.hpp>
 #include <asp/time/SystemTime.hpp>
 
 /*
 * VoicePlaybackManager is responsible for playing voices of multiple people
 * at the same time efficiently and without memory leaks (?).
-* Not thread safe.
+* Not thread safe, except for the decode workers, which only touch the decoder, jitter buffer and sample queue of a stream.
 */
 class GLOBED_DLL VoicePlaybackManager : public SingletonBase<VoicePlaybackManager> {
+protected:
+    VoicePlaybackManager();
+    ~VoicePlaybackManager();
+
+    friend class SingletonBase;
+
 public:
 #ifdef GLOBED_VOICE_SUPPORT
-    Result<> playFrameStreamed(int playerId, const EncodedAudioFrame& frame);
+    // Queue an audio frame to be stored in the jitter buffer of the player's stream. The frame is decoded on a decode worker
+    // once it's time to play it. Frames of one player are always handled by the same worker. Decoding errors are reported to `ErrorQueues`.
+    void queueFrameStreamed(int playerId, std::shared_ptr<const EncodedAudioFrame> frame);
 #endif
+    // When enabled, the arrival of every voice frame is appended to `voice-traces/<player id>.txt` in the save directory,
+    // one `<sequence> <frame count> <arrival time in ms>` line per frame (sequence is -1 if the server didn't send it).
+    // The files are kept open and buffered, so they are only complete once recording is turned off again.
+    // The traces can be replayed through the jitter buffer with the `voiceJitter` benchmark.
+    void setTraceRecording(bool state);
     void playRawDataStreamed(int playerId, const float* pcm, size_t samples);
     void stopAllStreams();
 
@@ -38,6 +58,43 @@ public:
 
 private:
 #ifdef GLOBED_VOICE_SUPPORT
-    std::unordered_map<int, std::unique_ptr<AudioStream>> streams;
+    // opus decoding is too slow for the main thread when many people are talking
+    static constexpr size_t DECODE_WORKERS = 2;
+
+    // how often the workers decode from the jitter buffers when no frames are coming in, as long as they have any streams
+    static constexpr auto PUMP_INTERVAL = asp::time::Duration::fromMillis(20);
+
+    struct DecodeTask {
+        // a stream removed while its frames are still queued is simply skipped
+        std::weak_ptr<AudioStream> stream;
+        std::shared_ptr<const EncodedAudioFrame> frame;
+        double arrival;
+    };
+
+    struct DecodeWorker {
+        asp::Thread<> thread;
+        asp::Channel<DecodeTask> queue;
+        // streams that this worker has received frames for, only touched by the worker thread
+        std::vector<std::weak_ptr<AudioStream>> streams;
+        // the thread is only started once the first frame for it arrives, only touched by the main thread
+        bool started = false;
+    };
+
+    std::unordered_map<int, std::shared_ptr<AudioStream>> streams;
+    // plays all mixed streams, those are created when the voice mixer setting is enabled
+    VoiceMixer mixer;
+    std::array<DecodeWorker, DECODE_WORKERS> decodeWorkers;
+    bool traceRecording = false;
+    std::filesystem::path traceFolder;
+    // kept open while recording, closed once recording stops or the player's stream is removed
+    std::unordered_map<int, std::ofstream> traceFiles;
+
+    DecodeWorker& workerFor(int playerId);
+    static void receiveFrame(DecodeWorker& worker, const DecodeTask& task);
+    static void pumpStreams(DecodeWorker& worker);
+    void recordTrace(int playerId, const EncodedAudioFrame& frame, double arrival);
+
+    // monotonic time in seconds that the jitter buffers work with
+    static double playbackClock();
 #endif
 };
@@ -63,6 +63,8 @@ void VoiceRecordingManager::threadFunc(decltype(thread)::StopToken&) {
                 // so we can't pass it directly in a `VoicePacket` and we use a `RawPacket` instead.
 
                 ByteBuffer buf;
+                // the frame is encoded differently depending on the protocol
+                buf.setProtocol(nm.getServerProtocol());
                 buf.writeValue(frame);
 
                 nm.send(RawPacket::create(
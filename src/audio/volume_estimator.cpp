@@ -5,20 +5,13 @@
 
 #ifdef GLOBED_VOICE_SUPPORT
 
-VolumeEstimator::VolumeEstimator(size_t sampleRate) {
-    this->sampleRate = sampleRate;
-}
+VolumeEstimator::VolumeEstimator(size_t sampleRate) : sampleRate(sampleRate), sampleQueue(static_cast<size_t>(static_cast<float>(sampleRate) * BUFFER_SIZE)) {}
 
-VolumeEstimator::VolumeEstimator() {
-    this->sampleRate = 0;
-}
+VolumeEstimator::VolumeEstimator() : VolumeEstimator(0) {}
 
 void VolumeEstimator::feedData(const float* pcm, size_t samples) {
+    // if the queue is full, the samples are dropped, `update` will catch up
     sampleQueue.writeData(pcm, samples);
-
-    if (sampleQueue.size() > static_cast<float>(sampleRate) * BUFFER_SIZE) {
-        sampleQueue.clear();
-    }
 }
 
 void VolumeEstimator::update(float dt) {
@@ -35,6 +28,12 @@ void VolumeEstimator::update(float dt) {
     float buf[needed];
 #pragma clang diagnostic pop
 
+    // only the latest samples matter, skip anything older in case we fell behind
+    size_t available = sampleQueue.size();
+    if (available > needed) {
+        sampleQueue.skip(available - needed);
+    }
+
     size_t copied = sampleQueue.copyTo(buf, needed);
 
     if (copied < needed) {
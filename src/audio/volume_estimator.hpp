@@ -11,12 +11,10 @@ public:
     VolumeEstimator(size_t sampleRate);
     VolumeEstimator();
 
-    VolumeEstimator(const VolumeEstimator&) = default;
-    VolumeEstimator& operator=(const VolumeEstimator&) = default;
-
     VolumeEstimator(VolumeEstimator&&) = default;
     VolumeEstimator& operator=(VolumeEstimator&&) = default;
 
+    // may be called from a different thread than the other functions (e.g. an FMOD callback)
     void feedData(const float* pcm, size_t samples);
 
     void update(float dt);
@@ -26,7 +24,7 @@ public:
 private:
     static constexpr float BUFFER_SIZE = 1.0f;
 
-    float volume;
+    float volume = 0.f;
     size_t sampleRate;
     AudioSampleQueue sampleQueue;
 };
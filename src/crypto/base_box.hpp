@@ -98,6 +98,7 @@ public:
     /* Decryption */
 
     // Decrypt `size` bytes from `data` into itself. Returns the length of the plaintext data.
+    // This moves the plaintext to the start of `data`, `CryptoBox::decryptMessage` avoids that on the hot path.
     Result<size_t> decryptInPlace(byte* data, size_t size) {
         // overwriting nonce causes decryption to break
         // so we offset the destination by NONCE_LEN and then move it back
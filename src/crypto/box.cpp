@@ -1,6 +1,7 @@
 #include "box.hpp"
 
 #include <cstring> // std::memcpy
+#include <limits>
 #include <sodium.h>
 
 #include <util/crypto.hpp>
@@ -31,7 +32,9 @@ constexpr size_t SHARED_KEY_LEN = CRYPTO_JOIN(BEFORENMBYTES);
 constexpr auto func_box_keypair = CRYPTO_JOIN(keypair);
 constexpr auto func_box_beforenm = CRYPTO_JOIN(beforenm);
 constexpr auto func_box_easy = CRYPTO_JOIN(easy_afternm);
+constexpr auto func_box_detached = CRYPTO_JOIN(detached_afternm);
 constexpr auto func_box_open_easy = CRYPTO_JOIN(open_easy_afternm);
+constexpr auto func_box_open_detached = CRYPTO_JOIN(open_detached_afternm);
 
 constexpr static size_t PREFIX_LEN = NONCE_LEN + MAC_LEN;
 
@@ -102,6 +105,27 @@ Result<size_t> CryptoBox::encryptInto(const byte* src, byte* dest, size_t size)
     return Ok(size + PREFIX_LEN);
 }
 
+Result<> CryptoBox::encryptDetached(byte* prefix, byte* data, size_t size) {
+    byte* nonce = prefix;
+    byte* mac = prefix + NONCE_LEN;
+
+    util::crypto::secureRandom(nonce, NONCE_LEN);
+
+    // the combined format is just the mac followed by the ciphertext, so the server can't tell the difference
+    CRYPTO_ERR_CHECK_SAFE(func_box_detached(data, mac, data, size, nonce, sharedKey), "func_box_detached failed")
+
+    return Ok();
+}
+
+Result<> CryptoBox::decryptDetached(const byte* prefix, byte* data, size_t size) {
+    const byte* nonce = prefix;
+    const byte* mac = prefix + NONCE_LEN;
+
+    CRYPTO_ERR_CHECK_SAFE(func_box_open_detached(data, data, mac, size, nonce, sharedKey), "func_box_open_detached failed")
+
+    return Ok();
+}
+
 Result<size_t> CryptoBox::decryptInto(const util::data::byte* src, util::data::byte* dest, size_t size) {
     CRYPTO_REQUIRE_SAFE(size >= PREFIX_LEN, "message is too short")
 
@@ -116,6 +140,148 @@ Result<size_t> CryptoBox::decryptInto(const util::data::byte* src, util::data::b
     return Ok(plaintextLength);
 }
 
+/* Session messages */
+
+static_assert(CryptoBox::REPLAY_WINDOW == sizeof(uint64_t) * 8, "the replay window is a single 64-bit mask");
+
+void CryptoBox::setNonceMode(NonceMode mode, bool initiator) {
+    this->nonceMode = mode;
+    this->initiator = initiator;
+
+    tcpStream = 0;
+    sendCounter[0] = 0;
+    sendCounter[1] = 0;
+    recvCounterTcp = 0;
+    recvWindowUdp = ReplayWindow{};
+}
+
+void CryptoBox::startTcpStream() {
+    tcpStream++;
+    sendCounter[0] = 0;
+    recvCounterTcp = 0;
+}
+
+CryptoBox::NonceMode CryptoBox::getNonceMode() const {
+    return nonceMode;
+}
+
+size_t CryptoBox::messagePrefixLength(bool tcp) const {
+    if (nonceMode == NonceMode::Random) {
+        return PREFIX_LEN;
+    }
+
+    return (tcp ? 0 : COUNTER_LEN) + MAC_LEN;
+}
+
+// nonce layout: direction (1 byte), channel (1 byte), big endian tcp stream (4 bytes, 0 for udp), zeroes, big endian counter (8 bytes)
+void CryptoBox::makeCounterNonce(byte* nonce, uint64_t counter, bool tcp, bool sending) const {
+    std::memset(nonce, 0, NONCE_LEN);
+
+    nonce[0] = (sending == initiator) ? 0 : 1;
+    nonce[1] = tcp ? 0 : 1;
+
+    if (tcp) {
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            nonce[2 + i] = static_cast<byte>(tcpStream >> ((sizeof(uint32_t) - 1 - i) * 8));
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        nonce[NONCE_LEN - 1 - i] = static_cast<byte>(counter >> (i * 8));
+    }
+}
+
+Result<> CryptoBox::encryptMessage(byte* prefix, byte* data, size_t size, bool tcp) {
+    if (nonceMode == NonceMode::Random) {
+        return this->encryptDetached(prefix, data, size);
+    }
+
+    uint64_t& counter = sendCounter[tcp ? 0 : 1];
+    CRYPTO_REQUIRE_SAFE(counter != std::numeric_limits<uint64_t>::max(), "message counter exhausted")
+
+    byte nonce[NONCE_LEN];
+    this->makeCounterNonce(nonce, counter, tcp, true);
+
+    byte* mac = prefix;
+
+    if (!tcp) {
+        for (size_t i = 0; i < COUNTER_LEN; i++) {
+            prefix[i] = nonce[NONCE_LEN - COUNTER_LEN + i];
+        }
+
+        mac += COUNTER_LEN;
+    }
+
+    CRYPTO_ERR_CHECK_SAFE(func_box_detached(data, mac, data, size, nonce, sharedKey), "func_box_detached failed")
+
+    counter++;
+
+    return Ok();
+}
+
+Result<std::span<byte>> CryptoBox::decryptMessage(byte* data, size_t size, bool tcp) {
+    size_t prefixLength = this->messagePrefixLength(tcp);
+    CRYPTO_REQUIRE_SAFE(size >= prefixLength, "message is too short")
+
+    byte* ciphertext = data + prefixLength;
+    size_t plaintextLength = size - prefixLength;
+
+    if (nonceMode == NonceMode::Random) {
+        GLOBED_UNWRAP(this->decryptDetached(data, ciphertext, plaintextLength));
+        return Ok(std::span(ciphertext, plaintextLength));
+    }
+
+    uint64_t counter = 0;
+
+    if (tcp) {
+        counter = recvCounterTcp;
+    } else {
+        for (size_t i = 0; i < COUNTER_LEN; i++) {
+            counter = (counter << 8) | data[i];
+        }
+
+        CRYPTO_REQUIRE_SAFE(recvWindowUdp.check(counter), "replayed or outdated message")
+    }
+
+    byte nonce[NONCE_LEN];
+    this->makeCounterNonce(nonce, counter, tcp, false);
+
+    const byte* mac = data + prefixLength - MAC_LEN;
+
+    CRYPTO_ERR_CHECK_SAFE(func_box_open_detached(ciphertext, ciphertext, mac, plaintextLength, nonce, sharedKey), "func_box_open_detached failed")
+
+    // only advance once the message is known to be authentic, so forged messages can't desync the counters
+    if (tcp) {
+        recvCounterTcp++;
+    } else {
+        recvWindowUdp.accept(counter);
+    }
+
+    return Ok(std::span(ciphertext, plaintextLength));
+}
+
+bool CryptoBox::ReplayWindow::check(uint64_t counter) const {
+    if (counter >= next) {
+        return true;
+    }
+
+    uint64_t age = next - 1 - counter;
+
+    return age < REPLAY_WINDOW && !(seen & (1ull << age));
+}
+
+void CryptoBox::ReplayWindow::accept(uint64_t counter) {
+    if (counter >= next) {
+        uint64_t shift = counter - next + 1;
+
+        seen = shift >= REPLAY_WINDOW ? 0 : (seen << shift);
+        seen |= 1;
+        next = counter + 1;
+    } else {
+        seen |= 1ull << (next - 1 - counter);
+    }
+}
+
 const char* CryptoBox::algorithm() {
     return ALGORITHM;
 }
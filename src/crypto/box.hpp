@@ -1,10 +1,27 @@
 #pragma once
 #include "base_box.hpp"
 
+#include <span>
+
 class CryptoBox final : public BaseCryptoBox<CryptoBox> {
 public:
     using BaseCryptoBox<CryptoBox>::PREFIX_LEN;
 
+    // How the nonces of messages are chosen. Negotiated during the crypto handshake, `Random` until then.
+    enum class NonceMode : uint8_t {
+        // A random nonce is sent along with every message
+        Random = 0,
+        // Nonces are derived from a message counter, separate for each direction and channel.
+        // UDP messages carry just the counter, TCP messages carry nothing because they arrive in order anyway.
+        Counter = 1,
+    };
+
+    // Size of the counter sent with UDP messages in the `Counter` mode
+    constexpr static size_t COUNTER_LEN = sizeof(uint64_t);
+
+    // Amount of recent UDP counters that are remembered, older messages are rejected
+    constexpr static size_t REPLAY_WINDOW = 64;
+
     static const char* algorithm();
     static const char* sodiumVersion();
 
@@ -31,6 +48,35 @@ public:
     Result<size_t> encryptInto(const util::data::byte* src, util::data::byte* dest, size_t size);
     Result<size_t> decryptInto(const util::data::byte* src, util::data::byte* dest, size_t size);
 
+    // Encrypt `size` bytes of `data` in place, writing the nonce and the MAC into `prefix` (must be `PREFIX_LEN` bytes big).
+    // If `prefix` is placed right before `data`, the output is identical to `encryptInto`, without moving any data.
+    Result<> encryptDetached(util::data::byte* prefix, util::data::byte* data, size_t size);
+
+    // Decrypt `size` bytes of `data` in place, reading the nonce and the MAC from `prefix`. The counterpart of `encryptDetached`,
+    // with `prefix` placed right before `data` it accepts the output of `encryptInto`, and the plaintext stays where the ciphertext was.
+    Result<> decryptDetached(const util::data::byte* prefix, util::data::byte* data, size_t size);
+
+    /* Session messages */
+
+    // Switch to `mode` and reset all message counters. `initiator` is true on the side that started the handshake,
+    // so the two directions never derive the same nonce.
+    void setNonceMode(NonceMode mode, bool initiator = true);
+    NonceMode getNonceMode() const;
+
+    // Must be called on both sides when the session continues over a new TCP connection (i.e. after recovering it).
+    // Restarts the TCP counters, with nonces that can't collide with the ones used on the previous connection.
+    void startTcpStream();
+
+    // Bytes that precede the ciphertext of a message sent over the given channel in the current mode. At most `PREFIX_LEN`.
+    size_t messagePrefixLength(bool tcp) const;
+
+    // Encrypt `size` bytes of `data` in place, writing whatever precedes the ciphertext into `prefix` (must be `messagePrefixLength(tcp)` bytes big).
+    Result<> encryptMessage(util::data::byte* prefix, util::data::byte* data, size_t size, bool tcp);
+
+    // Decrypt a message of `size` bytes in place. The plaintext is not moved, the returned span points at it right after the prefix.
+    // In the `Counter` mode, UDP messages that were already received or are too old to tell are rejected.
+    Result<std::span<util::data::byte>> decryptMessage(util::data::byte* data, size_t size, bool tcp);
+
 private: // nuh uh
     util::data::byte* memBasePtr = nullptr;
 
@@ -39,4 +85,27 @@ private: // nuh uh
     util::data::byte* peerPublicKey;
 
     util::data::byte* sharedKey;
+
+    // Sliding window over the most recent UDP counters
+    class ReplayWindow {
+    public:
+        // Whether `counter` has not been seen yet and is not too old
+        bool check(uint64_t counter) const;
+        // Mark `counter` as seen, must only be called after the message was authenticated
+        void accept(uint64_t counter);
+
+    private:
+        uint64_t next = 0;   // one past the highest accepted counter
+        uint64_t seen = 0;   // bit N is set if `next - 1 - N` was accepted
+    };
+
+    NonceMode nonceMode = NonceMode::Random;
+    bool initiator = true;
+    uint32_t tcpStream = 0;
+    uint64_t sendCounter[2] = {0, 0}; // tcp, udp
+    uint64_t recvCounterTcp = 0;
+    ReplayWindow recvWindowUdp;
+
+    // Nonce of a message in the `Counter` mode
+    void makeCounterNonce(util::data::byte* nonce, uint64_t counter, bool tcp, bool sending) const;
 };
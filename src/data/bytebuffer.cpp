@@ -3,14 +3,14 @@
 #include <boost/describe.hpp>
 
 template <typename T = void>
-using DecodeResult = ByteBuffer::DecodeResult<T>;
-using DecodeError = ByteBuffer::DecodeError;
+using DecodeResult = ByteReader::DecodeResult<T>;
+using DecodeError = ByteReader::DecodeError;
 
 using namespace util::data;
 using namespace cocos2d;
 
-const char* ByteBuffer::strerror(DecodeError err) {
-    using Error = ByteBuffer::DecodeError;
+const char* ByteReader::strerror(DecodeError err) {
+    using Error = ByteReader::DecodeError;
 
     switch (err) {
         case Error::Ok: return "No error";
@@ -23,14 +23,141 @@ const char* ByteBuffer::strerror(DecodeError err) {
     return "Unknown error";
 }
 
+/* ByteReader */
+
+ByteReader::ByteReader() {}
+
+ByteReader::ByteReader(std::span<const byte> data) : _view(data) {}
+ByteReader::ByteReader(const byte* data, size_t length) : _view(data, length) {}
+
+DecodeResult<> ByteReader::boundsCheck(size_t count) {
+    if (_position + count > _view.size()) {
+        return Err(DecodeError::NotEnoughData);
+    }
+
+    return Ok();
+}
+
+std::span<const byte> ByteReader::span() const {
+    return _view;
+}
+
+size_t ByteReader::size() const {
+    return _view.size();
+}
+
+size_t ByteReader::getPosition() const {
+    return _position;
+};
+
+void ByteReader::setPosition(size_t pos) {
+    _position = pos;
+}
+
+DecodeResult<> ByteReader::skip(size_t bytes) {
+    GLOBED_UNWRAP(this->boundsCheck(bytes));
+    _position += bytes;
+
+    return Ok();
+}
+
+DecodeResult<> ByteReader::readBytesInto(byte* buf, size_t bytes) {
+    GLOBED_UNWRAP(this->boundsCheck(bytes));
+    std::memcpy(buf, _view.data() + _position, bytes);
+    _position += bytes;
+
+    return Ok();
+}
+
+void ByteReader::setBorrowing(bool state) {
+    _borrowing = state;
+}
+
+bool ByteReader::isBorrowing() const {
+    return _borrowing;
+}
+
+DecodeResult<std::span<const byte>> ByteReader::readBytesView(size_t bytes) {
+    GLOBED_UNWRAP(this->boundsCheck(bytes));
+
+    std::span<const byte> view(_view.data() + _position, bytes);
+    _position += bytes;
+    _borrowedReads++;
+
+    return Ok(view);
+}
+
+size_t ByteReader::getBorrowedReads() const {
+    return _borrowedReads;
+}
+
+void ByteReader::setProtocol(uint16_t protocol) {
+    _protocol = protocol;
+}
+
+uint16_t ByteReader::getProtocol() const {
+    return _protocol;
+}
+
+void ByteReader::setPositionOrigin(const CCPoint& origin) {
+    _positionOrigin = origin;
+}
+
+CCPoint ByteReader::getPositionOrigin() const {
+    return _positionOrigin;
+}
+
+/* ByteBuffer */
+
 ByteBuffer::ByteBuffer() {}
 
-ByteBuffer::ByteBuffer(const bytevector& data) : _data(data) {}
+ByteBuffer::ByteBuffer(const bytevector& data) : _data(data) {
+    this->syncView();
+}
+
 ByteBuffer::ByteBuffer(const byte* data, size_t length)
-    : _data(bytevector(data, data + length)) {}
+    : _data(bytevector(data, data + length)) {
+    this->syncView();
+}
 
 ByteBuffer::ByteBuffer(bytevector&& data)
-    : _data(std::move(data)) {}
+    : _data(std::move(data)) {
+    this->syncView();
+}
+
+ByteBuffer::ByteBuffer(const ByteBuffer& other) : ByteReader(other), _data(other._data) {
+    this->syncView();
+}
+
+ByteBuffer& ByteBuffer::operator=(const ByteBuffer& other) {
+    if (this != &other) {
+        ByteReader::operator=(other);
+        _data = other._data;
+        this->syncView();
+    }
+
+    return *this;
+}
+
+ByteBuffer::ByteBuffer(ByteBuffer&& other) noexcept : ByteReader(other), _data(std::move(other._data)) {
+    this->syncView();
+    other.syncView();
+}
+
+ByteBuffer& ByteBuffer::operator=(ByteBuffer&& other) noexcept {
+    if (this != &other) {
+        ByteReader::operator=(other);
+        _data = std::move(other._data);
+        this->syncView();
+        other.syncView();
+    }
+
+    return *this;
+}
+
+void ByteBuffer::syncView() {
+    _view = std::span<const byte>(_data.data(), _data.size());
+}
 
 void ByteBuffer::rawWriteBytes(const byte* bytes, size_t length) {
     // if we can't fit (i.e. writing at the end, just use insert)
@@ -38,24 +165,15 @@ void ByteBuffer::rawWriteBytes(const byte* bytes, size_t length) {
         _data.insert(_data.begin() + _position, bytes, bytes + length);
         // remove leftover elements
         _data.reserve(_position + length);
+        this->syncView();
     } else {
         // otherwise, overwrite existing elements
-        for (size_t i = 0; i < length; i++) {
-            _data.data()[_position + i] = bytes[i];
-        }
+        std::memcpy(_data.data() + _position, bytes, length);
     }
 
     _position += length;
 }
 
-DecodeResult<> ByteBuffer::boundsCheck(size_t count) {
-    if (_position + count > _data.size()) {
-        return Err(DecodeError::NotEnoughData);
-    }
-
-    return Ok();
-}
-
 /* Util methods */
 
 const bytevector& ByteBuffer::data() const {
@@ -69,22 +187,12 @@ bytevector& ByteBuffer::data() {
 void ByteBuffer::clear() {
     _data.clear();
     _position = 0;
-}
-
-size_t ByteBuffer::size() const {
-    return _data.size();
-}
-
-size_t ByteBuffer::getPosition() const {
-    return _position;
-};
-
-void ByteBuffer::setPosition(size_t pos) {
-    _position = pos;
+    this->syncView();
 }
 
 void ByteBuffer::resize(size_t newSize) {
     _data.resize(newSize);
+    this->syncView();
 }
 
 void ByteBuffer::grow(size_t bytes) {
@@ -95,19 +203,9 @@ void ByteBuffer::shrink(size_t bytes) {
     this->resize(this->size() - bytes);
 }
 
-DecodeResult<> ByteBuffer::skip(size_t bytes) {
-    GLOBED_UNWRAP(this->boundsCheck(bytes));
-    _position += bytes;
-
-    return Ok();
-}
-
-DecodeResult<> ByteBuffer::readBytesInto(byte* buf, size_t bytes) {
-    GLOBED_UNWRAP(this->boundsCheck(bytes));
-    std::memcpy(buf, _data.data() + _position, bytes);
-    _position += bytes;
-
-    return Ok();
+void ByteBuffer::reserve(size_t bytes) {
+    _data.reserve(_data.size() + bytes);
+    this->syncView();
 }
 
 void ByteBuffer::writeBytes(void* buf, size_t bytes) {
@@ -127,12 +225,12 @@ template<> void ByteBuffer::customEncode(const std::string& value) {
     this->customEncode(std::string_view(value));
 }
 
-template<> DecodeResult<std::string> ByteBuffer::customDecode() {
+template<> DecodeResult<std::string> ByteReader::customDecode() {
     GLOBED_UNWRAP_INTO(this->readLength(), size_t length);
 
     GLOBED_UNWRAP(this->boundsCheck(length));
 
-    std::string str(reinterpret_cast<const char*>(_data.data() + _position), length);
+    std::string str(reinterpret_cast<const char*>(_view.data() + _position), length);
     _position += length;
 
     return Ok(std::move(str));
@@ -145,7 +243,7 @@ template<> void ByteBuffer::customEncode(const CCPoint& point) {
     this->writeF32(point.y);
 }
 
-template<> DecodeResult<CCPoint> ByteBuffer::customDecode() {
+template<> DecodeResult<CCPoint> ByteReader::customDecode() {
     GLOBED_UNWRAP_INTO(this->readF32(), float x);
     GLOBED_UNWRAP_INTO(this->readF32(), float y);
 
@@ -159,7 +257,7 @@ template<> void ByteBuffer::customEncode(const CCSize& size) {
     this->writeF32(size.height);
 }
 
-template<> DecodeResult<CCSize> ByteBuffer::customDecode() {
+template<> DecodeResult<CCSize> ByteReader::customDecode() {
     GLOBED_UNWRAP_INTO(this->readF32(), float w);
     GLOBED_UNWRAP_INTO(this->readF32(), float h);
 
@@ -174,7 +272,7 @@ template<> void ByteBuffer::customEncode(const ccColor3B& color) {
     this->writeU8(color.b);
 }
 
-template<> DecodeResult<ccColor3B> ByteBuffer::customDecode() {
+template<> DecodeResult<ccColor3B> ByteReader::customDecode() {
     GLOBED_UNWRAP_INTO(this->readU8(), uint8_t r);
     GLOBED_UNWRAP_INTO(this->readU8(), uint8_t g);
     GLOBED_UNWRAP_INTO(this->readU8(), uint8_t b);
@@ -191,7 +289,7 @@ template<> void ByteBuffer::customEncode(const ccColor4B& color) {
     this->writeU8(color.a);
 }
 
-template<> DecodeResult<ccColor4B> ByteBuffer::customDecode() {
+template<> DecodeResult<ccColor4B> ByteReader::customDecode() {
     GLOBED_UNWRAP_INTO(this->readU8(), uint8_t r);
     GLOBED_UNWRAP_INTO(this->readU8(), uint8_t g);
     GLOBED_UNWRAP_INTO(this->readU8(), uint8_t b);
@@ -206,11 +304,9 @@ template<> DecodeResult<ccColor4B> ByteBuffer::customDecode() {
         this->rawWriteBytes(data.data(), sz); \
     } \
     \
-    template<> DecodeResult<bytearray<sz>> ByteBuffer::customDecode() { \
+    template<> DecodeResult<bytearray<sz>> ByteReader::customDecode() { \
         bytearray<sz> out; \
-        for (size_t i = 0; i < sz; i++) { \
-            GLOBED_UNWRAP_INTO(this->readU8(), out[i]); \
-        } \
+        GLOBED_UNWRAP(this->readBytesInto(out.data(), sz)); \
         return Ok(out); \
     }
 
@@ -220,7 +316,7 @@ MAKE_ARRAY_FUNCS(32)
 /* Boring ass methods */
 
 #define MAKE_METHOD(type, name) \
-    DecodeResult<type> ByteBuffer::read##name() { return this->readPrimitive<type>(); } \
+    DecodeResult<type> ByteReader::read##name() { return this->readPrimitive<type>(); } \
     void ByteBuffer::write##name(type value) { this->writePrimitive<type>(value); }
 
 MAKE_METHOD(bool, Bool);
@@ -235,7 +331,7 @@ MAKE_METHOD(uint64_t, U64);
 MAKE_METHOD(float, F32);
 MAKE_METHOD(double, F64);
 
-DecodeResult<size_t> ByteBuffer::readLength() {
+DecodeResult<size_t> ByteReader::readLength() {
     auto v = this->readPrimitive<length_t>();
     if (v.isOk()) {
         return Ok(static_cast<size_t>(v.unwrap()));
@@ -244,7 +340,7 @@ DecodeResult<size_t> ByteBuffer::readLength() {
     }
 }
 
-DecodeResult<size_t> ByteBuffer::readLengthCheck(size_t elemsize) {
+DecodeResult<size_t> ByteReader::readLengthCheck(size_t elemsize) {
     GLOBED_UNWRAP_INTO(this->readLength(), auto len);
 
     if (this->getPosition() + (len * elemsize) > this->size()) {
@@ -2,6 +2,8 @@
 #include <defs/assert.hpp>
 #include <defs/minimal_geode.hpp>
 
+#include <limits>
+#include <span>
 #include <type_traits>
 #include <fmt/format.h>
 #include <asp/data/util.hpp>
@@ -14,7 +16,11 @@
 #include <util/data.hpp>
 #include <util/misc.hpp>
 
-class ByteBuffer {
+// Non-owning, read-only view over encoded data. Decoding works exactly like with a `ByteBuffer`,
+// but the data is read where it already is, so nothing has to be copied before decoding it.
+// The underlying memory must outlive the reader (and any values borrowed from it).
+class ByteReader {
+protected:
     using length_t = uint16_t;
 
 public:
@@ -34,23 +40,17 @@ public:
 
     static const char* strerror(DecodeError err);
 
-    // Constructs a `ByteBuffer` with no data
-    ByteBuffer();
-
-    // Construct a `ByteBuffer` with some data
-    ByteBuffer(const util::data::bytevector& data);
-    ByteBuffer(const util::data::byte* data, size_t length);
-
-    // Take ownership of the given `bytevector` and construct a `ByteBuffer` from the data
-    ByteBuffer(util::data::bytevector&& data);
+    // Constructs a `ByteReader` with no data
+    ByteReader();
 
-    ByteBuffer(const ByteBuffer& other) = default;
-    ByteBuffer& operator=(const ByteBuffer& other) = default;
+    // Construct a `ByteReader` over the given data, the data is not copied
+    ByteReader(std::span<const util::data::byte> data);
+    ByteReader(const util::data::byte* data, size_t length);
 
-    ByteBuffer(ByteBuffer&& other) = default;
-    ByteBuffer& operator=(ByteBuffer&& other) = default;
+    ByteReader(const ByteReader& other) = default;
+    ByteReader& operator=(const ByteReader& other) = default;
 
-    // Read a value from this bytebuffer
+    // Read a value from this reader
     template <typename T>
     DecodeResult<T> readValue() {
         if constexpr (util::data::IsPrimitive<T>) {
@@ -70,67 +70,31 @@ public:
         }
     }
 
-    // Write a value to this bytebuffer
-    template <typename T>
-    void writeValue(const T& value) {
-        if constexpr (util::data::IsPrimitive<T>) {
-            this->writePrimitive<T>(value);
-        } else if constexpr (std::is_enum_v<T>) {
-            this->writeEnum<T>(value);
-        } else if constexpr (std::is_empty_v<T>) {
-            // zst, do nothing
-        } else if constexpr (boost::describe::has_describe_members<T>::value) {
-            this->reflectionEncode<T>(value);
-        } else {
-            // use custom encoder
-            this->preCustomEncode<T>(value);
-        }
-    }
-
     // Read a commonly encodable type. Can be specialized for any type to enable decoding ability.
     template <typename T>
     DecodeResult<T> customDecode();
 
-    // Write a commonly encodable type. Can be specialized for any type to enable encoding ability.
-    template <typename T>
-    void customEncode(const T& value);
-
     /* Various helper methods */
 
-    // Get the underlying data buffer of this `ByteBuffer`
-    const util::data::bytevector& data() const;
-
-    // Get the underlying data buffer of this `ByteBuffer`
-    util::data::bytevector& data();
-
-    // Clear all the data in this buffer
-    void clear();
+    // Get the data this reader reads from
+    std::span<const util::data::byte> span() const;
 
-    // Get the amount of data in this `ByteBuffer`
+    // Get the amount of data in this reader
     size_t size() const;
 
-    // Get the current position of this buffer
+    // Get the current position of this reader
     size_t getPosition() const;
 
-    // Set the position of this buffer
+    // Set the position of this reader
     void setPosition(size_t pos);
 
-    // Resize the internal buffer to `newSize` bytes
-    void resize(size_t newSize);
-
-    // Equivalent to `resize(size() + bytes)`
-    void grow(size_t bytes);
-
-    // Equivalent to `resize(size() - bytes)`
-    void shrink(size_t bytes);
-
     // Skips the next `bytes` bytes. Returns an error if there aren't enough bytes to skip.
     DecodeResult<> skip(size_t bytes);
 
-    // Returns an error if `count` bytes cannot be read from this `ByteBuffer`
+    // Returns an error if `count` bytes cannot be read from this reader
     DecodeResult<> boundsCheck(size_t count);
 
-    /* Helper methods for reading/writing a specific integer type */
+    /* Helper methods for reading a specific integer type */
 
     DecodeResult<bool> readBool();
     DecodeResult<uint8_t> readU8();
@@ -148,25 +112,7 @@ public:
     // read a length `x`, return an error if unable to read at least `x` bytes from the buffer afterwards
     DecodeResult<size_t> readLengthCheck(size_t elemsize = 1);
 
-    void writeBool(bool value);
-    void writeU8(uint8_t value);
-    void writeU16(uint16_t value);
-    void writeU32(uint32_t value);
-    void writeU64(uint64_t value);
-    void writeI8(int8_t value);
-    void writeI16(int16_t value);
-    void writeI32(int32_t value);
-    void writeI64(int64_t value);
-    void writeF32(float value);
-    void writeF64(double value);
-    void writeLength(size_t value);
-
     /* Bits */
-    template <size_t N>
-    void writeBits(const BitBuffer<N>& bits) {
-        this->writePrimitive(bits.contents());
-    }
-
     template <size_t N>
     DecodeResult<BitBuffer<N>> readBits() {
         GLOBED_UNWRAP_INTO(this->readPrimitive<BitBufferUnderlyingType<N>>(), auto underlying);
@@ -176,8 +122,29 @@ public:
     /* Raw reads */
     DecodeResult<> readBytesInto(util::data::byte* buf, size_t bytes);
 
-    /* Raw write */
-    void writeBytes(void* buf, size_t bytes);
+    /* Borrowed reads */
+
+    // When enabled, decoders that support it return views into this buffer instead of copying the data.
+    // Only enable this when the underlying storage is guaranteed to outlive the decoded values.
+    void setBorrowing(bool state);
+    bool isBorrowing() const;
+
+    // Returns a view over the next `bytes` bytes and advances the position
+    DecodeResult<std::span<const util::data::byte>> readBytesView(size_t bytes);
+
+    // Returns how many reads were served by `readBytesView` instead of copying
+    size_t getBorrowedReads() const;
+
+    /* Protocol */
+
+    // Protocol version of the connection the data is sent over, 0 if unknown.
+    // Lets types pick a more compact wire format when the other side supports it.
+    void setProtocol(uint16_t protocol);
+    uint16_t getProtocol() const;
+
+    // Origin that positions in the compact format are relative to, see `PositionOrigin`
+    void setPositionOrigin(const cocos2d::CCPoint& origin);
+    cocos2d::CCPoint getPositionOrigin() const;
 
 protected:
     // Read `sizeof(T)` bytes and reinterpret them as `T`. No endianness conversions are done.
@@ -186,23 +153,12 @@ protected:
         GLOBED_UNWRAP(this->boundsCheck(sizeof(T)));
 
         T value;
-        std::memcpy(&value, _data.data() + _position, sizeof(T));
+        std::memcpy(&value, _view.data() + _position, sizeof(T));
         _position += sizeof(T);
 
         return Ok(value);
     }
 
-    // Write the bits of `value` into this `ByteBuffer`. No endianness conversions are done
-    template <typename T>
-    void rawWrite(T value) {
-        const util::data::byte* bytes = reinterpret_cast<const util::data::byte*>(&value);
-
-        this->rawWriteBytes(bytes, sizeof(T));
-    }
-
-    // Like `rawWrite` but accepts a raw buffer
-    void rawWriteBytes(const util::data::byte* bytes, size_t length);
-
     // Read a primitive `T`, performing endianness conversions
     template <typename T>
     DecodeResult<T> readPrimitive() {
@@ -214,16 +170,6 @@ protected:
         return Ok(value);
     }
 
-    // Write a primitive `T`, performing endianness conversions
-    template <typename T>
-    void writePrimitive(T value) {
-        static_assert(util::data::IsPrimitive<T>, "Type passed to writePrimitive must be a primitive");
-
-        value = util::data::maybeByteswap(value);
-
-        this->rawWrite<T>(value);
-    }
-
     // Read an enum
     template <typename E>
     DecodeResult<E> readEnum() {
@@ -255,18 +201,6 @@ protected:
         return Ok(static_cast<E>(underlying));
     }
 
-    // Write an enum
-    template <typename E>
-    void writeEnum(E value) {
-        static_assert(std::is_enum_v<E>, "template argument passed to writeEnum must be an enum");
-
-        using P = typename std::underlying_type<E>::type;
-
-        static_assert(util::data::IsPrimitive<P>, "enum underlying type must be a primitive");
-
-        this->writePrimitive<P>(static_cast<P>(value));
-    }
-
     // Read a value using boost reflection
     template <
         typename T,
@@ -315,30 +249,6 @@ protected:
         return Ok(std::move(value));
     }
 
-    // Write a value using boost reflection
-    template <
-        typename T,
-        class Md = boost::describe::describe_members<T, boost::describe::mod_public>,
-        class Bd = boost::describe::describe_bases<T, boost::describe::mod_any_access>
-    >
-    void reflectionEncode(const T& value) {
-        static_assert(std::is_class_v<T>, "attempted to call reflectionEncode on a non-class type");
-
-        // if it's a bitfield struct, encode it as such
-        if constexpr (!boost::mp11::mp_empty<Bd>::value) {
-            if constexpr (std::is_same_v<typename boost::mp11::mp_first<Bd>::type, BitfieldBase>) {
-                this->reflectionEncodeBitfield<T>(value);
-                return;
-            }
-        } else {
-            checkMissingFields<T>();
-        }
-
-        boost::mp11::mp_for_each<Md>([&, this](auto descriptor) {
-            this->writeValue(value.*descriptor.pointer);
-        });
-    }
-
     template <
         typename T,
         class Md = boost::describe::describe_members<T, boost::describe::mod_public>
@@ -362,29 +272,6 @@ protected:
         return Ok(std::move(value));
     }
 
-    template <
-        typename T,
-        class Md = boost::describe::describe_members<T, boost::describe::mod_public>
-    >
-    void reflectionEncodeBitfield(const T& value) {
-        static_assert(sizeof(T) <= 64, "unable to encode a bitfield with over 64 fields");
-
-        // so evil
-        constexpr size_t bitcount = util::data::bitsToBytes(sizeof(T)) * 8;
-        BitBuffer<bitcount> bits;
-
-        boost::mp11::mp_for_each<Md>([&, this](auto descriptor) -> void {
-            using MPT = decltype(descriptor.pointer);
-            using FT = typename asp::member_ptr_to_underlying<MPT>::type;
-
-            static_assert(std::is_same_v<FT, bool>, "bitfield struct must consist of only bools");
-
-            bits.writeBit(value.*descriptor.pointer);
-        });
-
-        this->writeBits(bits);
-    }
-
     /* Some templated specializations */
 
     template <typename T>
@@ -404,29 +291,26 @@ protected:
         }
     }
 
-    template <typename T>
-    void preCustomEncode(const T& value) {
-        if constexpr (asp::is_std_vector<T>::value) {
-            this->pcEncodeVector<typename T::value_type>(value);
-        } else if constexpr (asp::is_std_pair<T>::value) {
-            this->pcEncodePair<typename T::first_type, typename T::second_type>(value);
-        } else if constexpr (asp::is_std_optional<T>::value) {
-            this->pcEncodeOptional<typename T::value_type>(value);
-        } else if constexpr (util::misc::is_either<T>::value) {
-            this->pcEncodeEither(value);
-        } else if constexpr (util::misc::is_map<T>::value) {
-            this->pcEncodeMap<typename T::key_type, typename T::mapped_type>(value);
-        } else if constexpr (std::is_same_v<T, ByteBuffer>) {
-            this->rawWriteBytes(value.data().data(), value.size());
-        } else {
-            this->customEncode(value);
-        }
-    }
-
     // Vector
 
     template<typename T>
     DecodeResult<std::vector<T>> pcDecodeVector() {
+        if constexpr (util::data::IsBulkPrimitive<T>) {
+            return this->pcDecodeBulkVector<T>();
+        } else if constexpr (fixedWireSize<T>() != 0) {
+            // the size is known upfront, so check the bounds once for the entire vector
+            GLOBED_UNWRAP_INTO(this->readLengthCheck(fixedWireSize<T>()), auto length);
+
+            std::vector<T> out;
+            out.reserve(length);
+
+            for (size_t i = 0; i < length; i++) {
+                out.emplace_back(this->readUnchecked<T>());
+            }
+
+            return Ok(std::move(out));
+        }
+
         GLOBED_UNWRAP_INTO(this->readLength(), auto length);
 
         std::vector<T> out;
@@ -443,12 +327,38 @@ protected:
         return Ok(std::move(out));
     }
 
-    template<typename T>
-    void pcEncodeVector(const std::vector<T>& vec) {
-        this->writeLength(vec.size());
+    template <typename T>
+    DecodeResult<std::vector<T>> pcDecodeBulkVector() {
+        GLOBED_UNWRAP_INTO(this->readLengthCheck(sizeof(T)), auto length);
+
+        std::vector<T> out(length);
+
+        if (length > 0) {
+            std::memcpy(out.data(), _view.data() + _position, length * sizeof(T));
+            _position += length * sizeof(T);
+
+            util::data::maybeByteswapRange(out.data(), length);
+        }
+
+        return Ok(std::move(out));
+    }
+
+    // Like `readValue`, but without a bounds check. Only usable for types with a fixed wire size, after checking that enough data is left.
+    template <typename T>
+    T readUnchecked() {
+        if constexpr (util::data::IsPrimitive<T>) {
+            T value;
+            std::memcpy(&value, _view.data() + _position, sizeof(T));
+            _position += sizeof(T);
+
+            return util::data::maybeByteswap(value);
+        } else {
+            static_assert(asp::is_std_pair<T>::value, "readUnchecked only supports primitives and pairs");
+
+            auto first = this->readUnchecked<typename T::first_type>();
+            auto second = this->readUnchecked<typename T::second_type>();
 
-        for (const auto& elem : vec) {
-            this->writeValue<T>(elem);
+            return T { std::move(first), std::move(second) };
         }
     }
 
@@ -470,16 +380,6 @@ protected:
         return Ok(std::move(out));
     }
 
-    template <typename T, typename Y>
-    void pcEncodeMap(const std::map<T, Y>& map) {
-        this->writeLength(map.size());
-
-        for (const auto& [first, second] : map) {
-            this->writeValue<T>(first);
-            this->writeValue<Y>(second);
-        }
-    }
-
     // Pair
 
     template <typename T1, typename T2>
@@ -490,12 +390,6 @@ protected:
         return Ok(std::move(std::make_pair(std::move(first), std::move(second))));
     }
 
-    template <typename T1, typename T2>
-    void pcEncodePair(const std::pair<T1, T2>& pair) {
-        this->writeValue<T1>(pair.first);
-        this->writeValue<T2>(pair.second);
-    }
-
     // Optional
 
     template <typename T>
@@ -511,15 +405,6 @@ protected:
         return Ok(std::move(value));
     }
 
-    template <typename T>
-    void pcEncodeOptional(const std::optional<T>& opt) {
-        this->writeBool(opt.has_value());
-
-        if (opt.has_value()) {
-            this->writeValue<T>(opt.value());
-        }
-    }
-
     // Either
 
     template <typename T, typename Y>
@@ -535,18 +420,22 @@ protected:
         }
     }
 
-    template <typename T, typename Y>
-    void pcEncodeEither(const Either<T, Y>& either) {
-        this->writeBool(either.isFirst());
+public:
+    // Size of `T` on the wire if it is the same for every value, otherwise 0
+    template <typename T>
+    constexpr static size_t fixedWireSize() {
+        if constexpr (util::data::IsPrimitive<T>) {
+            return sizeof(T);
+        } else if constexpr (asp::is_std_pair<T>::value) {
+            constexpr size_t first = fixedWireSize<typename T::first_type>();
+            constexpr size_t second = fixedWireSize<typename T::second_type>();
 
-        if (either.isFirst()) {
-            this->writeValue<T>(either.firstRef()->get());
+            return (first != 0 && second != 0) ? first + second : 0;
         } else {
-            this->writeValue<Y>(either.secondRef()->get());
+            return 0;
         }
     }
 
-public:
     template <
         typename T,
         class Md = boost::describe::describe_members<T, boost::describe::mod_public>
@@ -556,7 +445,11 @@ public:
         size_t structAlignment = 1;
 
         // this is bad bad bad, but we assume there can only be 1 vtable.
-        if constexpr (std::is_polymorphic_v<T>) {
+        if constexpr (requires { T::UNSERIALIZED_BASE_SIZE; }) {
+            // base class that holds its own data members besides the vtable (i.e. `Packet`)
+            structAlignment = alignof(void*);
+            total += T::UNSERIALIZED_BASE_SIZE;
+        } else if constexpr (std::is_polymorphic_v<T>) {
             structAlignment = alignof(void*);
             total += sizeof(void*);
         }
@@ -591,10 +484,408 @@ public:
         static_assert(calculateStructSize<T>() == sizeof(T), "size of the type does not match the sizes of all fields, make sure fields are listed in the correct order and there are no missing fields");
     }
 
-private:
+protected:
     // Data members
-    util::data::bytevector _data;
+    std::span<const util::data::byte> _view;
     size_t _position = 0;
+
+private:
+    bool _borrowing = false;
+    size_t _borrowedReads = 0;
+    uint16_t _protocol = 0;
+    cocos2d::CCPoint _positionOrigin;
+};
+
+// Growable buffer that owns its data. Used for encoding, but can be decoded from just like a `ByteReader`.
+class ByteBuffer : public ByteReader {
+public:
+    // Constructs a `ByteBuffer` with no data
+    ByteBuffer();
+
+    // Construct a `ByteBuffer` with a copy of some data
+    ByteBuffer(const util::data::bytevector& data);
+    ByteBuffer(const util::data::byte* data, size_t length);
+
+    // Take ownership of the given `bytevector` and construct a `ByteBuffer` from the data
+    ByteBuffer(util::data::bytevector&& data);
+
+    ByteBuffer(const ByteBuffer& other);
+    ByteBuffer& operator=(const ByteBuffer& other);
+
+    ByteBuffer(ByteBuffer&& other) noexcept;
+    ByteBuffer& operator=(ByteBuffer&& other) noexcept;
+
+    // Write a value to this bytebuffer
+    template <typename T>
+    void writeValue(const T& value) {
+        if constexpr (util::data::IsPrimitive<T>) {
+            this->writePrimitive<T>(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            this->writeEnum<T>(value);
+        } else if constexpr (std::is_empty_v<T>) {
+            // zst, do nothing
+        } else if constexpr (boost::describe::has_describe_members<T>::value) {
+            this->reflectionEncode<T>(value);
+        } else {
+            // use custom encoder
+            this->preCustomEncode<T>(value);
+        }
+    }
+
+    // Write a commonly encodable type. Can be specialized for any type to enable encoding ability.
+    template <typename T>
+    void customEncode(const T& value);
+
+    /* Various helper methods */
+
+    // Get the underlying data buffer of this `ByteBuffer`
+    const util::data::bytevector& data() const;
+
+    // Get the underlying data buffer of this `ByteBuffer`. The contents may be modified, but the size must be changed with `resize`.
+    util::data::bytevector& data();
+
+    // Clear all the data in this buffer
+    void clear();
+
+    // Resize the internal buffer to `newSize` bytes
+    void resize(size_t newSize);
+
+    // Equivalent to `resize(size() + bytes)`
+    void grow(size_t bytes);
+
+    // Equivalent to `resize(size() - bytes)`
+    void shrink(size_t bytes);
+
+    // Make sure `bytes` more bytes can be written past the end of the buffer without reallocating
+    void reserve(size_t bytes);
+
+    /* Helper methods for writing a specific integer type */
+
+    void writeBool(bool value);
+    void writeU8(uint8_t value);
+    void writeU16(uint16_t value);
+    void writeU32(uint32_t value);
+    void writeU64(uint64_t value);
+    void writeI8(int8_t value);
+    void writeI16(int16_t value);
+    void writeI32(int32_t value);
+    void writeI64(int64_t value);
+    void writeF32(float value);
+    void writeF64(double value);
+    void writeLength(size_t value);
+
+    /* Bits */
+    template <size_t N>
+    void writeBits(const BitBuffer<N>& bits) {
+        this->writePrimitive(bits.contents());
+    }
+
+    /* Raw write */
+    void writeBytes(void* buf, size_t bytes);
+
+    /* Size calculation */
+
+    // Returned by `maxEncodedSize` for types that have no upper bound on their encoded size
+    static constexpr size_t UNBOUNDED_SIZE = std::numeric_limits<size_t>::max();
+
+    // Largest amount of bytes a value of `T` can take up when encoded, or `UNBOUNDED_SIZE` if it contains a vector, a string or similar.
+    // Types with a custom encoder declare their bound with a `static constexpr size_t MAX_ENCODED_SIZE` member, otherwise they are unbounded.
+    template <typename T>
+    constexpr static size_t maxEncodedSize() {
+        if constexpr (requires { T::MAX_ENCODED_SIZE; }) {
+            return T::MAX_ENCODED_SIZE;
+        } else if constexpr (util::data::IsPrimitive<T>) {
+            return sizeof(T);
+        } else if constexpr (std::is_enum_v<T>) {
+            return sizeof(std::underlying_type_t<T>);
+        } else if constexpr (std::is_empty_v<T>) {
+            return 0;
+        } else if constexpr (boost::describe::has_describe_members<T>::value) {
+            return reflectionMaxEncodedSize<T>();
+        } else if constexpr (std::is_same_v<T, cocos2d::CCPoint> || std::is_same_v<T, cocos2d::CCSize>) {
+            return sizeof(float) * 2;
+        } else if constexpr (std::is_same_v<T, cocos2d::ccColor3B> || std::is_same_v<T, cocos2d::ccColor4B>) {
+            // one byte per component
+            return sizeof(T);
+        } else if constexpr (std::is_same_v<T, util::data::bytearray<sizeof(T)>>) {
+            return sizeof(T);
+        } else if constexpr (asp::is_std_pair<T>::value) {
+            return addBounds(maxEncodedSize<typename T::first_type>(), maxEncodedSize<typename T::second_type>());
+        } else if constexpr (asp::is_std_optional<T>::value) {
+            return addBounds(sizeof(bool), maxEncodedSize<typename T::value_type>());
+        } else if constexpr (util::misc::is_either<T>::value) {
+            return addBounds(sizeof(bool), std::max(maxEncodedSize<typename T::first_type>(), maxEncodedSize<typename T::second_type>()));
+        } else {
+            return UNBOUNDED_SIZE;
+        }
+    }
+
+    // Amount of bytes `value` takes up when encoded, used to reserve space before encoding. Bounded types return `maxEncodedSize<T>()`,
+    // which may be a few bytes more than needed (e.g. for an empty optional). Everything else is walked, custom encoded types
+    // can take part by providing a `size_t encodedSize() const` method. Types the walk knows nothing about count as 0 bytes,
+    // the buffer then simply grows while encoding them.
+    template <typename T>
+    static size_t encodedSize(const T& value) {
+        if constexpr (maxEncodedSize<T>() != UNBOUNDED_SIZE) {
+            return maxEncodedSize<T>();
+        } else if constexpr (requires { value.encodedSize(); }) {
+            return value.encodedSize();
+        } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+            return sizeof(length_t) + value.size();
+        } else if constexpr (std::is_same_v<T, ByteBuffer>) {
+            return value.size();
+        } else if constexpr (asp::is_std_vector<T>::value) {
+            using E = typename T::value_type;
+
+            if constexpr (maxEncodedSize<E>() != UNBOUNDED_SIZE) {
+                return sizeof(length_t) + value.size() * maxEncodedSize<E>();
+            } else {
+                size_t total = sizeof(length_t);
+                for (const auto& elem : value) {
+                    total += encodedSize(elem);
+                }
+
+                return total;
+            }
+        } else if constexpr (util::misc::is_map<T>::value) {
+            size_t total = sizeof(length_t);
+            for (const auto& [first, second] : value) {
+                total += encodedSize(first) + encodedSize(second);
+            }
+
+            return total;
+        } else if constexpr (asp::is_std_pair<T>::value) {
+            return encodedSize(value.first) + encodedSize(value.second);
+        } else if constexpr (asp::is_std_optional<T>::value) {
+            return sizeof(bool) + (value.has_value() ? encodedSize(value.value()) : 0);
+        } else if constexpr (util::misc::is_either<T>::value) {
+            return sizeof(bool) + (value.isFirst() ? encodedSize(value.firstRef()->get()) : encodedSize(value.secondRef()->get()));
+        } else if constexpr (boost::describe::has_describe_members<T>::value) {
+            size_t total = 0;
+            boost::mp11::mp_for_each<boost::describe::describe_members<T, boost::describe::mod_public>>([&](auto descriptor) {
+                total += encodedSize(value.*descriptor.pointer);
+            });
+
+            return total;
+        } else {
+            return 0;
+        }
+    }
+
+protected:
+    // Write the bits of `value` into this `ByteBuffer`. No endianness conversions are done
+    template <typename T>
+    void rawWrite(T value) {
+        const util::data::byte* bytes = reinterpret_cast<const util::data::byte*>(&value);
+
+        this->rawWriteBytes(bytes, sizeof(T));
+    }
+
+    // Like `rawWrite` but accepts a raw buffer
+    void rawWriteBytes(const util::data::byte* bytes, size_t length);
+
+    // Write a primitive `T`, performing endianness conversions
+    template <typename T>
+    void writePrimitive(T value) {
+        static_assert(util::data::IsPrimitive<T>, "Type passed to writePrimitive must be a primitive");
+
+        value = util::data::maybeByteswap(value);
+
+        this->rawWrite<T>(value);
+    }
+
+    // Write an enum
+    template <typename E>
+    void writeEnum(E value) {
+        static_assert(std::is_enum_v<E>, "template argument passed to writeEnum must be an enum");
+
+        using P = typename std::underlying_type<E>::type;
+
+        static_assert(util::data::IsPrimitive<P>, "enum underlying type must be a primitive");
+
+        this->writePrimitive<P>(static_cast<P>(value));
+    }
+
+    // Write a value using boost reflection
+    template <
+        typename T,
+        class Md = boost::describe::describe_members<T, boost::describe::mod_public>,
+        class Bd = boost::describe::describe_bases<T, boost::describe::mod_any_access>
+    >
+    void reflectionEncode(const T& value) {
+        static_assert(std::is_class_v<T>, "attempted to call reflectionEncode on a non-class type");
+
+        // if it's a bitfield struct, encode it as such
+        if constexpr (!boost::mp11::mp_empty<Bd>::value) {
+            if constexpr (std::is_same_v<typename boost::mp11::mp_first<Bd>::type, BitfieldBase>) {
+                this->reflectionEncodeBitfield<T>(value);
+                return;
+            }
+        } else {
+            checkMissingFields<T>();
+        }
+
+        boost::mp11::mp_for_each<Md>([&, this](auto descriptor) {
+            this->writeValue(value.*descriptor.pointer);
+        });
+    }
+
+    template <
+        typename T,
+        class Md = boost::describe::describe_members<T, boost::describe::mod_public>
+    >
+    void reflectionEncodeBitfield(const T& value) {
+        static_assert(sizeof(T) <= 64, "unable to encode a bitfield with over 64 fields");
+
+        // so evil
+        constexpr size_t bitcount = util::data::bitsToBytes(sizeof(T)) * 8;
+        BitBuffer<bitcount> bits;
+
+        boost::mp11::mp_for_each<Md>([&, this](auto descriptor) -> void {
+            using MPT = decltype(descriptor.pointer);
+            using FT = typename asp::member_ptr_to_underlying<MPT>::type;
+
+            static_assert(std::is_same_v<FT, bool>, "bitfield struct must consist of only bools");
+
+            bits.writeBit(value.*descriptor.pointer);
+        });
+
+        this->writeBits(bits);
+    }
+
+    /* Some templated specializations */
+
+    template <typename T>
+    void preCustomEncode(const T& value) {
+        if constexpr (asp::is_std_vector<T>::value) {
+            this->pcEncodeVector<typename T::value_type>(value);
+        } else if constexpr (asp::is_std_pair<T>::value) {
+            this->pcEncodePair<typename T::first_type, typename T::second_type>(value);
+        } else if constexpr (asp::is_std_optional<T>::value) {
+            this->pcEncodeOptional<typename T::value_type>(value);
+        } else if constexpr (util::misc::is_either<T>::value) {
+            this->pcEncodeEither(value);
+        } else if constexpr (util::misc::is_map<T>::value) {
+            this->pcEncodeMap<typename T::key_type, typename T::mapped_type>(value);
+        } else if constexpr (std::is_same_v<T, ByteBuffer>) {
+            this->rawWriteBytes(value.data().data(), value.size());
+        } else {
+            this->customEncode(value);
+        }
+    }
+
+    // Vector
+
+    template<typename T>
+    void pcEncodeVector(const std::vector<T>& vec) {
+        this->writeLength(vec.size());
+
+        if constexpr (util::data::IsBulkPrimitive<T>) {
+            this->writeBulk(vec.data(), vec.size());
+        } else {
+            for (const auto& elem : vec) {
+                this->writeValue<T>(elem);
+            }
+        }
+    }
+
+    // Write `count` primitives at once, converting them to the wire byte order in small chunks
+    template <typename T>
+    void writeBulk(const T* data, size_t count) {
+        if constexpr (sizeof(T) == 1 || !GLOBED_LITTLE_ENDIAN) {
+            this->rawWriteBytes(reinterpret_cast<const util::data::byte*>(data), count * sizeof(T));
+        } else {
+            constexpr size_t CHUNK = 256 / sizeof(T);
+            T chunk[CHUNK];
+
+            for (size_t i = 0; i < count; i += CHUNK) {
+                size_t n = std::min(CHUNK, count - i);
+
+                std::memcpy(chunk, data + i, n * sizeof(T));
+                util::data::maybeByteswapRange(chunk, n);
+
+                this->rawWriteBytes(reinterpret_cast<const util::data::byte*>(chunk), n * sizeof(T));
+            }
+        }
+    }
+
+    // Map
+
+    template <typename T, typename Y>
+    void pcEncodeMap(const std::map<T, Y>& map) {
+        this->writeLength(map.size());
+
+        for (const auto& [first, second] : map) {
+            this->writeValue<T>(first);
+            this->writeValue<Y>(second);
+        }
+    }
+
+    // Pair
+
+    template <typename T1, typename T2>
+    void pcEncodePair(const std::pair<T1, T2>& pair) {
+        this->writeValue<T1>(pair.first);
+        this->writeValue<T2>(pair.second);
+    }
+
+    // Optional
+
+    template <typename T>
+    void pcEncodeOptional(const std::optional<T>& opt) {
+        this->writeBool(opt.has_value());
+
+        if (opt.has_value()) {
+            this->writeValue<T>(opt.value());
+        }
+    }
+
+    // Either
+
+    template <typename T, typename Y>
+    void pcEncodeEither(const Either<T, Y>& either) {
+        this->writeBool(either.isFirst());
+
+        if (either.isFirst()) {
+            this->writeValue<T>(either.firstRef()->get());
+        } else {
+            this->writeValue<Y>(either.secondRef()->get());
+        }
+    }
+
+    template <
+        typename T,
+        class Md = boost::describe::describe_members<T, boost::describe::mod_public>,
+        class Bd = boost::describe::describe_bases<T, boost::describe::mod_any_access>
+    >
+    constexpr static size_t reflectionMaxEncodedSize() {
+        if constexpr (!boost::mp11::mp_empty<Bd>::value) {
+            if constexpr (std::is_same_v<typename boost::mp11::mp_first<Bd>::type, BitfieldBase>) {
+                return sizeof(BitBufferUnderlyingType<util::data::bitsToBytes(sizeof(T)) * 8>);
+            }
+        }
+
+        size_t total = 0;
+
+        boost::mp11::mp_for_each<Md>([&](auto descriptor) {
+            using MPT = decltype(descriptor.pointer);
+            using FT = typename asp::member_ptr_to_underlying<MPT>::type;
+
+            total = addBounds(total, maxEncodedSize<FT>());
+        });
+
+        return total;
+    }
+
+    constexpr static size_t addBounds(size_t a, size_t b) {
+        return (a == UNBOUNDED_SIZE || b == UNBOUNDED_SIZE) ? UNBOUNDED_SIZE : a + b;
+    }
+
+private:
+    util::data::bytevector _data;
+
+    // point the reader at the current storage, must be called whenever `_data` may have reallocated
+    void syncView();
 };
 
 // Custom error formatter
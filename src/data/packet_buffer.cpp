@@ -0,0 +1,100 @@
+#include "packet_buffer.hpp"
+
+using namespace util::data;
+
+PacketBufferRef::PacketBufferRef(PacketBuffer* buf) : buf(buf) {
+    if (buf) {
+        buf->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PacketBufferRef::~PacketBufferRef() {
+    this->reset();
+}
+
+PacketBufferRef::PacketBufferRef(const PacketBufferRef& other) : PacketBufferRef(other.buf) {}
+
+PacketBufferRef& PacketBufferRef::operator=(const PacketBufferRef& other) {
+    if (this != &other) {
+        this->reset();
+
+        buf = other.buf;
+        if (buf) {
+            buf->refcount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    return *this;
+}
+
+PacketBufferRef::PacketBufferRef(PacketBufferRef&& other) noexcept : buf(other.buf) {
+    other.buf = nullptr;
+}
+
+PacketBufferRef& PacketBufferRef::operator=(PacketBufferRef&& other) noexcept {
+    if (this != &other) {
+        this->reset();
+
+        buf = other.buf;
+        other.buf = nullptr;
+    }
+
+    return *this;
+}
+
+void PacketBufferRef::reset() {
+    if (!buf) return;
+
+    if (buf->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        PacketBufferPool::get().recycle(buf);
+    }
+
+    buf = nullptr;
+}
+
+PacketBufferRef PacketBufferPool::acquire(size_t size, bool* reused) {
+    bool wasReused;
+    auto buf = this->take(wasReused);
+
+    buf->data.resize(size);
+
+    if (reused) {
+        *reused = wasReused;
+    }
+
+    return PacketBufferRef(buf);
+}
+
+size_t PacketBufferPool::idleCount() {
+    return idle.lock()->size();
+}
+
+PacketBuffer* PacketBufferPool::take(bool& reused) {
+    {
+        auto idleBufs = idle.lock();
+
+        if (!idleBufs->empty()) {
+            auto buf = idleBufs->back();
+            idleBufs->pop_back();
+
+            reused = true;
+            return buf;
+        }
+    }
+
+    reused = false;
+    return new PacketBuffer;
+}
+
+void PacketBufferPool::recycle(PacketBuffer* buf) {
+    if (buf->data.capacity() <= MAX_IDLE_CAPACITY) {
+        auto idleBufs = idle.lock();
+
+        if (idleBufs->size() < MAX_IDLE) {
+            idleBufs->push_back(buf);
+            return;
+        }
+    }
+
+    delete buf;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <asp/sync.hpp>
+
+#include <util/data.hpp>
+#include <util/singleton.hpp>
+
+// Holds the raw bytes of a received packet. Instances are owned by the `PacketBufferPool`
+// and are only ever handed out through a `PacketBufferRef`.
+class PacketBuffer {
+public:
+    util::data::bytevector data;
+
+private:
+    friend class PacketBufferRef;
+    friend class PacketBufferPool;
+
+    std::atomic<uint32_t> refcount = 0;
+};
+
+// Intrusively reference counted handle to a `PacketBuffer`.
+// When the last reference is dropped, the buffer is returned to the pool instead of being freed.
+class PacketBufferRef {
+public:
+    PacketBufferRef() = default;
+    ~PacketBufferRef();
+
+    PacketBufferRef(const PacketBufferRef& other);
+    PacketBufferRef& operator=(const PacketBufferRef& other);
+
+    PacketBufferRef(PacketBufferRef&& other) noexcept;
+    PacketBufferRef& operator=(PacketBufferRef&& other) noexcept;
+
+    PacketBuffer* operator->() const {
+        return buf;
+    }
+
+    PacketBuffer& operator*() const {
+        return *buf;
+    }
+
+    explicit operator bool() const {
+        return buf != nullptr;
+    }
+
+    void reset();
+
+private:
+    friend class PacketBufferPool;
+
+    explicit PacketBufferRef(PacketBuffer* buf);
+
+    PacketBuffer* buf = nullptr;
+};
+
+// Pool of receive buffers, used by `GameSocket` to avoid allocating a fresh buffer for every received packet.
+class PacketBufferPool : public SingletonLeakBase<PacketBufferPool> {
+public:
+    // max amount of idle buffers kept in the pool
+    static constexpr size_t MAX_IDLE = 32;
+    // buffers with a bigger capacity than this are freed instead of being returned to the pool
+    static constexpr size_t MAX_IDLE_CAPACITY = 1 << 16;
+
+    // Get a buffer that is exactly `size` bytes long, contents are unspecified.
+    // If `reused` is not null, it is set to whether the buffer was taken from the pool.
+    PacketBufferRef acquire(size_t size, bool* reused = nullptr);
+
+    size_t idleCount();
+
+private:
+    friend class PacketBufferRef;
+
+    asp::Mutex<std::vector<PacketBuffer*>> idle;
+
+    PacketBuffer* take(bool& reused);
+    void recycle(PacketBuffer* buf);
+};
@@ -2,6 +2,7 @@
 #include <data/packets/packet.hpp>
 #include <data/types/crypto.hpp>
 #include <data/types/gd.hpp>
+#include <data/types/misc.hpp>
 #include <data/types/user.hpp>
 
 // 10000 - PingPacket
@@ -21,22 +22,41 @@ class CryptoHandshakeStartPacket : public Packet {
     GLOBED_PACKET(10001, CryptoHandshakeStartPacket, false, true)
 
     CryptoHandshakeStartPacket() {}
-    CryptoHandshakeStartPacket(uint16_t _protocol, CryptoPublicKey _key) : protocol(_protocol), key(_key) {}
+    CryptoHandshakeStartPacket(uint16_t _protocol, CryptoPublicKey _key, CryptoNonceMode _nonceMode = {}) : protocol(_protocol), key(_key), nonceMode(_nonceMode) {}
+
+    static constexpr size_t MAX_ENCODED_SIZE = sizeof(uint16_t) + CryptoBox::KEY_LEN + CryptoNonceMode::MAX_ENCODED_SIZE;
 
     uint16_t protocol;
     CryptoPublicKey key;
+    CryptoNonceMode nonceMode; // only sent for `COUNTER_NONCE_PROTOCOL` and newer
 };
 
-GLOBED_SERIALIZABLE_STRUCT(CryptoHandshakeStartPacket, (protocol, key));
+template <>
+inline ByteReader::DecodeResult<CryptoHandshakeStartPacket> ByteReader::customDecode<CryptoHandshakeStartPacket>() {
+    throw std::runtime_error("unreachable tbh");
+}
+
+template <>
+inline void ByteBuffer::customEncode<CryptoHandshakeStartPacket>(const CryptoHandshakeStartPacket& packet) {
+    this->writeValue(packet.protocol);
+    this->writeValue(packet.key);
+
+    if (packet.protocol >= COUNTER_NONCE_PROTOCOL) {
+        this->writeValue(packet.nonceMode);
+    }
+}
 
 // 10002 - KeepalivePacket
 class KeepalivePacket : public Packet {
     GLOBED_PACKET(10002, KeepalivePacket, false, false)
 
     KeepalivePacket() {}
+    KeepalivePacket(uint64_t clientTime) : times{ .clientTime = clientTime } {}
+
+    ClockSyncTimes times;
 };
 
-GLOBED_SERIALIZABLE_STRUCT(KeepalivePacket, ());
+GLOBED_SERIALIZABLE_STRUCT(KeepalivePacket, (times));
 
 // 10003 - LoginPacket
 class LoginPacket : public Packet {
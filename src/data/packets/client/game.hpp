@@ -1,6 +1,7 @@
 #pragma once
 #include <data/packets/packet.hpp>
 #include <data/types/gd.hpp>
+#include <data/types/player_delta.hpp>
 
 // 12000 - RequestPlayerProfilesPacket
 class RequestPlayerProfilesPacket : public Packet {
@@ -41,18 +42,30 @@ class PlayerDataPacket : public Packet {
     PlayerDataPacket() {}
     PlayerDataPacket(const PlayerData& data, const std::optional<PlayerMetadata>& meta, std::vector<GlobedCounterChange>&& counterChanges) : data(data), meta(meta), counterChanges(std::move(counterChanges)) {}
 
+    // everything except the counter changes themselves
+    static constexpr size_t FIXED_ENCODED_SIZE =
+        ByteBuffer::maxEncodedSize<PositionOrigin>()
+        + ByteBuffer::maxEncodedSize<PlayerData>()
+        + ByteBuffer::maxEncodedSize<std::optional<PlayerMetadata>>()
+        + sizeof(uint8_t); // counter change count
+
+    size_t encodedSize() const {
+        return FIXED_ENCODED_SIZE + counterChanges.size() * ByteBuffer::maxEncodedSize<GlobedCounterChange>();
+    }
+
     PlayerData data;
     std::optional<PlayerMetadata> meta;
     std::vector<GlobedCounterChange> counterChanges;
 };
 
 template <>
-inline ByteBuffer::DecodeResult<PlayerDataPacket> ByteBuffer::customDecode<PlayerDataPacket>() {
+inline ByteReader::DecodeResult<PlayerDataPacket> ByteReader::customDecode<PlayerDataPacket>() {
     throw std::runtime_error("unreachable tbh");
 }
 
 template <>
 inline void ByteBuffer::customEncode<PlayerDataPacket>(const PlayerDataPacket& packet) {
+    this->writeValue(PositionOrigin { packet.data.player1.position });
     this->writeValue(packet.data);
     this->writeValue(packet.meta);
 
@@ -63,6 +76,62 @@ inline void ByteBuffer::customEncode<PlayerDataPacket>(const PlayerDataPacket& p
     }
 }
 
+// first protocol version where the server understands `PlayerDataDeltaPacket` and sends `LevelDataDeltaPacket`
+inline constexpr uint16_t DELTA_PLAYER_DATA_PROTOCOL = 15;
+
+// 12005 - PlayerDataDeltaPacket
+class PlayerDataDeltaPacket : public Packet {
+    GLOBED_PACKET(12005, PlayerDataDeltaPacket, false, false)
+
+    PlayerDataDeltaPacket() {}
+    PlayerDataDeltaPacket(
+        const PlayerDataFrame& frame,
+        std::vector<PlayerKeyframeAck>&& acks,
+        const std::optional<PlayerMetadata>& meta,
+        std::vector<GlobedCounterChange>&& counterChanges
+    ) : frame(frame), acks(std::move(acks)), meta(meta), counterChanges(std::move(counterChanges)) {}
+
+    // everything except the acks and counter changes themselves
+    static constexpr size_t FIXED_ENCODED_SIZE =
+        ByteBuffer::maxEncodedSize<PositionOrigin>()
+        + ByteBuffer::maxEncodedSize<PlayerDataFrame>()
+        + sizeof(uint16_t) // ack count
+        + ByteBuffer::maxEncodedSize<std::optional<PlayerMetadata>>()
+        + sizeof(uint8_t); // counter change count
+
+    size_t encodedSize() const {
+        return FIXED_ENCODED_SIZE
+            + acks.size() * ByteBuffer::maxEncodedSize<PlayerKeyframeAck>()
+            + counterChanges.size() * ByteBuffer::maxEncodedSize<GlobedCounterChange>();
+    }
+
+    PlayerDataFrame frame;
+    // keyframes of other players that were received, but not yet confirmed to be acknowledged
+    std::vector<PlayerKeyframeAck> acks;
+    std::optional<PlayerMetadata> meta;
+    std::vector<GlobedCounterChange> counterChanges;
+};
+
+template <>
+inline ByteReader::DecodeResult<PlayerDataDeltaPacket> ByteReader::customDecode<PlayerDataDeltaPacket>() {
+    throw std::runtime_error("unreachable tbh");
+}
+
+template <>
+inline void ByteBuffer::customEncode<PlayerDataDeltaPacket>(const PlayerDataDeltaPacket& packet) {
+    // only keyframes contain absolute positions
+    this->writeValue(PositionOrigin { packet.frame.isKeyframe ? packet.frame.keyframe.player1.position : cocos2d::CCPoint {} });
+    this->writeValue(packet.frame);
+    this->writeValue(packet.acks);
+    this->writeValue(packet.meta);
+
+    this->writeU8(packet.counterChanges.size());
+
+    for (const auto& change : packet.counterChanges) {
+        this->writeValue(change);
+    }
+}
+
 #ifdef GLOBED_VOICE_SUPPORT
 
 #include <audio/frame.hpp>
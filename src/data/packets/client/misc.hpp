@@ -31,10 +31,14 @@ public:
         buf.writeValue<ByteBuffer>(buffer);
     }
 
-    ByteBuffer::DecodeResult<> decode(ByteBuffer& buf) override {
+    ByteReader::DecodeResult<> decode(ByteReader& buf) override {
         throw std::runtime_error("RawPacket cannot be decoded");
     }
 
+    size_t getEncodedSize() const override {
+        return buffer.size();
+    }
+
     static std::shared_ptr<Packet> create(packetid_t id, bool encrypted, bool tcp, ByteBuffer&& buffer) {
         return std::make_shared<RawPacket>(id, encrypted, tcp, std::move(buffer));
     }
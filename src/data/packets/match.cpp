@@ -35,6 +35,7 @@ std::shared_ptr<Packet> matchPacket(packetid_t packetId) {
 
         PACKET(PlayerProfilesPacket);
         PACKET(LevelDataPacket);
+        PACKET(LevelDataDeltaPacket);
         PACKET(LevelPlayerMetadataPacket);
         PACKET(LevelInnerPlayerCountPacket);
         PACKET(VoiceBroadcastPacket);
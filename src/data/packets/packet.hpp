@@ -3,6 +3,7 @@
 #include <defs/minimal_geode.hpp>
 #include <defs/assert.hpp>
 #include <data/bytebuffer.hpp>
+#include <data/packet_buffer.hpp>
 
 using packetid_t = uint16_t;
 
@@ -12,6 +13,7 @@ using packetid_t = uint16_t;
     static constexpr bool SHOULD_USE_TCP = tcp; \
     static constexpr bool ENCRYPTED = enc; \
     static constexpr const char* PACKET_NAME = #name; \
+    static constexpr size_t UNSERIALIZED_BASE_SIZE = sizeof(Packet); \
     packetid_t getPacketId() const override { return this->PACKET_ID; } \
     bool getUseTcp() const override { return this->SHOULD_USE_TCP; } \
     bool getEncrypted() const override { return this->ENCRYPTED; } \
@@ -21,10 +23,15 @@ using packetid_t = uint16_t;
         using NonCvTy = typename std::remove_cv_t<InstTy>; \
         buf.writeValue<NonCvTy>(*this); \
     } \
-    ByteBuffer::DecodeResult<> decode(ByteBuffer& buf) override { \
+    ByteReader::DecodeResult<> decode(ByteReader& buf) override { \
         GLOBED_UNWRAP_INTO(buf.readValue<std::remove_reference_t<decltype(*this)>>(), *this); \
         return Ok(); \
     } \
+    size_t getEncodedSize() const override { \
+        using InstTy = typename std::remove_reference_t<decltype(*this)>; \
+        using NonCvTy = typename std::remove_cv_t<InstTy>; \
+        return ByteBuffer::encodedSize<NonCvTy>(*this); \
+    } \
     template <typename... Args> \
     static std::shared_ptr<Packet> create(Args&&... args) { \
         return std::make_shared<name>(std::forward<Args>(args)...); \
@@ -36,7 +43,10 @@ public:
     virtual void encode(ByteBuffer& buf) const = 0;
 
     // Decodes the packet from a bytebuffer
-    virtual ByteBuffer::DecodeResult<> decode(ByteBuffer& buf) = 0;
+    virtual ByteReader::DecodeResult<> decode(ByteReader& buf) = 0;
+
+    // Amount of bytes the encoded packet takes up, used to reserve space before encoding it. See `ByteBuffer::encodedSize`
+    virtual size_t getEncodedSize() const = 0;
 
     virtual packetid_t getPacketId() const = 0;
     virtual bool getUseTcp() const = 0;
@@ -63,6 +73,18 @@ public:
             return static_cast<T*>(this);
         }
     }
+
+    // Keep the receive buffer alive for as long as this packet exists, so that borrowed fields stay valid
+    void setBackingBuffer(PacketBufferRef buffer) {
+        backingBuffer = std::move(buffer);
+    }
+
+    const PacketBufferRef& getBackingBuffer() const {
+        return backingBuffer;
+    }
+
+private:
+    PacketBufferRef backingBuffer;
 };
 
 struct PacketHeader {
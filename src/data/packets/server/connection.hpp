@@ -2,6 +2,7 @@
 #include <data/packets/packet.hpp>
 #include <data/types/crypto.hpp>
 #include <data/types/gd.hpp>
+#include <data/types/misc.hpp>
 #include <data/types/user.hpp>
 
 // 20000 - PingResponsePacket
@@ -21,8 +22,9 @@ class CryptoHandshakeResponsePacket : public Packet {
     CryptoHandshakeResponsePacket() {}
 
     CryptoPublicKey data;
+    CryptoNonceMode nonceMode;
 };
-GLOBED_SERIALIZABLE_STRUCT(CryptoHandshakeResponsePacket, (data));
+GLOBED_SERIALIZABLE_STRUCT(CryptoHandshakeResponsePacket, (data, nonceMode));
 
 // 20002 - KeepaliveResponsePacket
 class KeepaliveResponsePacket : public Packet {
@@ -31,8 +33,9 @@ class KeepaliveResponsePacket : public Packet {
     KeepaliveResponsePacket() {}
 
     uint32_t playerCount;
+    ClockSyncTimes times;
 };
-GLOBED_SERIALIZABLE_STRUCT(KeepaliveResponsePacket, (playerCount));
+GLOBED_SERIALIZABLE_STRUCT(KeepaliveResponsePacket, (playerCount, times));
 
 // 20003 - ServerDisconnectPacket
 class ServerDisconnectPacket : public Packet {
@@ -1,6 +1,8 @@
 #pragma once
 #include <data/packets/packet.hpp>
 #include <data/types/gd.hpp>
+#include <data/types/player_delta.hpp>
+#include <data/types/misc.hpp>
 
 // 22000 - PlayerProfilesPacket
 class PlayerProfilesPacket : public Packet {
@@ -19,11 +21,14 @@ class LevelDataPacket : public Packet {
 
     LevelDataPacket() {}
 
+    // when the server sent this packet, only for protocol 15 and up
+    ServerTimestamp serverTime;
+    PositionOrigin origin;
     std::vector<AssociatedPlayerData> players;
     std::optional<std::map<uint16_t, int>> customItems;
 };
 
-GLOBED_SERIALIZABLE_STRUCT(LevelDataPacket, (players, customItems));
+GLOBED_SERIALIZABLE_STRUCT(LevelDataPacket, (serverTime, origin, players, customItems));
 
 // 22002 - LevelPlayerMetadataPacket
 class LevelPlayerMetadataPacket : public Packet {
@@ -51,6 +56,23 @@ GLOBED_SERIALIZABLE_STRUCT(LevelInnerPlayerCountPacket, (count));
 # include <audio/frame.hpp>
 #endif
 
+// 22004 - LevelDataDeltaPacket
+class LevelDataDeltaPacket : public Packet {
+    GLOBED_PACKET(22004, LevelDataDeltaPacket, false, false)
+
+    LevelDataDeltaPacket() {}
+
+    // the newest of our own keyframes that the server has received
+    std::optional<uint8_t> ackedKeyframe;
+    // when the server sent this packet, only for protocol 15 and up
+    ServerTimestamp serverTime;
+    PositionOrigin origin;
+    std::vector<AssociatedPlayerDataFrame> players;
+    std::optional<std::map<uint16_t, int>> customItems;
+};
+
+GLOBED_SERIALIZABLE_STRUCT(LevelDataDeltaPacket, (ackedKeyframe, serverTime, origin, players, customItems));
+
 // 22010 - VoiceBroadcastPacket
 class VoiceBroadcastPacket : public Packet {
     GLOBED_PACKET(22010, VoiceBroadcastPacket, true, false)
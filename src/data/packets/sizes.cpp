@@ -0,0 +1,86 @@
+#include "all.hpp" // include all packets
+
+/*
+* Encoded sizes of packets, checked at compile time. `GameSocket::encodePacket` reserves space for a packet
+* with `Packet::getEncodedSize` before encoding it, for these packets that is just the constant below.
+* If one of these fails, a field was added or changed - update the size, and make sure it's intended.
+*/
+
+#define PACKET_SIZE(pt, size) static_assert(ByteBuffer::maxEncodedSize<pt>() == size, "encoded size of " #pt " has changed")
+#define PACKET_UNBOUNDED(pt) static_assert(ByteBuffer::maxEncodedSize<pt>() == ByteBuffer::UNBOUNDED_SIZE, #pt " is expected to have a variable size")
+
+// types with custom encoders
+
+static_assert(SpecificIconData::MAX_ENCODED_SIZE == 32);
+static_assert(PlayerData::MAX_ENCODED_SIZE == 77);
+static_assert(SpecificIconDelta::MAX_ENCODED_SIZE == 32);
+static_assert(PlayerDataDelta::MAX_ENCODED_SIZE == 76);
+static_assert(PlayerDataFrame::MAX_ENCODED_SIZE == 79);
+static_assert(GlobedCounterChange::MAX_ENCODED_SIZE == 7);
+
+// connection related
+
+PACKET_SIZE(PingPacket, 4);
+PACKET_SIZE(CryptoHandshakeStartPacket, 2 + CryptoBox::KEY_LEN + 1);
+// the clock sync times are only written on protocol 15 and up
+PACKET_SIZE(KeepalivePacket, 16);
+PACKET_UNBOUNDED(LoginPacket);
+PACKET_SIZE(ClaimThreadPacket, 4);
+PACKET_SIZE(DisconnectPacket, 0);
+PACKET_SIZE(KeepaliveTCPPacket, 0);
+PACKET_SIZE(SkipClaimThreadPacket, 0);
+PACKET_UNBOUNDED(ConnectionTestPacket);
+
+// general
+
+PACKET_SIZE(SyncIconsPacket, 9 * 2 + 6);
+PACKET_SIZE(RequestGlobalPlayerListPacket, 0);
+PACKET_SIZE(RequestLevelListPacket, 0);
+PACKET_UNBOUNDED(RequestPlayerCountPacket);
+PACKET_SIZE(UpdatePlayerStatusPacket, 1);
+PACKET_SIZE(LinkCodeRequestPacket, 0);
+PACKET_UNBOUNDED(NoticeReplyPacket);
+PACKET_UNBOUNDED(RequestMotdPacket);
+PACKET_UNBOUNDED(UpdateFriendListPacket);
+
+// game related
+
+PACKET_SIZE(RequestPlayerProfilesPacket, 4);
+PACKET_SIZE(LevelJoinPacket, 8 + 1 + 1 + 32);
+PACKET_SIZE(LevelLeavePacket, 0);
+
+// player data has a fixed part, followed by the counter changes (and acks for delta packets)
+PACKET_UNBOUNDED(PlayerDataPacket);
+static_assert(PlayerDataPacket::FIXED_ENCODED_SIZE == 8 + 77 + 9 + 1);
+PACKET_UNBOUNDED(PlayerDataDeltaPacket);
+static_assert(PlayerDataDeltaPacket::FIXED_ENCODED_SIZE == 8 + 79 + 2 + 9 + 1);
+
+PACKET_UNBOUNDED(ChatMessagePacket);
+
+// room related
+
+PACKET_UNBOUNDED(CreateRoomPacket);
+PACKET_UNBOUNDED(JoinRoomPacket);
+PACKET_SIZE(LeaveRoomPacket, 0);
+PACKET_SIZE(RequestRoomPlayerListPacket, 0);
+PACKET_SIZE(UpdateRoomSettingsPacket, 13);
+PACKET_SIZE(RoomSendInvitePacket, 4);
+PACKET_SIZE(RequestRoomListPacket, 0);
+PACKET_SIZE(CloseRoomPacket, 4);
+
+// admin related
+
+PACKET_UNBOUNDED(AdminAuthPacket);
+PACKET_UNBOUNDED(AdminSendNoticePacket);
+PACKET_UNBOUNDED(AdminDisconnectPacket);
+PACKET_UNBOUNDED(AdminGetUserStatePacket);
+PACKET_UNBOUNDED(AdminSendFeaturedLevelPacket);
+PACKET_UNBOUNDED(AdminUpdateUsernamePacket);
+PACKET_SIZE(AdminSetNameColorPacket, 4 + 3);
+PACKET_UNBOUNDED(AdminSetUserRolesPacket);
+PACKET_UNBOUNDED(AdminPunishUserPacket);
+PACKET_SIZE(AdminRemovePunishmentPacket, 5);
+PACKET_SIZE(AdminWhitelistPacket, 5);
+PACKET_UNBOUNDED(AdminSetAdminPasswordPacket);
+PACKET_UNBOUNDED(AdminEditPunishmentPacket);
+PACKET_SIZE(AdminGetPunishmentHistoryPacket, 4);
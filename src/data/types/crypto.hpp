@@ -16,3 +16,34 @@ public:
 };
 
 GLOBED_SERIALIZABLE_STRUCT(CryptoPublicKey, (key));
+
+// first protocol version where the crypto handshake negotiates the nonce mode of `CryptoBox`
+inline constexpr uint16_t COUNTER_NONCE_PROTOCOL = 15;
+
+// Nonce mode requested by the client or chosen by the server, always the last field of a handshake packet.
+// Older servers don't send it, which means `NonceMode::Random`.
+struct CryptoNonceMode {
+    static constexpr size_t MAX_ENCODED_SIZE = sizeof(CryptoBox::NonceMode);
+
+    CryptoBox::NonceMode mode = CryptoBox::NonceMode::Random;
+};
+
+template <>
+inline void ByteBuffer::customEncode<CryptoNonceMode>(const CryptoNonceMode& value) {
+    this->writeU8(static_cast<uint8_t>(value.mode));
+}
+
+template <>
+inline ByteReader::DecodeResult<CryptoNonceMode> ByteReader::customDecode<CryptoNonceMode>() {
+    if (this->getPosition() == this->size()) {
+        return Ok(CryptoNonceMode{});
+    }
+
+    GLOBED_UNWRAP_INTO(this->readU8(), uint8_t mode);
+
+    if (mode > static_cast<uint8_t>(CryptoBox::NonceMode::Counter)) {
+        return Err(DecodeError::InvalidEnumValue);
+    }
+
+    return Ok(CryptoNonceMode { static_cast<CryptoBox::NonceMode>(mode) });
+}
@@ -1,8 +1,123 @@
 #include "game.hpp"
 
 #include <data/bitbuffer.hpp>
+#include <util/math.hpp>
 
 using namespace cocos2d;
+using util::math::quantize;
+
+// Compact encoding of `SpecificIconData` (COMPACT_ICON_DATA_PROTOCOL and newer):
+//   u16: icon type (4 bits), flags (11 bits), whether spider teleport data follows (1 bit)
+//   u16: position is not an offset (1 bit), teleport is not an offset (1 bit), unused (2 bits), rotation (12 bits)
+//   position: i16 x, i16 y offset from the packet origin in 1/4 px, or f32 x, f32 y
+//   teleport: from and to as i16 offsets from the position in 1/4 px, or as f32 points
+constexpr float COMPACT_POSITION_SCALE = 4.f;
+constexpr float COMPACT_ROTATION_STEPS = 4096.f;
+constexpr uint16_t COMPACT_FULL_POSITION = 1 << 15;
+constexpr uint16_t COMPACT_FULL_TELEPORT = 1 << 14;
+constexpr uint16_t COMPACT_ROTATION_MASK = 0x0fff;
+
+template<> void ByteBuffer::customEncode(const PositionOrigin& origin) {
+    if (this->getProtocol() < COMPACT_ICON_DATA_PROTOCOL) return;
+
+    this->writeValue(origin.point);
+    this->setPositionOrigin(origin.point);
+}
+
+template<> ByteReader::DecodeResult<PositionOrigin> ByteReader::customDecode() {
+    if (this->getProtocol() < COMPACT_ICON_DATA_PROTOCOL) return Ok(PositionOrigin{});
+
+    GLOBED_UNWRAP_INTO(this->readValue<CCPoint>(), auto point);
+    this->setPositionOrigin(point);
+
+    return Ok(PositionOrigin { point });
+}
+
+// Write `point` as an offset from `origin`, or as a full point if it is too far away. Returns false in the latter case.
+static bool compactOffsetFits(const CCPoint& point, const CCPoint& origin) {
+    return quantize<int16_t>(point.x - origin.x, COMPACT_POSITION_SCALE) && quantize<int16_t>(point.y - origin.y, COMPACT_POSITION_SCALE);
+}
+
+static void writeCompactPoint(ByteBuffer& buf, const CCPoint& point, const CCPoint& origin, bool full) {
+    if (full) {
+        buf.writeValue(point);
+    } else {
+        buf.writeI16(*quantize<int16_t>(point.x - origin.x, COMPACT_POSITION_SCALE));
+        buf.writeI16(*quantize<int16_t>(point.y - origin.y, COMPACT_POSITION_SCALE));
+    }
+}
+
+static ByteReader::DecodeResult<CCPoint> readCompactPoint(ByteReader& buf, const CCPoint& origin, bool full) {
+    if (full) {
+        return buf.readValue<CCPoint>();
+    }
+
+    GLOBED_UNWRAP_INTO(buf.readI16(), int16_t x);
+    GLOBED_UNWRAP_INTO(buf.readI16(), int16_t y);
+
+    return Ok(CCPoint {
+        origin.x + x / COMPACT_POSITION_SCALE,
+        origin.y + y / COMPACT_POSITION_SCALE,
+    });
+}
+
+static void encodeCompactIconData(ByteBuffer& buf, const SpecificIconData& data) {
+    auto origin = buf.getPositionOrigin();
+
+    uint16_t flags = data.packFlags().contents() >> 5;
+    uint16_t header = (static_cast<uint16_t>(data.iconType) << 12) | (flags << 1) | (data.spiderTeleportData ? 1 : 0);
+
+    float rotation = std::fmod(data.rotation, 360.f);
+    if (rotation < 0.f) rotation += 360.f;
+
+    uint16_t rotationWord = static_cast<uint16_t>(std::round(rotation / 360.f * COMPACT_ROTATION_STEPS)) & COMPACT_ROTATION_MASK;
+
+    bool fullPosition = !compactOffsetFits(data.position, origin);
+    bool fullTeleport = data.spiderTeleportData && !(
+        compactOffsetFits(data.spiderTeleportData->from, data.position) && compactOffsetFits(data.spiderTeleportData->to, data.position)
+    );
+
+    if (fullPosition) rotationWord |= COMPACT_FULL_POSITION;
+    if (fullTeleport) rotationWord |= COMPACT_FULL_TELEPORT;
+
+    buf.writeU16(header);
+    buf.writeU16(rotationWord);
+    writeCompactPoint(buf, data.position, origin, fullPosition);
+
+    if (data.spiderTeleportData) {
+        writeCompactPoint(buf, data.spiderTeleportData->from, data.position, fullTeleport);
+        writeCompactPoint(buf, data.spiderTeleportData->to, data.position, fullTeleport);
+    }
+}
+
+static ByteReader::DecodeResult<SpecificIconData> decodeCompactIconData(ByteReader& buf) {
+    SpecificIconData data;
+
+    GLOBED_UNWRAP_INTO(buf.readU16(), uint16_t header);
+    GLOBED_UNWRAP_INTO(buf.readU16(), uint16_t rotationWord);
+
+    uint8_t iconType = header >> 12;
+    if (iconType > static_cast<uint8_t>(PlayerIconType::Jetpack)) {
+        return Err(ByteReader::DecodeError::InvalidEnumValue);
+    }
+
+    data.iconType = static_cast<PlayerIconType>(iconType);
+    data.unpackFlags(BitBuffer<16>(static_cast<uint16_t>(((header >> 1) & 0x7ff) << 5)));
+    data.rotation = (rotationWord & COMPACT_ROTATION_MASK) * 360.f / COMPACT_ROTATION_STEPS;
+
+    GLOBED_UNWRAP_INTO(readCompactPoint(buf, buf.getPositionOrigin(), rotationWord & COMPACT_FULL_POSITION), data.position);
+
+    if (header & 1) {
+        bool fullTeleport = rotationWord & COMPACT_FULL_TELEPORT;
+
+        SpiderTeleportData tp;
+        GLOBED_UNWRAP_INTO(readCompactPoint(buf, data.position, fullTeleport), tp.from);
+        GLOBED_UNWRAP_INTO(readCompactPoint(buf, data.position, fullTeleport), tp.to);
+        data.spiderTeleportData = tp;
+    }
+
+    return Ok(data);
+}
 
 template<>
 void ByteBuffer::customEncode<GlobedCounterChange>(const GlobedCounterChange& val) {
@@ -19,7 +134,7 @@ void ByteBuffer::customEncode<GlobedCounterChange>(const GlobedCounterChange& va
 }
 
 template <>
-ByteBuffer::DecodeResult<GlobedCounterChange> ByteBuffer::customDecode<GlobedCounterChange>() {
+ByteReader::DecodeResult<GlobedCounterChange> ByteReader::customDecode<GlobedCounterChange>() {
     using enum GlobedCounterChange::Type;
 
     GlobedCounterChange val;
@@ -51,31 +166,74 @@ void SpecificIconData::copyFlagsFrom(const SpecificIconData& other) {
     isSideways = other.isSideways;
 }
 
-template<> void ByteBuffer::customEncode(const SpecificIconData& data) {
-    this->writeValue(data.position);
-    this->writeValue(data.rotation);
-    this->writeValue(data.iconType);
+bool SpecificIconData::flagsEqual(const SpecificIconData& other) const {
+    return iconType == other.iconType && packFlags().contents() == other.packFlags().contents();
+}
 
+BitBuffer<16> SpecificIconData::packFlags() const {
     BitBuffer<16> bits;
     bits.writeBits(
-        data.isVisible,
-        data.isLookingLeft,
-        data.isUpsideDown,
-        data.isDashing,
-        data.isMini,
-        data.isGrounded,
-        data.isStationary,
-        data.isFalling,
-        data.didJustJump,
-        data.isRotating,
-        data.isSideways
+        isVisible,
+        isLookingLeft,
+        isUpsideDown,
+        isDashing,
+        isMini,
+        isGrounded,
+        isStationary,
+        isFalling,
+        didJustJump,
+        isRotating,
+        isSideways
     );
-    this->writeBits(bits);
+
+    return bits;
+}
+
+void SpecificIconData::unpackFlags(BitBuffer<16> bits) {
+    bits.readBitsInto(
+        isVisible,
+        isLookingLeft,
+        isUpsideDown,
+        isDashing,
+        isMini,
+        isGrounded,
+        isStationary,
+        isFalling,
+        didJustJump,
+        isRotating,
+        isSideways
+    );
+}
+
+BitBuffer<8> PlayerData::packFlags() const {
+    BitBuffer<8> bits;
+    bits.writeBits(isDead, isPaused, isPracticing, isDualMode, isInEditor, isEditorBuilding, isLastDeathReal);
+    return bits;
+}
+
+void PlayerData::unpackFlags(BitBuffer<8> bits) {
+    bits.readBitsInto(isDead, isPaused, isPracticing, isDualMode, isInEditor, isEditorBuilding, isLastDeathReal);
+}
+
+template<> void ByteBuffer::customEncode(const SpecificIconData& data) {
+    if (this->getProtocol() >= COMPACT_ICON_DATA_PROTOCOL) {
+        encodeCompactIconData(*this, data);
+        return;
+    }
+
+    this->writeValue(data.position);
+    this->writeValue(data.rotation);
+    this->writeValue(data.iconType);
+    this->writeBits(data.packFlags());
 
     this->writeValue(data.spiderTeleportData);
 }
 
-template<> ByteBuffer::DecodeResult<SpecificIconData> ByteBuffer::customDecode() {
+template<> ByteReader::DecodeResult<SpecificIconData> ByteReader::customDecode() {
+    if (this->getProtocol() >= COMPACT_ICON_DATA_PROTOCOL) {
+        return decodeCompactIconData(*this);
+    }
+
     SpecificIconData data;
 
     GLOBED_UNWRAP_INTO(this->readValue<CCPoint>(), data.position);
@@ -83,19 +241,7 @@ template<> ByteBuffer::DecodeResult<SpecificIconData> ByteBuffer::customDecode()
     GLOBED_UNWRAP_INTO(this->readValue<PlayerIconType>(), data.iconType);
 
     GLOBED_UNWRAP_INTO(this->readBits<16>(), auto bits);
-    bits.readBitsInto(
-        data.isVisible,
-        data.isLookingLeft,
-        data.isUpsideDown,
-        data.isDashing,
-        data.isMini,
-        data.isGrounded,
-        data.isStationary,
-        data.isFalling,
-        data.didJustJump,
-        data.isRotating,
-        data.isSideways
-    );
+    data.unpackFlags(bits);
 
     GLOBED_UNWRAP_INTO(this->readValue<std::optional<SpiderTeleportData>>(), data.spiderTeleportData);
 
@@ -109,12 +255,10 @@ template<> void ByteBuffer::customEncode(const PlayerData& data) {
     this->writeValue(data.deathCounter);
     this->writeValue(data.currentPercentage);
 
-    BitBuffer<8> bits;
-    bits.writeBits(data.isDead, data.isPaused, data.isPracticing, data.isDualMode, data.isInEditor, data.isEditorBuilding, data.isLastDeathReal);
-    this->writeBits(bits);
+    this->writeBits(data.packFlags());
 }
 
-template<> ByteBuffer::DecodeResult<PlayerData> ByteBuffer::customDecode() {
+template<> ByteReader::DecodeResult<PlayerData> ByteReader::customDecode() {
     PlayerData data;
 
     GLOBED_UNWRAP_INTO(this->readValue<float>(), data.timestamp);
@@ -124,7 +268,7 @@ template<> ByteBuffer::DecodeResult<PlayerData> ByteBuffer::customDecode() {
     GLOBED_UNWRAP_INTO(this->readValue<float>(), data.currentPercentage);
 
     GLOBED_UNWRAP_INTO(this->readBits<8>(), auto bits);
-    bits.readBitsInto(data.isDead, data.isPaused, data.isPracticing, data.isDualMode, data.isInEditor, data.isEditorBuilding, data.isLastDeathReal);
+    data.unpackFlags(bits);
 
     return Ok(data);
 }
@@ -16,6 +16,17 @@ enum class PlayerIconType : uint8_t {
 
 GLOBED_SERIALIZABLE_ENUM(PlayerIconType, Unknown, Cube, Ship, Ball, Ufo, Wave, Robot, Spider, Swing, Jetpack);
 
+// first protocol version that uses the compact encoding of `SpecificIconData`
+inline constexpr uint16_t COMPACT_ICON_DATA_PROTOCOL = 15;
+
+// Written at the start of packets that contain player positions. In the compact encoding,
+// positions that follow are stored as small fixed-point offsets from this point. Nothing is written for older protocols.
+struct PositionOrigin {
+    static constexpr size_t MAX_ENCODED_SIZE = ByteBuffer::maxEncodedSize<cocos2d::CCPoint>();
+
+    cocos2d::CCPoint point;
+};
+
 struct SpiderTeleportData {
     cocos2d::CCPoint from, to;
 };
@@ -28,6 +39,8 @@ struct GlobedCounterChange {
         Set = 0, Add = 1, Multiply = 2, Divide = 3
     };
 
+    static constexpr size_t MAX_ENCODED_SIZE = sizeof(uint16_t) + sizeof(Type) + sizeof(int);
+
     uint16_t itemId;
     Type type;
     union { int intVal; float floatVal; } _val;
@@ -36,7 +49,19 @@ struct GlobedCounterChange {
 GLOBED_SERIALIZABLE_ENUM(GlobedCounterChange::Type, Set, Add, Multiply, Divide);
 
 struct SpecificIconData {
+    // the legacy encoding, the compact one never takes more
+    static constexpr size_t MAX_ENCODED_SIZE =
+        ByteBuffer::maxEncodedSize<cocos2d::CCPoint>() // position
+        + sizeof(float)                                 // rotation
+        + sizeof(PlayerIconType)
+        + sizeof(BitBufferUnderlyingType<16>)           // flags
+        + ByteBuffer::maxEncodedSize<std::optional<SpiderTeleportData>>();
+
     void copyFlagsFrom(const SpecificIconData& other);
+    bool flagsEqual(const SpecificIconData& other) const;
+
+    BitBuffer<16> packFlags() const;
+    void unpackFlags(BitBuffer<16> bits);
 
     cocos2d::CCPoint position;
     float rotation;
@@ -58,6 +83,15 @@ struct SpecificIconData {
 };
 
 struct PlayerData {
+    static constexpr size_t MAX_ENCODED_SIZE =
+        sizeof(float)                                   // timestamp
+        + SpecificIconData::MAX_ENCODED_SIZE * 2
+        + sizeof(float) * 2                             // death counter and percentage
+        + sizeof(BitBufferUnderlyingType<8>);           // flags
+
+    BitBuffer<8> packFlags() const;
+    void unpackFlags(BitBuffer<8> bits);
+
     float timestamp;
 
     SpecificIconData player1;
@@ -4,6 +4,60 @@
 #include <data/bytebuffer.hpp>
 #include <cocos2d.h>
 
+// first protocol version where keepalives carry timestamps, for synchronizing our clock with the server's
+inline constexpr uint16_t CLOCK_SYNC_PROTOCOL = 15;
+
+// Timestamps of a keepalive exchange, in microseconds. The client sends its own clock in `clientTime`,
+// and the server answers with it echoed back and its own clock in `serverTime`. Nothing is written for older protocols.
+struct ClockSyncTimes {
+    static constexpr size_t MAX_ENCODED_SIZE = sizeof(uint64_t) * 2;
+
+    uint64_t clientTime = 0;
+    uint64_t serverTime = 0;
+};
+
+template <>
+inline void ByteBuffer::customEncode<ClockSyncTimes>(const ClockSyncTimes& value) {
+    if (this->getProtocol() < CLOCK_SYNC_PROTOCOL) return;
+
+    this->writeU64(value.clientTime);
+    this->writeU64(value.serverTime);
+}
+
+template <>
+inline ByteReader::DecodeResult<ClockSyncTimes> ByteReader::customDecode<ClockSyncTimes>() {
+    if (this->getProtocol() < CLOCK_SYNC_PROTOCOL) return Ok(ClockSyncTimes{});
+
+    GLOBED_UNWRAP_INTO(this->readU64(), uint64_t clientTime);
+    GLOBED_UNWRAP_INTO(this->readU64(), uint64_t serverTime);
+
+    return Ok(ClockSyncTimes { clientTime, serverTime });
+}
+
+// The server's clock (the same one as in `ClockSyncTimes`) at the time a packet was sent, in microseconds, 0 if unknown.
+// Nothing is written for older protocols.
+struct ServerTimestamp {
+    static constexpr size_t MAX_ENCODED_SIZE = sizeof(uint64_t);
+
+    uint64_t micros = 0;
+};
+
+template <>
+inline void ByteBuffer::customEncode<ServerTimestamp>(const ServerTimestamp& value) {
+    if (this->getProtocol() < CLOCK_SYNC_PROTOCOL) return;
+
+    this->writeU64(value.micros);
+}
+
+template <>
+inline ByteReader::DecodeResult<ServerTimestamp> ByteReader::customDecode<ServerTimestamp>() {
+    if (this->getProtocol() < CLOCK_SYNC_PROTOCOL) return Ok(ServerTimestamp{});
+
+    GLOBED_UNWRAP_INTO(this->readU64(), uint64_t micros);
+
+    return Ok(ServerTimestamp { micros });
+}
+
 class GameServerEntry {
 public:
     std::string id, name, address, region;
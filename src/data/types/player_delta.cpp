@@ -0,0 +1,381 @@
+#include "player_delta.hpp"
+
+#include <util/math.hpp>
+
+using namespace cocos2d;
+using util::math::quantize;
+
+SpecificIconDelta SpecificIconDelta::make(const SpecificIconData& base, const SpecificIconData& data) {
+    SpecificIconDelta delta;
+
+    auto dx = quantize<int16_t>(data.position.x - base.position.x, POSITION_SCALE);
+    auto dy = quantize<int16_t>(data.position.y - base.position.y, POSITION_SCALE);
+
+    if (!dx || !dy) {
+        delta.fields |= PositionFull;
+        delta.values.position = data.position;
+    } else if (*dx != 0 || *dy != 0) {
+        delta.fields |= Position;
+        delta.dx = *dx;
+        delta.dy = *dy;
+    }
+
+    auto drot = quantize<int16_t>(data.rotation - base.rotation, ROTATION_SCALE);
+
+    if (!drot) {
+        delta.fields |= RotationFull;
+        delta.values.rotation = data.rotation;
+    } else if (*drot != 0) {
+        delta.fields |= Rotation;
+        delta.drot = *drot;
+    }
+
+    // compared against the keyframe and not the previous frame, so one-shot flags like `didJustJump` get cleared again
+    if (!data.flagsEqual(base)) {
+        delta.fields |= Flags;
+        delta.values.copyFlagsFrom(data);
+    }
+
+    if (data.spiderTeleportData) {
+        delta.fields |= Teleport;
+        delta.values.spiderTeleportData = data.spiderTeleportData;
+    }
+
+    return delta;
+}
+
+SpecificIconData SpecificIconDelta::apply(const SpecificIconData& base) const {
+    SpecificIconData out = base;
+
+    if (fields & Position) {
+        out.position = base.position + CCPoint{dx / POSITION_SCALE, dy / POSITION_SCALE};
+    } else if (fields & PositionFull) {
+        out.position = values.position;
+    }
+
+    if (fields & Rotation) {
+        out.rotation = base.rotation + drot / ROTATION_SCALE;
+    } else if (fields & RotationFull) {
+        out.rotation = values.rotation;
+    }
+
+    if (fields & Flags) {
+        out.copyFlagsFrom(values);
+    }
+
+    // teleports only ever happen once, so never take it from the keyframe
+    out.spiderTeleportData = (fields & Teleport) ? values.spiderTeleportData : std::nullopt;
+
+    return out;
+}
+
+std::optional<PlayerDataDelta> PlayerDataDelta::make(const PlayerData& base, const PlayerData& data) {
+    float dts = std::round((data.timestamp - base.timestamp) * TIMESTAMP_SCALE);
+    if (!(dts >= 0.f && dts <= std::numeric_limits<uint16_t>::max())) {
+        return std::nullopt;
+    }
+
+    PlayerDataDelta delta;
+    delta.dtimestamp = static_cast<uint16_t>(dts);
+
+    delta.player1 = SpecificIconDelta::make(base.player1, data.player1);
+    if (delta.player1.fields != 0) {
+        delta.fields |= Player1;
+    }
+
+    // the second player is not shown outside of dual mode, so don't bother sending it
+    if (data.isDualMode) {
+        delta.player2 = SpecificIconDelta::make(base.player2, data.player2);
+        if (delta.player2.fields != 0) {
+            delta.fields |= Player2;
+        }
+    }
+
+    if (data.deathCounter != base.deathCounter) {
+        delta.fields |= DeathCounter;
+        delta.values.deathCounter = data.deathCounter;
+    }
+
+    if (data.currentPercentage != base.currentPercentage) {
+        delta.fields |= Percentage;
+        delta.values.currentPercentage = data.currentPercentage;
+    }
+
+    if (data.packFlags().contents() != base.packFlags().contents()) {
+        delta.fields |= State;
+        delta.values.unpackFlags(data.packFlags());
+    }
+
+    return delta;
+}
+
+PlayerData PlayerDataDelta::apply(const PlayerData& base) const {
+    PlayerData out = base;
+
+    out.timestamp = base.timestamp + dtimestamp / TIMESTAMP_SCALE;
+    out.player1 = player1.apply(base.player1);
+    out.player2 = player2.apply(base.player2);
+
+    if (fields & DeathCounter) {
+        out.deathCounter = values.deathCounter;
+    }
+
+    if (fields & Percentage) {
+        out.currentPercentage = values.currentPercentage;
+    }
+
+    if (fields & State) {
+        out.unpackFlags(values.packFlags());
+    }
+
+    return out;
+}
+
+/* PlayerDataDeltaEncoder */
+
+PlayerDataFrame PlayerDataDeltaEncoder::encode(const PlayerData& data) {
+    sinceKeyframe++;
+
+    // until the receiver acknowledges a keyframe, every frame is a keyframe
+    if (acked && sinceKeyframe < KEYFRAME_INTERVAL) {
+        if (auto delta = PlayerDataDelta::make(acked->data, data)) {
+            return PlayerDataFrame {
+                .keyframeId = acked->id,
+                .isKeyframe = false,
+                .delta = std::move(*delta),
+            };
+        }
+    }
+
+    sinceKeyframe = 0;
+
+    auto& kf = sent[sentCount % HISTORY];
+    kf.id = nextKeyframeId++;
+    kf.seq = sentCount++;
+    kf.data = data;
+
+    return PlayerDataFrame {
+        .keyframeId = kf.id,
+        .isKeyframe = true,
+        .keyframe = data,
+        .delta = {},
+    };
+}
+
+void PlayerDataDeltaEncoder::acknowledge(uint8_t keyframeId) {
+    size_t count = std::min(sentCount, HISTORY);
+
+    for (size_t i = 0; i < count; i++) {
+        auto& kf = sent[i];
+        if (kf.id != keyframeId) continue;
+
+        // acknowledgements can arrive out of order, never go back to an older keyframe
+        if (!acked || kf.seq > acked->seq) {
+            acked = kf;
+        }
+
+        return;
+    }
+}
+
+void PlayerDataDeltaEncoder::reset() {
+    sentCount = 0;
+    acked.reset();
+    nextKeyframeId = 0;
+    sinceKeyframe = 0;
+}
+
+/* PlayerDataDeltaDecoder */
+
+Result<PlayerData> PlayerDataDeltaDecoder::decode(const PlayerDataFrame& frame) {
+    if (frame.isKeyframe) {
+        received[receivedCount++ % received.size()] = Keyframe {
+            .id = frame.keyframeId,
+            .data = frame.keyframe,
+        };
+
+        // ids wrap around, treat anything in the next half of the range as newer
+        if (!latest || static_cast<int8_t>(frame.keyframeId - *latest) > 0) {
+            latest = frame.keyframeId;
+            acknowledged = false;
+        }
+
+        return Ok(frame.keyframe);
+    }
+
+    size_t count = std::min(receivedCount, received.size());
+
+    for (size_t i = 0; i < count; i++) {
+        if (received[i].id != frame.keyframeId) continue;
+
+        if (latest && frame.keyframeId == *latest) {
+            acknowledged = true;
+        }
+
+        return Ok(frame.delta.apply(received[i].data));
+    }
+
+    return Err(fmt::format("delta frame references unknown keyframe {}", frame.keyframeId));
+}
+
+std::optional<uint8_t> PlayerDataDeltaDecoder::latestKeyframe() const {
+    return latest;
+}
+
+bool PlayerDataDeltaDecoder::isAcknowledged() const {
+    return acknowledged;
+}
+
+void PlayerDataDeltaDecoder::reset() {
+    receivedCount = 0;
+    latest.reset();
+    acknowledged = false;
+}
+
+/* Encoding */
+
+template<> void ByteBuffer::customEncode(const SpecificIconDelta& data) {
+    using enum SpecificIconDelta::Fields;
+
+    this->writeU8(data.fields);
+
+    if (data.fields & Position) {
+        this->writeI16(data.dx);
+        this->writeI16(data.dy);
+    } else if (data.fields & PositionFull) {
+        this->writeValue(data.values.position);
+    }
+
+    if (data.fields & Rotation) {
+        this->writeI16(data.drot);
+    } else if (data.fields & RotationFull) {
+        this->writeF32(data.values.rotation);
+    }
+
+    if (data.fields & Flags) {
+        this->writeValue(data.values.iconType);
+        this->writeBits(data.values.packFlags());
+    }
+
+    if (data.fields & Teleport) {
+        this->writeValue(*data.values.spiderTeleportData);
+    }
+}
+
+template<> ByteReader::DecodeResult<SpecificIconDelta> ByteReader::customDecode() {
+    using enum SpecificIconDelta::Fields;
+
+    SpecificIconDelta data;
+
+    GLOBED_UNWRAP_INTO(this->readU8(), data.fields);
+
+    if (data.fields & Position) {
+        GLOBED_UNWRAP_INTO(this->readI16(), data.dx);
+        GLOBED_UNWRAP_INTO(this->readI16(), data.dy);
+    } else if (data.fields & PositionFull) {
+        GLOBED_UNWRAP_INTO(this->readValue<CCPoint>(), data.values.position);
+    }
+
+    if (data.fields & Rotation) {
+        GLOBED_UNWRAP_INTO(this->readI16(), data.drot);
+    } else if (data.fields & RotationFull) {
+        GLOBED_UNWRAP_INTO(this->readF32(), data.values.rotation);
+    }
+
+    if (data.fields & Flags) {
+        GLOBED_UNWRAP_INTO(this->readValue<PlayerIconType>(), data.values.iconType);
+        GLOBED_UNWRAP_INTO(this->readBits<16>(), auto bits);
+        data.values.unpackFlags(bits);
+    }
+
+    if (data.fields & Teleport) {
+        GLOBED_UNWRAP_INTO(this->readValue<SpiderTeleportData>(), data.values.spiderTeleportData);
+    }
+
+    return Ok(data);
+}
+
+template<> void ByteBuffer::customEncode(const PlayerDataDelta& data) {
+    using enum PlayerDataDelta::Fields;
+
+    this->writeU8(data.fields);
+    this->writeU16(data.dtimestamp);
+
+    if (data.fields & Player1) {
+        this->writeValue(data.player1);
+    }
+
+    if (data.fields & Player2) {
+        this->writeValue(data.player2);
+    }
+
+    if (data.fields & DeathCounter) {
+        this->writeF32(data.values.deathCounter);
+    }
+
+    if (data.fields & Percentage) {
+        this->writeF32(data.values.currentPercentage);
+    }
+
+    if (data.fields & State) {
+        this->writeBits(data.values.packFlags());
+    }
+}
+
+template<> ByteReader::DecodeResult<PlayerDataDelta> ByteReader::customDecode() {
+    using enum PlayerDataDelta::Fields;
+
+    PlayerDataDelta data;
+
+    GLOBED_UNWRAP_INTO(this->readU8(), data.fields);
+    GLOBED_UNWRAP_INTO(this->readU16(), data.dtimestamp);
+
+    if (data.fields & Player1) {
+        GLOBED_UNWRAP_INTO(this->readValue<SpecificIconDelta>(), data.player1);
+    }
+
+    if (data.fields & Player2) {
+        GLOBED_UNWRAP_INTO(this->readValue<SpecificIconDelta>(), data.player2);
+    }
+
+    if (data.fields & DeathCounter) {
+        GLOBED_UNWRAP_INTO(this->readF32(), data.values.deathCounter);
+    }
+
+    if (data.fields & Percentage) {
+        GLOBED_UNWRAP_INTO(this->readF32(), data.values.currentPercentage);
+    }
+
+    if (data.fields & State) {
+        GLOBED_UNWRAP_INTO(this->readBits<8>(), auto bits);
+        data.values.unpackFlags(bits);
+    }
+
+    return Ok(data);
+}
+
+template<> void ByteBuffer::customEncode(const PlayerDataFrame& data) {
+    this->writeBool(data.isKeyframe);
+    this->writeU8(data.keyframeId);
+
+    if (data.isKeyframe) {
+        this->writeValue(data.keyframe);
+    } else {
+        this->writeValue(data.delta);
+    }
+}
+
+template<> ByteReader::DecodeResult<PlayerDataFrame> ByteReader::customDecode() {
+    PlayerDataFrame data;
+
+    GLOBED_UNWRAP_INTO(this->readBool(), data.isKeyframe);
+    GLOBED_UNWRAP_INTO(this->readU8(), data.keyframeId);
+
+    if (data.isKeyframe) {
+        GLOBED_UNWRAP_INTO(this->readValue<PlayerData>(), data.keyframe);
+    } else {
+        GLOBED_UNWRAP_INTO(this->readValue<PlayerDataDelta>(), data.delta);
+    }
+
+    return Ok(data);
+}
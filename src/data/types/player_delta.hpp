@@ -0,0 +1,161 @@
+#pragma once
+#include "game.hpp"
+
+#include <algorithm>
+#include <array>
+
+/*
+* Delta coding of `PlayerData`, used by `PlayerDataDeltaPacket` and `LevelDataDeltaPacket`.
+*
+* Every frame is either a keyframe, holding the full `PlayerData`, or a delta against a keyframe that the receiver
+* has acknowledged. Deltas never depend on other deltas, so losing a packet only loses that one frame.
+*/
+
+struct SpecificIconDelta {
+    static constexpr float POSITION_SCALE = 8.f;  // 1/8 of a pixel
+    static constexpr float ROTATION_SCALE = 16.f; // 1/16 of a degree
+
+    // every field present, with full position and rotation
+    static constexpr size_t MAX_ENCODED_SIZE =
+        sizeof(uint8_t)                                 // fields
+        + ByteBuffer::maxEncodedSize<cocos2d::CCPoint>()
+        + sizeof(float)
+        + sizeof(PlayerIconType) + sizeof(BitBufferUnderlyingType<16>)
+        + ByteBuffer::maxEncodedSize<SpiderTeleportData>();
+
+    enum Fields : uint8_t {
+        Position = 1 << 0,      // quantized offset from the keyframe position
+        PositionFull = 1 << 1,  // too far from the keyframe for the offset to fit, full position is sent
+        Rotation = 1 << 2,
+        RotationFull = 1 << 3,
+        Flags = 1 << 4,         // icon type and all the boolean flags
+        Teleport = 1 << 5,
+    };
+
+    static SpecificIconDelta make(const SpecificIconData& base, const SpecificIconData& data);
+    SpecificIconData apply(const SpecificIconData& base) const;
+
+    uint8_t fields = 0;
+    int16_t dx = 0, dy = 0, drot = 0;
+
+    // full values for the fields that are not sent as offsets
+    SpecificIconData values{};
+};
+
+struct PlayerDataDelta {
+    static constexpr float TIMESTAMP_SCALE = 10000.f; // 0.1 ms
+
+    static constexpr size_t MAX_ENCODED_SIZE =
+        sizeof(uint8_t) + sizeof(uint16_t)              // fields and timestamp
+        + SpecificIconDelta::MAX_ENCODED_SIZE * 2
+        + sizeof(float) * 2                             // death counter and percentage
+        + sizeof(BitBufferUnderlyingType<8>);           // flags
+
+    enum Fields : uint8_t {
+        Player1 = 1 << 0,
+        Player2 = 1 << 1,
+        DeathCounter = 1 << 2,
+        Percentage = 1 << 3,
+        State = 1 << 4,
+    };
+
+    // Returns nullopt if `data` is too far ahead of `base` to be sent as a delta, in that case a keyframe must be sent.
+    static std::optional<PlayerDataDelta> make(const PlayerData& base, const PlayerData& data);
+    PlayerData apply(const PlayerData& base) const;
+
+    uint8_t fields = 0;
+    uint16_t dtimestamp = 0;
+    SpecificIconDelta player1, player2;
+
+    // full values for the fields that are not sent as offsets
+    PlayerData values{};
+};
+
+// A single frame of a delta coded player data stream
+struct PlayerDataFrame {
+    static constexpr size_t MAX_ENCODED_SIZE =
+        sizeof(bool) + sizeof(uint8_t)
+        + std::max(PlayerData::MAX_ENCODED_SIZE, PlayerDataDelta::MAX_ENCODED_SIZE);
+
+    // for keyframes, the id of this keyframe. For deltas, the id of the keyframe it is based on
+    uint8_t keyframeId = 0;
+    bool isKeyframe = true;
+
+    PlayerData keyframe{};
+    PlayerDataDelta delta;
+};
+
+class AssociatedPlayerDataFrame {
+public:
+    int accountId;
+    PlayerDataFrame frame;
+};
+
+GLOBED_SERIALIZABLE_STRUCT(AssociatedPlayerDataFrame, (
+    accountId, frame
+));
+
+// Tells the sender which keyframe of this player was received
+struct PlayerKeyframeAck {
+    int accountId;
+    uint8_t keyframeId;
+};
+
+GLOBED_SERIALIZABLE_STRUCT(PlayerKeyframeAck, (
+    accountId, keyframeId
+));
+
+// Sending side of a delta coded stream.
+class PlayerDataDeltaEncoder {
+public:
+    // frames between two keyframes, a new keyframe also moves the base of the following deltas forward
+    static constexpr size_t KEYFRAME_INTERVAL = 30;
+    // amount of sent keyframes that can still be acknowledged
+    static constexpr size_t HISTORY = 8;
+
+    PlayerDataFrame encode(const PlayerData& data);
+
+    // Called when the receiver confirms it got the keyframe with this id
+    void acknowledge(uint8_t keyframeId);
+
+    void reset();
+
+private:
+    struct Keyframe {
+        uint8_t id;
+        size_t seq; // increases with every keyframe, unlike the id it never wraps around
+        PlayerData data;
+    };
+
+    std::array<Keyframe, HISTORY> sent{};
+    size_t sentCount = 0;
+    std::optional<Keyframe> acked;
+    uint8_t nextKeyframeId = 0;
+    size_t sinceKeyframe = 0;
+};
+
+// Receiving side of a delta coded stream.
+class PlayerDataDeltaDecoder {
+public:
+    // Fails if the frame is a delta against a keyframe that was never received (or is too old)
+    Result<PlayerData> decode(const PlayerDataFrame& frame);
+
+    // The newest keyframe received so far, this is what should be acknowledged to the sender
+    std::optional<uint8_t> latestKeyframe() const;
+
+    // Returns true if the sender is known to have received our acknowledgement, meaning it does not need to be resent
+    bool isAcknowledged() const;
+
+    void reset();
+
+private:
+    struct Keyframe {
+        uint8_t id;
+        PlayerData data;
+    };
+
+    std::array<Keyframe, PlayerDataDeltaEncoder::HISTORY> received{};
+    size_t receivedCount = 0;
+    std::optional<uint8_t> latest;
+    bool acknowledged = false;
+};
@@ -4,6 +4,9 @@
 /*
 * GLOBED_SOCKET_POLL - poll function
 * GLOBED_SOCKET_POLLFD - pollfd structure
+* GLOBED_SOCKET_MMSG - defined if recvmmsg/sendmmsg are available
+* GLOBED_SOCKET_EPOLL - defined if epoll is available
+* GLOBED_SOCKET_KQUEUE - defined if kqueue is available
 */
 
 #ifdef GEODE_IS_WINDOWS
@@ -17,3 +20,10 @@
 # define GLOBED_SOCKET_POLLFD struct pollfd
 
 #endif
+
+#if defined(GEODE_IS_ANDROID) || defined(__linux__)
+# define GLOBED_SOCKET_MMSG 1
+# define GLOBED_SOCKET_EPOLL 1
+#elif defined(GEODE_IS_MACOS) || defined(GEODE_IS_IOS)
+# define GLOBED_SOCKET_KQUEUE 1
+#endif
@@ -5,28 +5,48 @@
 #include <util/math.hpp>
 #include <util/debug.hpp>
 #include <util/format.hpp>
+#include <util/simd.hpp>
 
 using namespace geode::prelude;
 
 PlayerInterpolator::PlayerInterpolator(const InterpolatorSettings& settings) : settings(settings) {}
 
 void PlayerInterpolator::addPlayer(int playerId) {
-    players.emplace(playerId, PlayerState {});
+    if (slots.emplace(playerId, players.size()).second) {
+        players.emplace_back();
+        playerIds.push_back(playerId);
+    }
+
 #ifdef GLOBED_DEBUG_INTERPOLATION
     LerpLogger::get().reset(playerId);
 #endif
 }
 
 void PlayerInterpolator::removePlayer(int playerId) {
-    players.erase(playerId);
+    auto it = slots.find(playerId);
+    if (it == slots.end()) return;
+
+    size_t slot = it->second;
+    slots.erase(it);
+
+    // fill the hole with the last player
+    size_t last = players.size() - 1;
+    if (slot != last) {
+        players[slot] = std::move(players[last]);
+        playerIds[slot] = playerIds[last];
+        slots[playerIds[slot]] = slot;
+    }
+
+    players.pop_back();
+    playerIds.pop_back();
 }
 
 bool PlayerInterpolator::hasPlayer(int playerId) {
-    return players.contains(playerId);
+    return slots.contains(playerId);
 }
 
 void PlayerInterpolator::updatePlayer(int playerId, const PlayerData& data, float updateCounter) {
-    auto& player = players.at(playerId);
+    auto& player = this->playerAt(playerId);
     player.updateCounter = updateCounter;
     player.pendingRealFrame = true;
     player.totalFrames++;
@@ -46,6 +66,10 @@ void PlayerInterpolator::updatePlayer(int playerId, const PlayerData& data, floa
 
 #ifdef GLOBED_DEBUG_INTERPOLATION
     LerpLogger::get().logRealFrame(playerId, updateCounter, data.timestamp, data.player1);
+
+    player.legacyOlder = player.legacyNewer;
+    player.legacyNewer = data;
+    player.legacyTimeCounter = player.legacyOlder.timestamp;
 #endif
 
     if (settings.realtime) {
@@ -53,10 +77,43 @@ void PlayerInterpolator::updatePlayer(int playerId, const PlayerData& data, floa
         return;
     }
 
-    player.olderFrame = player.newerFrame;
-    player.newerFrame = data;
+    // the player restarted the level, none of the old snapshots are any good
+    if (player.snapshotCount > 0 && data.timestamp < player.snapshot(player.snapshotCount - 1).timestamp - REWIND_THRESHOLD) {
+        player.snapshotCount = 0;
+    }
+
+#ifdef GLOBED_DEBUG_INTERPOLATION
+    // compare what we showed while the data was late with where the player really was
+    if (player.extrapolatedFrom >= 0.f && player.snapshotCount >= 2 && data.timestamp > player.snapshot(player.snapshotCount - 1).timestamp) {
+        VisualPlayerState predicted;
+        this->extrapolate(player, data.timestamp, predicted);
+
+        LerpLogger::get().logExtrapolatedRealFrame(playerId, updateCounter, data.timestamp, data.timestamp, data.player1, predicted.player1);
+    }
+#endif
+
+    bool first = player.snapshotCount == 0;
+
+    // a duplicate or a snapshot too old to keep says nothing about the current delay, so it must not move the estimates
+    if (!player.insertSnapshot(data)) return;
+
+    // transit time of the snapshot, plus the difference between the two clocks
+    float transit = updateCounter - data.timestamp;
+
+    if (first) {
+        player.clockOffset = -transit;
+        player.lastTransit = transit;
+        player.playoutTime = data.timestamp - settings.minDelay;
+    } else {
+        // RFC 3550 style jitter, a late or reordered snapshot shows up as a big difference in transit times
+        player.jitter += (std::abs(transit - player.lastTransit) - player.jitter) / 16.f;
+        player.lastTransit = transit;
+        player.clockOffset += (-transit - player.clockOffset) / 16.f;
+    }
+}
 
-    player.timeCounter = player.olderFrame.timestamp;
+void PlayerInterpolator::keepPlayer(int playerId, float updateCounter) {
+    this->playerAt(playerId).updateCounter = updateCounter;
 }
 
 static inline void lerpSpecific(
@@ -66,16 +123,29 @@ static inline void lerpSpecific(
         float lerpRatio
     ) {
 
-    out.copyFlagsFrom(older);
-
     // i hate spider
-    if (out.iconType == PlayerIconType::Spider && std::abs(older.position.y - newer.position.y) >= 33.f) {
+    if (older.iconType == PlayerIconType::Spider && std::abs(older.position.y - newer.position.y) >= 33.f) {
         out.position.x = std::lerp(older.position.x, newer.position.x, lerpRatio);
         out.position.y = older.position.y;
     } else {
         out.position = older.position.lerp(newer.position, lerpRatio);
     }
-    out.rotation = std::lerp(older.rotation, newer.rotation, lerpRatio);
+    // rotation may wrap around between frames, so take the shorter way
+    out.rotation = older.rotation + util::math::angleDifference(older.rotation, newer.rotation) * lerpRatio;
+}
+
+// everything that isn't interpolated is taken from the older state
+static inline void copyState(const VisualPlayerState& older, VisualPlayerState& out) {
+    out.player1.copyFlagsFrom(older.player1);
+    out.player2.copyFlagsFrom(older.player2);
+
+    out.currentPercentage = older.currentPercentage;
+    out.isDead = older.isDead;
+    out.isPaused = older.isPaused;
+    out.isPracticing = older.isPracticing;
+    out.isDualMode = older.isDualMode;
+    out.isInEditor = older.isInEditor;
+    out.isEditorBuilding = older.isEditorBuilding;
 }
 
 static inline void lerpPlayer(
@@ -88,13 +158,94 @@ static inline void lerpPlayer(
     lerpSpecific(older.player1, newer.player1, out.player1, lerpRatio);
     lerpSpecific(older.player2, newer.player2, out.player2, lerpRatio);
 
-    out.currentPercentage = older.currentPercentage;
-    out.isDead = older.isDead;
-    out.isPaused = older.isPaused;
-    out.isPracticing = older.isPracticing;
-    out.isDualMode = older.isDualMode;
-    out.isInEditor = older.isInEditor;
-    out.isEditorBuilding = older.isEditorBuilding;
+    copyState(older, out);
+}
+
+// fallback for when the gravity can't be measured yet, roughly what a normal size cube falls with
+constexpr static float DEFAULT_GRAVITY = 2600.f;
+// anything above this is a jump or a bounce rather than gravity
+constexpr static float MAX_GRAVITY = 6000.f;
+
+static inline bool hasGravity(PlayerIconType type) {
+    switch (type) {
+        case PlayerIconType::Cube:
+        case PlayerIconType::Ball:
+        case PlayerIconType::Robot:
+        case PlayerIconType::Spider:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// vertical acceleration over three consecutive snapshots, if the player was in the air the whole time
+static std::optional<float> measureAcceleration(
+        const SpecificIconData& a, float ta,
+        const SpecificIconData& b, float tb,
+        const SpecificIconData& c, float tc
+    ) {
+
+    if (a.isGrounded || b.isGrounded || c.isGrounded) return std::nullopt;
+    if (a.iconType != c.iconType || b.iconType != c.iconType) return std::nullopt;
+    if (a.isUpsideDown != c.isUpsideDown || b.isUpsideDown != c.isUpsideDown) return std::nullopt;
+    if (tb <= ta || tc <= tb) return std::nullopt;
+
+    float v1 = (b.position.y - a.position.y) / (tb - ta);
+    float v2 = (c.position.y - b.position.y) / (tc - tb);
+    float accel = 2.f * (v2 - v1) / (tc - ta);
+
+    return std::clamp(accel, -MAX_GRAVITY, MAX_GRAVITY);
+}
+
+// predict where the player is `time` seconds after `last`, from how it moved between `prev` and `last`
+static inline void extrapolateSpecific(
+        const SpecificIconData& prev,
+        const SpecificIconData& last,
+        float interval,
+        float time,
+        bool platformer,
+        std::optional<float> measuredAccel,
+        SpecificIconData& out
+    ) {
+
+    // a gamemode change, a teleport or a hidden player can't be predicted, hold the last position
+    if (!last.isVisible || prev.iconType != last.iconType || last.spiderTeleportData || interval <= 0.f) {
+        return;
+    }
+
+    float vx = (last.position.x - prev.position.x) / interval;
+    float vy = (last.position.y - prev.position.y) / interval;
+    float accel = 0.f;
+
+    if (platformer && last.isStationary) {
+        vx = 0.f;
+    }
+
+    if (last.isGrounded) {
+        vy = 0.f;
+    } else if (last.iconType == PlayerIconType::Ship || last.iconType == PlayerIconType::Wave) {
+        // both fly in straight lines until the player changes their input
+    } else if (measuredAccel) {
+        accel = *measuredAccel;
+    } else if (hasGravity(last.iconType)) {
+        accel = last.isUpsideDown ? DEFAULT_GRAVITY : -DEFAULT_GRAVITY;
+    }
+
+    // the spider teleports instead of falling
+    if (last.iconType == PlayerIconType::Spider && std::abs(last.position.y - prev.position.y) >= 33.f) {
+        vy = 0.f;
+        accel = 0.f;
+    }
+
+    // the measured velocity is the average over the interval, move it to the time of the last snapshot
+    vy += accel * interval / 2.f;
+
+    out.position.x = last.position.x + vx * time;
+    out.position.y = last.position.y + vy * time + accel * time * time / 2.f;
+
+    if (last.isRotating) {
+        out.rotation = last.rotation + util::math::angleDifference(prev.rotation, last.rotation) / interval * time;
+    }
 }
 
 void PlayerInterpolator::tick(float dt) {
@@ -106,32 +257,188 @@ void PlayerInterpolator::tick(float dt) {
         return;
     }
 
-    auto localTs = localTsRes.value();
+    this->tick(dt, localTsRes.value());
+}
+
+void PlayerInterpolator::tick(float dt, float localTs) {
+    if (settings.realtime) return;
+
+    batch.clear();
 
-    for (auto& [playerId, player] : players) {
-        if (player.totalFrames < 2) continue;
+    for (size_t slot = 0; slot < players.size(); slot++) {
+        auto& player = players[slot];
+        int playerId = playerIds[slot];
 
-        float frameDelta = player.newerFrame.timestamp - player.olderFrame.timestamp;
-        if (frameDelta == 0.f) {
-            LerpLogger::get().logLerpSkip(playerId, localTs, player.timeCounter, player.interpolatedState.player1);
-            continue;
+#ifdef GLOBED_DEBUG_INTERPOLATION
+        float legacyDelta = player.legacyNewer.timestamp - player.legacyOlder.timestamp;
+        if (player.totalFrames >= 2 && legacyDelta != 0.f) {
+            VisualPlayerState legacyState;
+            float legacyRatio = (player.legacyTimeCounter - player.legacyOlder.timestamp) / legacyDelta;
+            lerpPlayer(player.legacyOlder.visual, player.legacyNewer.visual, legacyState, legacyRatio);
+
+            LerpLogger::get().logLegacyLerpOperation(playerId, localTs, player.legacyTimeCounter, legacyState.player1);
         }
 
-        float lerpRatio = (player.timeCounter - player.olderFrame.timestamp) / frameDelta;
-        lerpPlayer(player.olderFrame.visual, player.newerFrame.visual, player.interpolatedState, lerpRatio);
+        player.legacyTimeCounter += dt;
+#endif
+
+        if (player.snapshotCount == 0) continue;
 
-        LerpLogger::get().logLerpOperation(playerId, localTs, player.timeCounter, player.interpolatedState.player1);
+        // the playout clock is steered towards running `delay` behind the player's estimated current time,
+        // by speeding up or slowing down a little, so the movement stays smooth
+        float delay = this->getPlayoutDelay(player);
+        float target = localTs + player.clockOffset - delay;
+        float error = target - player.playoutTime;
 
-        player.timeCounter += dt;
+        if (std::abs(error) > SNAP_THRESHOLD) {
+            player.playoutTime = target;
+        } else {
+            player.playoutTime += dt * (1.f + std::clamp(error * CATCHUP_GAIN, -MAX_CATCHUP, MAX_CATCHUP));
+        }
+
+        LerpLogger::get().logPlayout(playerId, localTs, player.playoutTime, delay, player.jitter);
+
+        auto& oldest = player.snapshot(0);
+        auto& newest = player.snapshot(player.snapshotCount - 1);
+
+        // the shown positions before this tick, including the correction
+        CCPoint prevP1 = player.interpolatedState.player1.position;
+        CCPoint prevP2 = player.interpolatedState.player2.position;
+        float prevExtrapolatedFrom = player.extrapolatedFrom;
+
+        player.extrapolatedFrom = -1.f;
+
+        if (player.playoutTime >= newest.timestamp && settings.extrapolation && player.snapshotCount >= 2 && !newest.visual.isDead) {
+            // the data is late, keep the player moving for a little while
+            float time = std::min(player.playoutTime, newest.timestamp + settings.maxExtrapolation);
+            this->extrapolate(player, time, player.interpolatedState);
+            player.extrapolatedFrom = newest.timestamp;
+
+            LerpLogger::get().logLerpOperation(playerId, localTs, player.playoutTime, player.interpolatedState.player1);
+
+            this->applyCorrection(player, prevP1, prevP2, prevExtrapolatedFrom >= 0.f && prevExtrapolatedFrom != newest.timestamp, dt);
+        } else if (player.playoutTime <= oldest.timestamp || player.playoutTime >= newest.timestamp) {
+            // nothing to interpolate between, hold the closest snapshot
+            auto& held = player.playoutTime <= oldest.timestamp ? oldest : newest;
+            lerpPlayer(held.visual, held.visual, player.interpolatedState, 0.f);
+
+            LerpLogger::get().logLerpSkip(playerId, localTs, player.playoutTime, player.interpolatedState.player1);
+
+            this->applyCorrection(player, prevP1, prevP2, prevExtrapolatedFrom >= 0.f, dt);
+        } else {
+            // the playout time is usually between the newest snapshots
+            size_t i = player.snapshotCount - 1;
+            while (i > 0 && player.snapshot(i - 1).timestamp > player.playoutTime) {
+                i--;
+            }
+
+            auto& older = player.snapshot(i - 1);
+            auto& newer = player.snapshot(i);
+
+            // positions are written once the whole batch is interpolated
+            float lerpRatio = (player.playoutTime - older.timestamp) / (newer.timestamp - older.timestamp);
+            copyState(older.visual, player.interpolatedState);
+            batch.push(slot, older.visual, newer.visual, lerpRatio, prevExtrapolatedFrom >= 0.f);
+        }
     }
+
+    if (batch.players.empty()) return;
+
+    batch.out.resize(batch.from.size());
+    util::simd::lerp(batch.from.data(), batch.to.data(), batch.ratio.data(), batch.out.data(), batch.out.size());
+
+    for (size_t i = 0; i < batch.players.size(); i++) {
+        size_t slot = batch.players[i];
+        auto& player = players[slot];
+        auto& state = player.interpolatedState;
+        const float* lanes = batch.out.data() + i * 6;
+
+        CCPoint prevP1 = state.player1.position;
+        CCPoint prevP2 = state.player2.position;
+
+        state.player1.position = CCPoint{lanes[0], lanes[1]};
+        state.player1.rotation = lanes[2];
+        state.player2.position = CCPoint{lanes[3], lanes[4]};
+        state.player2.rotation = lanes[5];
+
+        LerpLogger::get().logLerpOperation(playerIds[slot], localTs, player.playoutTime, state.player1);
+
+        this->applyCorrection(player, prevP1, prevP2, batch.wasExtrapolated[i], dt);
+    }
+}
+
+void PlayerInterpolator::applyCorrection(PlayerState& player, CCPoint prevP1, CCPoint prevP2, bool correct, float dt) {
+    // once newer data replaces an extrapolation, the player would jump from the predicted position to the real one.
+    // start from where it was shown instead, and fade the difference out
+    if (correct) {
+        player.p1Correction = prevP1 - player.interpolatedState.player1.position;
+        player.p2Correction = prevP2 - player.interpolatedState.player2.position;
+
+        if (player.p1Correction.getLength() > MAX_CORRECTION) player.p1Correction = CCPoint{0.f, 0.f};
+        if (player.p2Correction.getLength() > MAX_CORRECTION) player.p2Correction = CCPoint{0.f, 0.f};
+    } else {
+        float decay = std::exp(-dt / CORRECTION_TIME);
+        player.p1Correction = player.p1Correction * decay;
+        player.p2Correction = player.p2Correction * decay;
+    }
+
+    player.interpolatedState.player1.position = player.interpolatedState.player1.position + player.p1Correction;
+    player.interpolatedState.player2.position = player.interpolatedState.player2.position + player.p2Correction;
+}
+
+void PlayerInterpolator::setExtrapolation(bool state) {
+    settings.extrapolation = state;
+}
+
+void PlayerInterpolator::extrapolate(PlayerState& player, float time, VisualPlayerState& out) {
+    auto& prev = player.snapshot(player.snapshotCount - 2);
+    auto& last = player.snapshot(player.snapshotCount - 1);
+
+    float interval = last.timestamp - prev.timestamp;
+    float ahead = std::clamp(time - last.timestamp, 0.f, settings.maxExtrapolation);
+
+    std::optional<float> p1Accel, p2Accel;
+    if (player.snapshotCount >= 3) {
+        auto& first = player.snapshot(player.snapshotCount - 3);
+        p1Accel = measureAcceleration(first.visual.player1, first.timestamp, prev.visual.player1, prev.timestamp, last.visual.player1, last.timestamp);
+        p2Accel = measureAcceleration(first.visual.player2, first.timestamp, prev.visual.player2, prev.timestamp, last.visual.player2, last.timestamp);
+    }
+
+    lerpPlayer(last.visual, last.visual, out, 0.f);
+    extrapolateSpecific(prev.visual.player1, last.visual.player1, interval, ahead, settings.isPlatformer, p1Accel, out.player1);
+    extrapolateSpecific(prev.visual.player2, last.visual.player2, interval, ahead, settings.isPlatformer, p2Accel, out.player2);
+}
+
+float PlayerInterpolator::getPlayoutDelay(const PlayerState& player) {
+    // a snapshot can be up to one update old before the next one arrives, and may arrive later than usual by a few times the jitter.
+    // the delay can't reach back further than the stored snapshots either
+    float maxDelay = std::min(settings.maxDelay, settings.expectedDelta * (SNAPSHOT_COUNT - 2));
+    float delay = settings.expectedDelta + 3.f * player.jitter;
+
+    return std::clamp(delay, std::min(settings.minDelay, maxDelay), maxDelay);
 }
 
 VisualPlayerState& PlayerInterpolator::getPlayerState(int playerId) {
-    return players.at(playerId).interpolatedState;
+    return this->playerAt(playerId).interpolatedState;
 }
 
 FrameFlags PlayerInterpolator::swapFrameFlags(int playerId) {
-    auto& state = players.at(playerId);
+    return this->swapFrameFlagsAt(slots.at(playerId));
+}
+
+std::optional<size_t> PlayerInterpolator::getSlot(int playerId) {
+    auto it = slots.find(playerId);
+    if (it == slots.end()) return std::nullopt;
+
+    return it->second;
+}
+
+VisualPlayerState& PlayerInterpolator::getPlayerStateAt(size_t slot) {
+    return players[slot].interpolatedState;
+}
+
+FrameFlags PlayerInterpolator::swapFrameFlagsAt(size_t slot) {
+    auto& state = players[slot];
     FrameFlags out;
     out.pendingDeath = util::misc::swapFlag(state.frameFlags.pendingDeath);
     out.pendingRealDeath = util::misc::swapFlag(state.frameFlags.pendingRealDeath);
@@ -145,9 +452,12 @@ FrameFlags PlayerInterpolator::swapFrameFlags(int playerId) {
 }
 
 bool PlayerInterpolator::isPlayerStale(int playerId, float lastServerPacket) {
-    auto uc = players.at(playerId).updateCounter;
+    auto uc = this->playerAt(playerId).updateCounter;
+
+    // with a low tickrate, a couple of updates take longer than the usual timeout
+    float timeout = std::max(STALE_TIMEOUT, settings.expectedDelta * STALE_UPDATES);
 
-    return uc != 0.f && std::abs(uc - lastServerPacket) > 0.5f;
+    return uc != 0.f && std::abs(uc - lastServerPacket) > timeout;
 }
 
 std::optional<float> PlayerInterpolator::getLocalTs() {
@@ -159,6 +469,68 @@ std::optional<float> PlayerInterpolator::getLocalTs() {
     return bgl->m_fields->timeCounter;
 }
 
+PlayerInterpolator::PlayerState& PlayerInterpolator::playerAt(int playerId) {
+    return players[slots.at(playerId)];
+}
+
+void PlayerInterpolator::LerpBatch::clear() {
+    from.clear();
+    to.clear();
+    ratio.clear();
+    players.clear();
+    wasExtrapolated.clear();
+}
+
+void PlayerInterpolator::LerpBatch::push(size_t slot, const VisualPlayerState& older, const VisualPlayerState& newer, float lerpRatio, bool extrapolated) {
+    auto lane = [&](float f, float t) {
+        from.push_back(f);
+        to.push_back(t);
+        ratio.push_back(lerpRatio);
+    };
+
+    for (auto [o, n] : {std::pair{&older.player1, &newer.player1}, std::pair{&older.player2, &newer.player2}}) {
+        lane(o->position.x, n->position.x);
+
+        // same as in `lerpSpecific`, the spider doesn't move vertically between two frames it teleported between
+        bool spiderTeleport = o->iconType == PlayerIconType::Spider && std::abs(o->position.y - n->position.y) >= 33.f;
+        lane(o->position.y, spiderTeleport ? o->position.y : n->position.y);
+
+        lane(o->rotation, o->rotation + util::math::angleDifference(o->rotation, n->rotation));
+    }
+
+    players.push_back(slot);
+    wasExtrapolated.push_back(extrapolated);
+}
+
+PlayerInterpolator::LerpFrame& PlayerInterpolator::PlayerState::snapshot(size_t i) {
+    return snapshots[(snapshotStart + i) % SNAPSHOT_COUNT];
+}
+
+bool PlayerInterpolator::PlayerState::insertSnapshot(const PlayerData& data) {
+    for (size_t i = 0; i < snapshotCount; i++) {
+        if (this->snapshot(i).timestamp == data.timestamp) return false;
+    }
+
+    if (snapshotCount == SNAPSHOT_COUNT) {
+        if (data.timestamp < this->snapshot(0).timestamp) return false;
+
+        // drop the oldest one
+        snapshotStart = (snapshotStart + 1) % SNAPSHOT_COUNT;
+        snapshotCount--;
+    }
+
+    size_t i = snapshotCount++;
+    this->snapshot(i) = data;
+
+    // snapshots mostly arrive in order, so this rarely moves anything
+    while (i > 0 && this->snapshot(i - 1).timestamp > this->snapshot(i).timestamp) {
+        std::swap(this->snapshot(i - 1), this->snapshot(i));
+        i--;
+    }
+
+    return true;
+}
+
 PlayerInterpolator::LerpFrame::LerpFrame() {
     timestamp = 0.f;
     visual = {};
@@ -3,10 +3,17 @@
 #include "visual_state.hpp"
 #include <data/types/game.hpp>
 
+#include <array>
+#include <vector>
+
 struct InterpolatorSettings {
     bool realtime;      // no interpolation at all
     bool isPlatformer;  // platformer duh
     float expectedDelta;
+    float minDelay;     // how far behind the newest data players are shown at the very least, the delay grows with jitter from here
+    float maxDelay;     // upper bound for the adaptive delay
+    bool extrapolation; // predict movement past the newest snapshot instead of freezing, can be changed with `setExtrapolation`
+    float maxExtrapolation; // how far past the newest snapshot movement is predicted at most, in seconds
 };
 
 class GLOBED_DLL PlayerInterpolator {
@@ -25,8 +32,16 @@ public:
     // Update the last known state of the player. Should be called only when new data is received.
     void updatePlayer(int playerId, const PlayerData& data, float updateCounter);
 
+    // Mark the player as still present on the level without giving it new data, so it does not become stale.
+    void keepPlayer(int playerId, float updateCounter);
+
     // Interpolate the player state. Should preferrably be called every frame.
     void tick(float dt);
+    // Same as `tick`, but with the local time counter given instead of taken from the level, so it can run outside of one
+    void tick(float dt, float localTs);
+
+    // Enable or disable extrapolation, takes effect on the next tick.
+    void setExtrapolation(bool state);
 
     // Get the current interpolated visual state of the player. This is what you pass into `RemotePlayer::updateData`
     VisualPlayerState& getPlayerState(int playerId);
@@ -34,17 +49,62 @@ public:
     // returns `true` if death animation needs to be played and sets the flag back to false (so next call won't return `true` again)
     FrameFlags swapFrameFlags(int playerId);
 
-    // returns `true` if the given time of the last packet doesn't match the last update time of the player
+    // Slot of the player in the interpolator, for the `...At` functions which skip the lookup by id.
+    // Slots stay valid until a player is removed
+    std::optional<size_t> getSlot(int playerId);
+    VisualPlayerState& getPlayerStateAt(size_t slot);
+    FrameFlags swapFrameFlagsAt(size_t slot);
+
+    // returns `true` if the player wasn't in the level data for a while before the packet sent at `lastServerPacket`
     bool isPlayerStale(int playerId, float lastServerPacket);
 
     // returns nullopt if we are out of the level
     std::optional<float> getLocalTs();
 
 private:
-    std::unordered_map<int, PlayerState> players;
+    // players are stored densely so a tick walks contiguous memory, `slots` maps ids to indices in `players`.
+    // removing a player moves the last one into its slot
+    std::vector<PlayerState> players;
+    std::vector<int> playerIds;
+    std::unordered_map<int, size_t> slots;
     InterpolatorSettings settings;
 
-    constexpr static bool EXTRAPOLATION = false;
+    // lerps gathered during a tick and ran through `util::simd::lerp` at once, 6 lanes per player
+    // (x, y and rotation of both icons). kept between ticks so nothing is allocated once they are big enough
+    struct LerpBatch {
+        std::vector<float> from, to, ratio, out;
+        std::vector<size_t> players;
+        // whether the player was extrapolated before this tick, to correct the error afterwards
+        std::vector<bool> wasExtrapolated;
+
+        void clear();
+        void push(size_t slot, const VisualPlayerState& older, const VisualPlayerState& newer, float ratio, bool wasExtrapolated);
+    } batch;
+
+    // how many snapshots are kept for every player, a second at 30 tps. also limits the playout delay
+    constexpr static size_t SNAPSHOT_COUNT = 32;
+    // the playout clock runs at most this much faster or slower than real time to catch up with its target
+    constexpr static float MAX_CATCHUP = 0.1f;
+    // playout speed change per second of distance from the target
+    constexpr static float CATCHUP_GAIN = 2.0f;
+    // if the playout clock is further than this from its target, it jumps there instead
+    constexpr static float SNAP_THRESHOLD = 0.5f;
+    // timestamps going back by more than this mean that the player restarted the level
+    constexpr static float REWIND_THRESHOLD = 1.0f;
+    // the error of a wrong extrapolation is faded out over roughly this long, instead of making the player jump
+    constexpr static float CORRECTION_TIME = 0.1f;
+    // errors larger than this are not faded out, the player most likely died or teleported
+    constexpr static float MAX_CORRECTION = 90.f;
+    // a player missing from the level data for this long (or this many updates, if that's longer) has left the level
+    constexpr static float STALE_TIMEOUT = 0.5f;
+    constexpr static float STALE_UPDATES = 4.f;
+
+    PlayerState& playerAt(int playerId);
+    float getPlayoutDelay(const PlayerState& player);
+    // fade out the difference between an extrapolated and the real position, or start doing so if `correct` is true
+    void applyCorrection(PlayerState& player, cocos2d::CCPoint prevP1, cocos2d::CCPoint prevP2, bool correct, float dt);
+    // predict the state at `time` from the two newest snapshots, at most `maxExtrapolation` past the newest one
+    void extrapolate(PlayerState& player, float time, VisualPlayerState& out);
 
 public:
 
@@ -58,13 +118,39 @@ public:
 
     struct PlayerState {
         float updateCounter = 0.0f;
-        float timeCounter = 0.0f;
         float deathCounter = 0.0f;
         size_t totalFrames = 0;
 
-        LerpFrame olderFrame, newerFrame;
+        // ring of the last received snapshots, ordered by timestamp (oldest first) even if they arrived out of order
+        std::array<LerpFrame, SNAPSHOT_COUNT> snapshots;
+        size_t snapshotStart = 0, snapshotCount = 0;
+
+        // the point of the player's timeline that is currently shown, runs behind the newest snapshot by the playout delay
+        float playoutTime = 0.0f;
+        // estimated difference between the player's timestamps and our time counter
+        float clockOffset = 0.0f;
+        // interarrival jitter of the snapshots, in seconds
+        float jitter = 0.0f;
+        float lastTransit = 0.0f;
+
+        // timestamp of the snapshot the shown state was extrapolated from, negative if it wasn't extrapolated
+        float extrapolatedFrom = -1.0f;
+        // added to the shown positions after an extrapolation turned out to be wrong, fades out over time
+        cocos2d::CCPoint p1Correction, p2Correction;
+
         VisualPlayerState interpolatedState;
         bool pendingRealFrame = false;
         FrameFlags frameFlags;
+
+#ifdef GLOBED_DEBUG_INTERPOLATION
+        // the old interpolation between the last two received frames, ran alongside for comparison in the lerp logs
+        LerpFrame legacyOlder, legacyNewer;
+        float legacyTimeCounter = 0.0f;
+#endif
+
+        // `i` is 0 for the oldest snapshot
+        LerpFrame& snapshot(size_t i);
+        // insert a snapshot in order, returns false if it's a duplicate or older than every stored one in a full ring
+        bool insertSnapshot(const PlayerData& data);
     };
 };
\ No newline at end of file
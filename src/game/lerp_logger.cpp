@@ -9,6 +9,8 @@ void LerpLogger::reset(uint32_t id) {
     player.realExtrapolatedFrames.clear();
     player.lerpedFrames.clear();
     player.lerpSkippedFrames.clear();
+    player.legacyLerpedFrames.clear();
+    player.playout.clear();
 #endif
 }
 
@@ -43,6 +45,25 @@ void LerpLogger::logLerpSkip(uint32_t id, float localts, float timeCounter, cons
 #endif
 }
 
+void LerpLogger::logLegacyLerpOperation(uint32_t id, float localts, float timeCounter, const SpecificIconData& data) {
+#ifdef GLOBED_DEBUG_INTERPOLATION
+    auto& player = this->ensureExists(id);
+    player.legacyLerpedFrames.push_back(this->makeLogData(data, localts, timeCounter));
+#endif
+}
+
+void LerpLogger::logPlayout(uint32_t id, float localts, float playoutTime, float delay, float jitter) {
+#ifdef GLOBED_DEBUG_INTERPOLATION
+    auto& player = this->ensureExists(id);
+    player.playout.push_back(PlayoutLogData {
+        .localTimestamp = localts,
+        .playoutTime = playoutTime,
+        .delay = delay,
+        .jitter = jitter,
+    });
+#endif
+}
+
 PlayerLog& LerpLogger::ensureExists(uint32_t id) {
 #ifdef GLOBED_DEBUG_INTERPOLATION
     if (!players.contains(id)) {
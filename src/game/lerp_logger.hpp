@@ -13,15 +13,26 @@ struct PlayerLogData {
     float rotation;
 };
 
+struct PlayoutLogData {
+    float localTimestamp;
+    float playoutTime;
+    float delay;
+    float jitter;
+};
+
 struct PlayerLog {
     std::vector<PlayerLogData> realFrames;
     std::vector<std::pair<PlayerLogData, PlayerLogData>> realExtrapolatedFrames;
     std::vector<PlayerLogData> lerpedFrames;
     std::vector<PlayerLogData> lerpSkippedFrames;
+    // what the old two frame interpolation would have shown, to compare against
+    std::vector<PlayerLogData> legacyLerpedFrames;
+    std::vector<PlayoutLogData> playout;
 };
 
 GLOBED_SERIALIZABLE_STRUCT(PlayerLogData, (localTimestamp, timestamp, position, rotation));
-GLOBED_SERIALIZABLE_STRUCT(PlayerLog, (realFrames, realExtrapolatedFrames, lerpedFrames, lerpSkippedFrames));
+GLOBED_SERIALIZABLE_STRUCT(PlayoutLogData, (localTimestamp, playoutTime, delay, jitter));
+GLOBED_SERIALIZABLE_STRUCT(PlayerLog, (realFrames, realExtrapolatedFrames, lerpedFrames, lerpSkippedFrames, legacyLerpedFrames, playout));
 
 class LerpLogger : public SingletonBase<LerpLogger> {
 public:
@@ -34,6 +45,10 @@ public:
     // interpolated frames logging
     void logLerpOperation(uint32_t player, float localts, float timeCounter, const SpecificIconData& data);
     void logLerpSkip(uint32_t player, float localts, float timeCounter, const SpecificIconData& data);
+    void logLegacyLerpOperation(uint32_t player, float localts, float timeCounter, const SpecificIconData& data);
+
+    // playout clock logging
+    void logPlayout(uint32_t player, float localts, float playoutTime, float delay, float jitter);
 
     void makeDump(const std::filesystem::path path);
 
@@ -1,6 +1,8 @@
 #include "collision.hpp"
 #include <hooks/gjbasegamelayer.hpp>
 
+#include <algorithm>
+
 using namespace geode::prelude;
 
 void CollisionModule::loadLevelSettingsPre() {
@@ -36,28 +38,72 @@ static bool shouldCorrectCollision(const CCRect& p1, const CCRect& p2, CCPoint&
 void CollisionModule::checkCollisions(PlayerObject* player, float dt, bool p2) {
     bool isSecond = player == gameLayer->m_player2;
 
-    for (const auto& [_, rp] : gameLayer->m_fields->players) {
-        auto* p1 = rp->player1->getPlayerObject();
-        auto* p2 = rp->player2->getPlayerObject();
+    this->clearStickyState(isSecond);
+
+    if (gridOutdated) {
+        this->rebuildGrid();
+    }
+
+    hits.clear();
+    grid.query(player->getObjectRect(), [&](uint32_t value) {
+        hits.push_back(value);
+    });
+
+    // same order every step, and the first player object of a remote player before its second one
+    std::sort(hits.begin(), hits.end());
+
+    auto& players = gameLayer->m_fields->players;
+
+    for (uint32_t value : hits) {
+        int playerId = gridPlayers[value / 2];
+
+        // may have left since the grid was built
+        auto it = players.find(playerId);
+        if (it == players.end()) continue;
+
+        ComplexVisualPlayer* remote = (value % 2) ? it->second->player2 : it->second->player1;
+
+        if (this->collideWith(player, dt, remote->getPlayerObject())) {
+            isSecond ? remote->setP2StickyState(true) : remote->setP1StickyState(true);
+            stickyPlayers[isSecond].push_back(playerId);
+        }
+    }
+}
+
+// returns whether our player got moved vertically, and should stick to the other player
+bool CollisionModule::collideWith(PlayerObject* player, float dt, PlayerObject* other) {
+    auto& playerRect = player->getObjectRect();
+    auto& otherRect = other->getObjectRect();
+
+    if (!playerRect.intersectsRect(otherRect)) {
+        return false;
+    }
+
+    CCRect collRect = otherRect;
 
-        auto& p1Rect = p1->getObjectRect();
-        auto& p2Rect = p2->getObjectRect();
+    auto prev = player->getPosition();
+    player->collidedWithObject(dt, other, collRect, false);
+    auto displacement = player->getPosition() - prev;
 
-        auto& playerRect = player->getObjectRect();
+    // log::debug("intersect, displacement: {}", displacement);
 
-        CCRect p1CollRect = p1Rect;
-        CCRect p2CollRect = p2Rect;
+    bool shouldRevert = shouldCorrectCollision(playerRect, otherRect, displacement);
+
+    if (shouldRevert) {
+        player->setPosition(player->getPosition() + displacement);
+    }
 
-        constexpr float padding = 2.f;
+    return std::abs(displacement.y) > 0.001f;
+}
 
-        // p1CollRect.origin += CCPoint{padding, padding};
-        // p1CollRect.size -= CCSize{padding * 2, padding * 2};
+void CollisionModule::clearStickyState(bool isSecond) {
+    auto& players = gameLayer->m_fields->players;
 
-        // p2CollRect.origin += CCPoint{padding, padding};
-        // p2CollRect.size -= CCSize{padding * 2, padding * 2};
+    for (int playerId : stickyPlayers[isSecond]) {
+        auto it = players.find(playerId);
+        if (it == players.end()) continue;
 
-        bool intersectsP1 = playerRect.intersectsRect(p1CollRect);
-        bool intersectsP2 = playerRect.intersectsRect(p2CollRect);
+        auto* rp = it->second;
 
         if (isSecond) {
             rp->player1->setP2StickyState(false);
@@ -66,43 +112,30 @@ void CollisionModule::checkCollisions(PlayerObject* player, float dt, bool p2) {
             rp->player1->setP1StickyState(false);
             rp->player2->setP1StickyState(false);
         }
+    }
 
-        if (intersectsP1) {
-            auto prev = player->getPosition();
-            player->collidedWithObject(dt, p1, p1CollRect, false);
-            auto displacement = player->getPosition() - prev;
-
-            // log::debug("p1 intersect, displacement: {}", displacement);
-
-            bool shouldRevert = shouldCorrectCollision(playerRect, p1Rect, displacement);
-
-            if (shouldRevert) {
-                player->setPosition(player->getPosition() + displacement);
-            }
-
-            if (std::abs(displacement.y) > 0.001f) {
-                isSecond ? rp->player1->setP2StickyState(true) : rp->player1->setP1StickyState(true);
-            }
-        }
+    stickyPlayers[isSecond].clear();
+}
 
-        if (intersectsP2) {
-            auto prev = player->getPosition();
-            player->collidedWithObject(dt, p2, p2CollRect, false);
-            auto displacement = player->getPosition() - prev;
+void CollisionModule::selUpdate(float dt) {
+    gridOutdated = true;
+}
 
-            // log::debug("p2 intersect, displacement: {}", displacement);
+void CollisionModule::rebuildGrid() {
+    gridOutdated = false;
 
-            bool shouldRevert = shouldCorrectCollision(playerRect, p2Rect, displacement);
+    grid.clear();
+    gridPlayers.clear();
 
-            if (shouldRevert) {
-                player->setPosition(player->getPosition() + displacement);
-            }
+    for (const auto& [playerId, rp] : gameLayer->m_fields->players) {
+        uint32_t idx = static_cast<uint32_t>(gridPlayers.size());
+        gridPlayers.push_back(playerId);
 
-            if (std::abs(displacement.y) > 0.001f) {
-                isSecond ? rp->player2->setP2StickyState(true) : rp->player2->setP1StickyState(true);
-            }
-        }
+        grid.insert(rp->player1->getPlayerObject()->getObjectRect(), idx * 2);
+        grid.insert(rp->player2->getPlayerObject()->getObjectRect(), idx * 2 + 1);
     }
+
+    grid.build();
 }
 
 bool CollisionModule::shouldSaveProgress() {
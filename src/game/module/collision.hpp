@@ -2,6 +2,7 @@
 
 #include "base.hpp"
 #include <defs/platform.hpp>
+#include <game/spatial_grid.hpp>
 
 class GLOBED_DLL CollisionModule : public BaseGameplayModule {
 public:
@@ -13,7 +14,23 @@ public:
 
     bool shouldSaveProgress() override;
 
+    void selUpdate(float dt) override;
+
 private:
     bool lastPlat = false;
     int lastLength = 0;
+
+    // remote players only move in selUpdate, so the grid is rebuilt once per frame, on the first physics step after it,
+    // and every physics step only tests the players near it
+    SpatialGrid grid;
+    bool gridOutdated = true;
+    // grid values are an index into this times two, plus one for the second player object
+    std::vector<int> gridPlayers;
+    std::vector<uint32_t> hits;
+    // remote players whose sticky state was set for our player 1 and player 2, so it can be cleared on the next step
+    std::vector<int> stickyPlayers[2];
+
+    void rebuildGrid();
+    bool collideWith(PlayerObject* player, float dt, PlayerObject* other);
+    void clearStickyState(bool isSecond);
 };
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "spatial_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace geode::prelude;
+
+// far beyond any level, rects further out than this are treated as oversized
+constexpr float MAX_COORD = 10'000'000.f;
+
+// cells `[first, second]` overlapping `[min, max]` along one axis, empty if outside of the grid
+static std::pair<int32_t, int32_t> axisRange(float min, float max, float origin, float invCellSize, int32_t count) {
+    float lo = (min - origin) * invCellSize;
+    float hi = (max - origin) * invCellSize;
+
+    // also catches nan
+    if (!(hi >= 0.f && lo < static_cast<float>(count))) {
+        return {0, -1};
+    }
+
+    hi = std::min(hi, static_cast<float>(count - 1));
+
+    // both are positive now, so truncating is the same as flooring
+    return {lo > 0.f ? static_cast<int32_t>(lo) : 0, static_cast<int32_t>(hi)};
+}
+
+SpatialGrid::SpatialGrid(float cellSize) : baseCellSize(cellSize) {}
+
+void SpatialGrid::clear() {
+    entries.clear();
+    cells.clear();
+    oversized.clear();
+}
+
+void SpatialGrid::insert(const CCRect& rect, uint32_t value) {
+    entries.push_back(Entry {
+        .minX = rect.getMinX(),
+        .minY = rect.getMinY(),
+        .maxX = rect.getMaxX(),
+        .maxY = rect.getMaxY(),
+        .value = value,
+        .next = -1,
+    });
+}
+
+void SpatialGrid::build() {
+    cells.clear();
+    oversized.clear();
+    maxWidth = 0.f;
+    maxHeight = 0.f;
+
+    // the area covered by the bottom left corners
+    float minX = std::numeric_limits<float>::max(), minY = minX;
+    float maxX = std::numeric_limits<float>::lowest(), maxY = maxX;
+    size_t placed = 0;
+
+    for (uint32_t idx = 0; idx < entries.size(); idx++) {
+        auto& entry = entries[idx];
+
+        float width = entry.maxX - entry.minX;
+        float height = entry.maxY - entry.minY;
+
+        // also catches nan and infinity
+        if (!(width <= baseCellSize && height <= baseCellSize && std::abs(entry.minX) < MAX_COORD && std::abs(entry.minY) < MAX_COORD)) {
+            entry.next = OVERSIZED;
+            oversized.push_back(idx);
+            continue;
+        }
+
+        entry.next = -1;
+        placed++;
+
+        minX = std::min(minX, entry.minX);
+        minY = std::min(minY, entry.minY);
+        maxX = std::max(maxX, entry.minX);
+        maxY = std::max(maxY, entry.minY);
+        maxWidth = std::max(maxWidth, width);
+        maxHeight = std::max(maxHeight, height);
+    }
+
+    if (placed == 0) return;
+
+    // a few cells per entry at most, so clearing and walking the cells never costs more than the entries themselves
+    uint64_t maxCells = std::max<uint64_t>(64, placed * 4);
+    float cellSize = baseCellSize;
+
+    while (true) {
+        // rounded the same way as everything else, so no corner can end up past the last cell
+        invCellSize = 1.f / cellSize;
+        columns = static_cast<int32_t>((maxX - minX) * invCellSize) + 1;
+        rows = static_cast<int32_t>((maxY - minY) * invCellSize) + 1;
+
+        if (static_cast<uint64_t>(columns) * static_cast<uint64_t>(rows) <= maxCells) break;
+
+        cellSize *= 2.f;
+    }
+
+    originX = minX;
+    originY = minY;
+
+    cells.assign(static_cast<size_t>(columns) * rows, -1);
+
+    for (uint32_t idx = 0; idx < entries.size(); idx++) {
+        auto& entry = entries[idx];
+        if (entry.next == OVERSIZED) continue;
+
+        // the corner is never below the origin, so truncating is the same as flooring
+        int32_t cx = static_cast<int32_t>((entry.minX - originX) * invCellSize);
+        int32_t cy = static_cast<int32_t>((entry.minY - originY) * invCellSize);
+
+        auto& head = cells[cy * columns + cx];
+        entry.next = head;
+        head = static_cast<int32_t>(idx);
+    }
+}
+
+size_t SpatialGrid::size() const {
+    return entries.size();
+}
+
+SpatialGrid::CellRange SpatialGrid::cellRange(float minX, float minY, float maxX, float maxY) const {
+    auto [firstColumn, lastColumn] = axisRange(minX, maxX, originX, invCellSize, columns);
+    auto [firstRow, lastRow] = axisRange(minY, maxY, originY, invCellSize, rows);
+
+    return CellRange {
+        .minX = firstColumn,
+        .minY = firstRow,
+        .maxX = lastColumn,
+        .maxY = lastRow,
+    };
+}
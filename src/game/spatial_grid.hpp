@@ -0,0 +1,93 @@
+#pragma once
+#include <defs/geode.hpp>
+
+#include <vector>
+
+/*
+* Uniform grid over level coordinates, for finding which rects are near a given rect without testing all of them.
+* Rects are added with `insert` and become queryable once `build` is called, the grid is meant to be rebuilt from scratch
+* every frame.
+*
+* The grid only covers the area the rects are in, and every rect is only stored in the cell of its bottom left corner,
+* queries look further left and down by the size of the largest rect instead. If the rects are spread out so far
+* that the grid would need too many cells, the cells are made larger. Rects larger than a cell (or with broken coordinates)
+* are kept aside and tested by every query. Nothing is allocated once warm.
+*/
+class GLOBED_DLL SpatialGrid {
+public:
+    // about three times the size of a player, so a query touches 1 to 4 cells
+    static constexpr float DEFAULT_CELL_SIZE = 90.f;
+
+    SpatialGrid(float cellSize = DEFAULT_CELL_SIZE);
+
+    // remove all entries
+    void clear();
+    // add a rect, `value` is what gets passed back from `query`. not visible to queries until `build`
+    void insert(const cocos2d::CCRect& rect, uint32_t value);
+    // sort the inserted entries into their cells
+    void build();
+
+    // calls `func(uint32_t value)` once for every entry whose rect intersects `rect`, in no particular order
+    template <typename F>
+    void query(const cocos2d::CCRect& rect, F&& func) const {
+        for (auto idx : oversized) {
+            this->visit(idx, rect, func);
+        }
+
+        if (cells.empty()) return;
+
+        auto [minX, minY, maxX, maxY] = this->cellRange(rect.getMinX() - maxWidth, rect.getMinY() - maxHeight, rect.getMaxX(), rect.getMaxY());
+
+        for (int32_t cy = minY; cy <= maxY; cy++) {
+            for (int32_t cx = minX; cx <= maxX; cx++) {
+                for (int32_t idx = cells[cy * columns + cx]; idx >= 0; idx = entries[idx].next) {
+                    this->visit(idx, rect, func);
+                }
+            }
+        }
+    }
+
+    size_t size() const;
+
+private:
+    static constexpr int32_t OVERSIZED = -2;
+
+    struct Entry {
+        float minX, minY, maxX, maxY;
+        uint32_t value;
+        // next entry in the same cell, -1 at the end of the list, `OVERSIZED` if not in a cell
+        int32_t next;
+    };
+
+    // inclusive, empty if `minX > maxX`
+    struct CellRange {
+        int32_t minX, minY, maxX, maxY;
+    };
+
+    float baseCellSize;
+    float invCellSize = 0.f;
+    float originX = 0.f, originY = 0.f;
+    int32_t columns = 0, rows = 0;
+    // size of the largest entry that is in a cell
+    float maxWidth = 0.f;
+    float maxHeight = 0.f;
+
+    std::vector<Entry> entries;
+    // first entry in every cell, -1 if it is empty. row by row, starting at the bottom left
+    std::vector<int32_t> cells;
+    std::vector<uint32_t> oversized;
+
+    CellRange cellRange(float minX, float minY, float maxX, float maxY) const;
+
+    template <typename F>
+    void visit(uint32_t idx, const cocos2d::CCRect& rect, F& func) const {
+        auto& entry = entries[idx];
+
+        // inclusive on the edges, same as `CCRect::intersectsRect`
+        if (entry.maxX < rect.getMinX() || rect.getMaxX() < entry.minX || entry.maxY < rect.getMinY() || rect.getMaxY() < entry.minY) {
+            return;
+        }
+
+        func(entry.value);
+    }
+};
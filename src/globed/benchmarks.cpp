@@ -0,0 +1,1881 @@
+#include "benchmarks.hpp"
+
+#include <data/packets/client/game.hpp>
+#include <data/packets/client/general.hpp>
+#include <data/packets/server/game.hpp>
+#include <data/packets/server/general.hpp>
+#include <net/listener_table.hpp>
+#include <net/address.hpp>
+#include <net/game_socket.hpp>
+#include <net/reactor.hpp>
+#include <net/udp_socket.hpp>
+#include <game/interpolator.hpp>
+#include <game/spatial_grid.hpp>
+#include <util/debug.hpp>
+#include <util/math.hpp>
+#include <util/net.hpp>
+#include <util/simd.hpp>
+
+#include <crypto/box.hpp>
+#include <audio/frame_pool.hpp>
+#include <audio/jitter_buffer.hpp>
+#include <audio/manager.hpp>
+#include <audio/mixer.hpp>
+#include <audio/sample_queue.hpp>
+
+#include <asp/time/Instant.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <random>
+
+#ifdef GEODE_IS_WINDOWS
+# include <Ws2tcpip.h>
+#else
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <arpa/inet.h>
+# include <unistd.h>
+# include <poll.h>
+#endif
+
+using namespace geode::prelude;
+using namespace asp::time;
+
+namespace globed::bench {
+    // Simple udp echo server on the loopback interface, running on its own thread
+    class LoopbackEchoServer {
+    public:
+        LoopbackEchoServer() {
+            sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = 0;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            if (::bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                log::warn("Echo server failed to bind: {}", util::net::lastErrorString());
+                return;
+            }
+
+            socklen_t len = sizeof(addr);
+            ::getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &len);
+            port = ntohs(addr.sin_port);
+
+            thread = std::thread([this] { this->run(); });
+        }
+
+        ~LoopbackEchoServer() {
+            stopped = true;
+
+            if (thread.joinable()) {
+                thread.join();
+            }
+
+#ifdef GEODE_IS_WINDOWS
+            ::closesocket(sock);
+#else
+            ::close(sock);
+#endif
+        }
+
+        uint16_t getPort() const {
+            return port;
+        }
+
+    private:
+#ifdef GEODE_IS_WINDOWS
+        SOCKET sock;
+#else
+        int sock;
+#endif
+        uint16_t port = 0;
+        std::atomic_bool stopped = false;
+        std::thread thread;
+
+        void run() {
+            char buf[2048];
+
+            while (!stopped) {
+                GLOBED_SOCKET_POLLFD fd;
+                fd.fd = sock;
+                fd.events = POLLIN;
+
+                if (GLOBED_SOCKET_POLL(&fd, 1, 10) <= 0) continue;
+
+                sockaddr_in source;
+                socklen_t addrLen = sizeof(source);
+
+                int len = recvfrom(sock, buf, sizeof(buf), 0, reinterpret_cast<sockaddr*>(&source), &addrLen);
+                if (len <= 0) continue;
+
+                sendto(sock, buf, len, 0, reinterpret_cast<sockaddr*>(&source), addrLen);
+            }
+        }
+    };
+
+    void runAll() {
+        log::debug("==== Running benchmarks ====");
+        udpThroughput();
+        encodePackets();
+        decodePackets();
+        bulkVectors();
+        sendLatency();
+        dispatchListeners();
+        playerDataSize();
+        compactIconData();
+        cryptoThroughput();
+        decryptInPlace();
+        sampleQueue();
+        voiceAllocations();
+        voiceMixer();
+        voiceJitter();
+        interpolation();
+        collisionBroadphase();
+        log::debug("==== Benchmarks finished ====");
+    }
+
+    void udpThroughput() {
+        constexpr size_t DATAGRAMS = 20000;
+        constexpr size_t WINDOW = UdpSocket::MAX_BATCH;
+        constexpr size_t PAYLOAD = 512;
+
+        LoopbackEchoServer server;
+        if (server.getPort() == 0) return;
+
+        NetworkAddress address(fmt::format("127.0.0.1:{}", server.getPort()));
+
+        std::vector<char> sendData(PAYLOAD * WINDOW, 'g');
+        std::vector<char> recvData(PAYLOAD * 4 * WINDOW);
+
+        auto runMode = [&](bool batched) {
+            UdpSocket sock;
+            if (!sock.connect(address)) return;
+
+            UdpDatagram datagrams[WINDOW];
+            UdpDatagram recvDatagrams[WINDOW];
+
+            for (size_t i = 0; i < WINDOW; i++) {
+                datagrams[i] = UdpDatagram {
+                    .data = sendData.data() + i * PAYLOAD,
+                    .size = (int) PAYLOAD,
+                };
+
+                recvDatagrams[i] = UdpDatagram {
+                    .data = recvData.data() + i * PAYLOAD * 4,
+                    .size = (int) PAYLOAD * 4,
+                };
+            }
+
+            size_t received = 0;
+            size_t syscalls = 0;
+            auto start = Instant::now();
+
+            for (size_t sent = 0; sent < DATAGRAMS; sent += WINDOW) {
+                if (batched) {
+                    (void) sock.sendBatch(datagrams, WINDOW);
+                    syscalls++;
+                } else {
+                    for (size_t i = 0; i < WINDOW; i++) {
+                        (void) sock.send(datagrams[i].data, datagrams[i].size);
+                        syscalls++;
+                    }
+                }
+
+                // wait for the whole window to come back, give up on datagrams that take too long
+                size_t pending = WINDOW;
+                while (pending > 0) {
+                    auto pollResult = sock.poll(100);
+                    syscalls++;
+
+                    if (!pollResult || !pollResult.unwrap()) break;
+
+                    if (batched) {
+                        int count = sock.receiveBatch(recvDatagrams, pending);
+                        syscalls++;
+
+                        if (count <= 0) break;
+                        pending -= count;
+                        received += count;
+                    } else {
+                        auto res = sock.receive(recvDatagrams[0].data, recvDatagrams[0].size);
+                        syscalls++;
+
+                        if (res.result <= 0) break;
+                        pending--;
+                        received++;
+                    }
+                }
+            }
+
+            auto took = start.elapsed();
+            double secs = took.micros() / 1'000'000.0;
+
+            log::debug(
+                "UDP {}: {} datagrams echoed in {} ({:.0f} datagrams/s, {} syscalls, {} lost)",
+                batched ? "batched" : "single",
+                received, took.toString(), received / secs, syscalls, DATAGRAMS - received
+            );
+        };
+
+        runMode(false);
+        runMode(true);
+    }
+
+    void encodePackets() {
+        constexpr size_t ITERATIONS = 100000;
+
+        // any peer works for measuring the cost of encrypting
+        CryptoBox peer;
+        GameSocket socket;
+        socket.createBox(peer.getPublicKey());
+
+        size_t sink = 0;
+
+        auto runPacket = [&](const char* name, std::shared_ptr<Packet> packet) {
+            bool tcp = packet->getUseTcp();
+
+            auto runMode = [&](bool arena) {
+                auto start = Instant::now();
+                size_t encodedSize = 0;
+                size_t reservedSize = 0;
+
+                for (size_t i = 0; i < ITERATIONS; i++) {
+                    if (arena) {
+                        encodedSize = socket.encodeWithoutSending(*packet, tcp).unwrapOr(0);
+                    } else {
+                        ByteBuffer buf;
+                        encodedSize = socket.encodeWithoutSending(*packet, tcp, &buf).unwrapOr(0);
+                        reservedSize = buf.data().capacity();
+                    }
+
+                    sink += encodedSize;
+                }
+
+                auto took = start.elapsed();
+
+                log::debug(
+                    "encodePacket {} ({}, {} bytes): {:.1f} ns/packet",
+                    name, arena ? "send arena" : "fresh buffer", encodedSize, took.micros() * 1000.0 / ITERATIONS
+                );
+
+                // a fresh buffer is allocated exactly once, so its capacity shows how much was reserved upfront
+                if (!arena && reservedSize != encodedSize) {
+                    log::debug("encodePacket {}: reserved {} bytes for {} encoded bytes", name, reservedSize, encodedSize);
+                }
+            };
+
+            runMode(false);
+            runMode(true);
+        };
+
+        PlayerData data = {};
+        data.player1.position = cocos2d::CCPoint{1234.5f, 567.8f};
+        data.player1.iconType = PlayerIconType::Cube;
+        data.player1.isVisible = true;
+        data.player2 = data.player1;
+        data.player2.isVisible = false;
+
+        runPacket("PlayerDataPacket", PlayerDataPacket::create(data, PlayerMetadata{}, std::vector<GlobedCounterChange>{}));
+
+#ifdef GLOBED_VOICE_SUPPORT
+        // a typical opus frame is around 60 bytes, the data is borrowed so the frame doesn't free it
+        std::vector<util::data::byte> opusData(60, 0x5a);
+
+        auto frame = std::make_shared<EncodedAudioFrame>();
+        for (size_t i = 0; i < EncodedAudioFrame::LIMIT_REGULAR; i++) {
+            (void) frame->pushOpusFrame(EncodedOpusData {
+                .ptr = opusData.data(),
+                .length = (int64_t) opusData.size(),
+                .borrowed = true,
+            });
+        }
+
+        runPacket("VoicePacket", VoicePacket::create(frame));
+#endif
+
+        log::debug("encodePacket: {} bytes encoded in total", sink);
+    }
+
+    void decodePackets() {
+        constexpr size_t ITERATIONS = 10000;
+        constexpr size_t PLAYERS = 100;
+
+        LevelDataPacket packet;
+        for (size_t i = 0; i < PLAYERS; i++) {
+            PlayerData data = {};
+            data.timestamp = i * 0.01f;
+            data.player1.position = cocos2d::CCPoint{1234.5f + i * 30.f, 567.8f - i * 3.f};
+            data.player1.rotation = i * 3.6f;
+            data.player1.iconType = PlayerIconType::Cube;
+            data.player1.isVisible = true;
+            data.player2 = data.player1;
+            data.player2.isVisible = false;
+
+            packet.players.emplace_back(i + 1, data);
+        }
+
+        ByteBuffer encoded;
+        encoded.writeValue(packet);
+        auto received = encoded.data();
+
+        size_t sink = 0;
+
+        auto runMode = [&](bool inPlace) {
+            size_t copied = 0;
+            auto start = Instant::now();
+
+            for (size_t i = 0; i < ITERATIONS; i++) {
+                LevelDataPacket out;
+
+                if (inPlace) {
+                    ByteReader reader(received.data(), received.size());
+                    (void) out.decode(reader);
+                } else {
+                    ByteBuffer buf(received.data(), received.size());
+                    copied += received.size();
+                    (void) out.decode(buf);
+                }
+
+                sink += out.players.size();
+            }
+
+            auto took = start.elapsed();
+
+            log::debug(
+                "decode LevelDataPacket ({} players, {} bytes, {}): {:.1f} ns/packet, {} bytes copied",
+                PLAYERS, received.size(), inPlace ? "in place" : "copied buffer", took.micros() * 1000.0 / ITERATIONS, copied
+            );
+        };
+
+        runMode(false);
+        runMode(true);
+
+        log::debug("decodePackets: {} players decoded in total", sink);
+    }
+
+    // how vectors were encoded before the bulk path existed, every element goes through `writeValue`/`readValue`
+    template <typename T>
+    static void encodeElementwise(ByteBuffer& buf, const std::vector<T>& vec) {
+        buf.writeLength(vec.size());
+
+        for (const auto& elem : vec) {
+            buf.writeValue(elem);
+        }
+    }
+
+    template <typename T>
+    static std::vector<T> decodeElementwise(ByteReader& reader) {
+        std::vector<T> out;
+
+        auto length = reader.readLength();
+        if (!length) return out;
+
+        out.reserve(length.unwrap());
+
+        for (size_t i = 0; i < length.unwrap(); i++) {
+            auto elem = reader.readValue<T>();
+            if (!elem) break;
+
+            out.push_back(std::move(elem.unwrap()));
+        }
+
+        return out;
+    }
+
+    void bulkVectors() {
+        constexpr size_t ITERATIONS = 10000;
+
+        size_t sink = 0;
+
+        auto measure = [&](const char* name, auto&& elementwise, auto&& bulk) {
+            auto run = [&](auto& func) {
+                auto start = Instant::now();
+
+                for (size_t i = 0; i < ITERATIONS; i++) {
+                    sink += func();
+                }
+
+                return start.elapsed().micros() * 1000.0 / ITERATIONS;
+            };
+
+            double elementwiseNs = run(elementwise);
+            double bulkNs = run(bulk);
+
+            log::debug("{}: {:.1f} ns element by element, {:.1f} ns bulk", name, elementwiseNs, bulkNs);
+        };
+
+        // a player count request for every level on a few pages of the level browser
+        std::vector<LevelId> levelIds;
+        for (size_t i = 0; i < 1000; i++) {
+            levelIds.push_back(100000000 + i * 7919);
+        }
+
+        RequestPlayerCountPacket request(std::move(levelIds));
+
+        measure("encode RequestPlayerCountPacket (1000 levels)", [&] {
+            ByteBuffer buf;
+            encodeElementwise(buf, request.levelIds);
+            return buf.size();
+        }, [&] {
+            ByteBuffer buf;
+            request.encode(buf);
+            return buf.size();
+        });
+
+        UpdateFriendListPacket friends;
+        for (int i = 0; i < 500; i++) {
+            friends.ids.push_back(7000000 + i * 13);
+        }
+
+        measure("encode UpdateFriendListPacket (500 friends)", [&] {
+            ByteBuffer buf;
+            encodeElementwise(buf, friends.ids);
+            return buf.size();
+        }, [&] {
+            ByteBuffer buf;
+            friends.encode(buf);
+            return buf.size();
+        });
+
+        // the response to the request above
+        LevelPlayerCountPacket counts;
+        for (size_t i = 0; i < request.levelIds.size(); i++) {
+            counts.levels.emplace_back(request.levelIds[i], (uint16_t) (i % 40));
+        }
+
+        ByteBuffer encodedCounts;
+        counts.encode(encodedCounts);
+
+        measure("decode LevelPlayerCountPacket (1000 levels)", [&] {
+            ByteReader reader(encodedCounts.span());
+            return decodeElementwise<std::pair<LevelId, uint16_t>>(reader).size();
+        }, [&] {
+            ByteReader reader(encodedCounts.span());
+            LevelPlayerCountPacket out;
+            (void) out.decode(reader);
+            return out.levels.size();
+        });
+
+        util::data::bytearray<32> levelHash;
+        for (size_t i = 0; i < levelHash.size(); i++) {
+            levelHash[i] = (uint8_t) (i * 37);
+        }
+
+        ByteBuffer encodedHash;
+        encodedHash.writeValue(levelHash);
+
+        measure("decode level hash (32 bytes)", [&] {
+            ByteReader reader(encodedHash.span());
+            util::data::bytearray<32> out;
+
+            for (auto& byte : out) {
+                byte = reader.readU8().unwrapOr(0);
+            }
+
+            return (size_t) out[31];
+        }, [&] {
+            ByteReader reader(encodedHash.span());
+            return (size_t) reader.readValue<util::data::bytearray<32>>().unwrap()[31];
+        });
+
+        log::debug("bulkVectors: checksum {}", sink);
+    }
+
+    void sendLatency() {
+        constexpr size_t PACKETS = 1000;
+
+        LoopbackEchoServer server;
+        if (server.getPort() == 0) return;
+
+        NetworkAddress address(fmt::format("127.0.0.1:{}", server.getPort()));
+
+        auto runMode = [&](bool useReactor) {
+            UdpSocket sock;
+            if (!sock.connect(address)) return;
+
+            NetReactor reactor;
+            if (useReactor && !reactor.init()) return;
+
+            asp::Channel<Instant> queue;
+            util::debug::LatencyHistogram histogram;
+            std::atomic_bool done = false;
+
+            std::thread consumer([&] {
+                char payload[64] = {};
+
+                auto sendOne = [&](const Instant& queuedAt) {
+                    (void) sock.send(payload, sizeof(payload));
+                    histogram.record(queuedAt.elapsed());
+                };
+
+                while (!done) {
+                    if (useReactor) {
+                        (void) reactor.wait(NetReactor::INVALID_HANDLE, NetReactor::INVALID_HANDLE, -1);
+
+                        while (auto queuedAt = queue.tryPop()) {
+                            sendOne(*queuedAt);
+                        }
+                    } else {
+                        // how the network thread used to wait for tasks
+                        while (auto queuedAt = queue.popTimeout(Duration::fromMillis(50))) {
+                            sendOne(*queuedAt);
+                        }
+
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            for (size_t i = 0; i < PACKETS; i++) {
+                queue.push(Instant::now());
+                if (useReactor) reactor.wake();
+
+                // a bit faster than player data is usually sent, with some jitter
+                std::this_thread::sleep_for(std::chrono::microseconds(500 + (i % 7) * 300));
+            }
+
+            done = true;
+            if (useReactor) reactor.wake();
+            consumer.join();
+
+            util::debug::LatencyHistogram::print(useReactor ? "Send latency (reactor)" : "Send latency (channel loop)", histogram.snapshot());
+        };
+
+        runMode(false);
+        runMode(true);
+    }
+
+    void dispatchListeners() {
+        constexpr size_t PACKETS = 10000;
+        constexpr size_t LISTENERS = 200;
+        constexpr size_t PACKETS_PER_FRAME = 100;
+
+        std::vector<std::shared_ptr<Packet>> packets = {
+            LevelDataPacket::create(),
+            PlayerProfilesPacket::create(),
+            LevelPlayerMetadataPacket::create(),
+            LevelInnerPlayerCountPacket::create(),
+            ChatMessageBroadcastPacket::create(),
+            VoiceBroadcastPacket::create(),
+            VoiceFailedPacket::create(),
+        };
+
+        size_t invocations = 0;
+        std::vector<Ref<PacketListener>> listeners;
+
+        for (size_t i = 0; i < LISTENERS; i++) {
+            listeners.push_back(PacketListener::create(
+                packets[i % packets.size()]->getPacketId(),
+                [&invocations](std::shared_ptr<Packet>) { invocations++; },
+                nullptr,
+                (int) (i * 7919 % 101),
+                false
+            ));
+        }
+
+        auto runMode = [&](const char* name, auto&& registerListener, auto&& dispatchFrame) {
+            for (auto& listener : listeners) {
+                registerListener(listener->packetId, listener.data());
+            }
+
+            invocations = 0;
+            auto worstFrame = Duration::fromMicros(0);
+            auto start = Instant::now();
+
+            for (size_t sent = 0; sent < PACKETS; sent += PACKETS_PER_FRAME) {
+                auto frameStart = Instant::now();
+                dispatchFrame(sent, PACKETS_PER_FRAME);
+                worstFrame = std::max(worstFrame, frameStart.elapsed());
+            }
+
+            auto took = start.elapsed();
+            size_t frames = PACKETS / PACKETS_PER_FRAME;
+
+            log::debug(
+                "Dispatch ({}): {} packets, {} callbacks in {}, {} per frame on average, worst frame {}",
+                name, PACKETS, invocations, took.toString(), Duration::fromMicros(took.micros() / frames).toString(), worstFrame.toString()
+            );
+        };
+
+        // how `PacketListenerPool` used to work
+        std::unordered_map<packetid_t, std::vector<WeakRef<PacketListener>>> oldListeners;
+
+        runMode("map + sort", [&](packetid_t id, PacketListener* listener) {
+            oldListeners[id].push_back(WeakRef(listener));
+        }, [&](size_t first, size_t count) {
+            for (auto& [id, ls] : oldListeners) {
+                std::erase_if(ls, [](auto& l) { return !l.valid(); });
+            }
+
+            for (size_t i = first; i < first + count; i++) {
+                auto& packet = packets[i % packets.size()];
+                auto& lsm = oldListeners[packet->getPacketId()];
+
+                std::sort(lsm.begin(), lsm.end(), [](auto& l1, auto& l2) -> bool {
+                    auto r1 = l1.lock();
+                    auto r2 = l2.lock();
+
+                    if (!r1) return false;
+                    if (!r2) return true;
+
+                    return r1->priority < r2->priority;
+                });
+
+                for (auto& listener : lsm) {
+                    if (auto l = listener.lock()) {
+                        l->invokeCallback(packet);
+                        if (l->isFinal) break;
+                    }
+                }
+            }
+        });
+
+        PacketListenerTable table;
+
+        runMode("listener table", [&](packetid_t id, PacketListener* listener) {
+            table.add(id, listener);
+        }, [&](size_t first, size_t count) {
+            for (size_t i = first; i < first + count; i++) {
+                table.dispatch(packets[i % packets.size()]);
+            }
+
+            table.compact();
+        });
+    }
+
+    // Per-player traces from received level data packets, dumped to the save folder when packet logging is enabled
+    static std::unordered_map<int, std::vector<PlayerData>> loadRecordedTraces() {
+        std::unordered_map<int, std::vector<PlayerData>> traces;
+
+        auto folder = Mod::get()->getSaveDir() / "packets";
+        std::error_code ec;
+        if (!std::filesystem::exists(folder, ec)) return traces;
+
+        // file names start with the packet id and end with the date, so sorting them puts them in order
+        std::vector<std::filesystem::path> files;
+        for (auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+            auto name = entry.path().filename().string();
+            if (name.starts_with(fmt::format("{}-", LevelDataPacket::PACKET_ID))) {
+                files.push_back(entry.path());
+            }
+        }
+
+        std::sort(files.begin(), files.end());
+
+        for (auto& path : files) {
+            std::ifstream file(path, std::ios::binary);
+            util::data::bytevector data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            ByteBuffer buf(std::move(data));
+            if (!buf.readValue<PacketHeader>()) continue;
+
+            LevelDataPacket packet;
+            if (!packet.decode(buf)) continue;
+
+            for (auto& player : packet.players) {
+                traces[player.accountId].push_back(player.data);
+            }
+        }
+
+        return traces;
+    }
+
+    // A minute of a cube running through a level at normal speed, jumping and dying every now and then
+    static std::vector<PlayerData> makeSyntheticTrace() {
+        constexpr size_t FRAMES = 60 * 30;
+        constexpr float SPEED = 311.58f;
+
+        std::vector<PlayerData> trace;
+
+        PlayerData data{};
+        data.player1.iconType = PlayerIconType::Cube;
+        data.player1.isVisible = true;
+        data.player2 = data.player1;
+
+        float startTime = 0.f;
+
+        for (size_t i = 0; i < FRAMES; i++) {
+            data.timestamp = i / 30.f;
+
+            if (i % 600 == 599) {
+                data.deathCounter++;
+                startTime = data.timestamp;
+            }
+
+            float t = data.timestamp - startTime;
+            size_t phase = i % 45;
+            bool jumping = phase < 24;
+
+            data.player1.position.x = 15.f + SPEED * t;
+            data.player1.position.y = jumping ? 105.f + 0.8f * phase * (24 - phase) : 105.f;
+            data.player1.rotation = jumping ? phase * 7.5f : 0.f;
+            data.player1.didJustJump = phase == 0;
+            data.player1.isGrounded = !jumping;
+            data.player1.isFalling = jumping && phase >= 12;
+            data.player1.isRotating = jumping;
+            data.currentPercentage = std::min(data.player1.position.x / 200.f, 100.f);
+
+            trace.push_back(data);
+        }
+
+        return trace;
+    }
+
+    void playerDataSize() {
+        // frames until an acknowledgement gets back to the sender, roughly 100 ms at 30 tps
+        constexpr size_t ACK_DELAY = 3;
+
+        auto traces = loadRecordedTraces();
+        if (traces.empty()) {
+            log::debug("No recorded level data found (enable packet logging while in a level to record some), using a synthetic trace");
+            traces[1] = makeSyntheticTrace();
+        }
+
+        size_t frames = 0, keyframes = 0, fullBytes = 0, deltaBytes = 0, lostFrames = 0;
+        double seconds = 0.0;
+        float maxError = 0.f;
+
+        for (auto& [accountId, trace] : traces) {
+            if (trace.size() < 2) continue;
+
+            PlayerDataDeltaEncoder encoder;
+            PlayerDataDeltaDecoder decoder;
+            std::deque<uint8_t> pendingAcks;
+
+            for (auto& data : trace) {
+                ByteBuffer full;
+                full.writeValue(data);
+                fullBytes += full.size();
+
+                auto frame = encoder.encode(data);
+
+                ByteBuffer delta;
+                delta.writeValue(frame);
+                deltaBytes += delta.size();
+
+                frames++;
+                keyframes += frame.isKeyframe;
+
+                auto decoded = decoder.decode(frame);
+                if (!decoded) {
+                    lostFrames++;
+                    continue;
+                }
+
+                auto out = decoded.unwrap();
+                maxError = std::max({
+                    maxError,
+                    std::abs(out.player1.position.x - data.player1.position.x),
+                    std::abs(out.player1.position.y - data.player1.position.y),
+                });
+
+                if (auto kf = decoder.latestKeyframe()) {
+                    pendingAcks.push_back(*kf);
+                }
+
+                if (pendingAcks.size() > ACK_DELAY) {
+                    encoder.acknowledge(pendingAcks.front());
+                    pendingAcks.pop_front();
+                }
+            }
+
+            seconds += trace.back().timestamp - trace.front().timestamp;
+        }
+
+        if (seconds <= 0.0) return;
+
+        log::debug(
+            "Player data: {} frames ({:.0f} player-seconds), full: {:.0f} B/player/s, delta: {:.0f} B/player/s ({} keyframes), max position error {:.3f}px, {} undecodable",
+            frames, seconds, fullBytes / seconds, deltaBytes / seconds, keyframes, maxError, lostFrames
+        );
+    }
+
+    void compactIconData() {
+        auto trace = makeSyntheticTrace();
+
+        // the second player is far away from the first one, so it does not fit in an offset and is encoded in full
+        for (size_t i = 0; i < trace.size(); i++) {
+            auto& data = trace[i];
+            data.isDualMode = true;
+            data.player2.position = data.player1.position + CCPoint { 9000.f, -4500.f };
+            data.player2.rotation = -720.f + i * 13.7f;
+
+            if (i % 90 == 45) {
+                data.player1.iconType = PlayerIconType::Spider;
+                data.player1.spiderTeleportData = SpiderTeleportData {
+                    .from = data.player1.position,
+                    .to = data.player1.position + CCPoint { 0.f, 180.25f },
+                };
+            } else {
+                data.player1.iconType = PlayerIconType::Cube;
+                data.player1.spiderTeleportData = std::nullopt;
+            }
+        }
+
+        auto roundTrip = [](const PlayerData& data, uint16_t protocol, size_t& bytes) -> std::optional<PlayerData> {
+            ByteBuffer buf;
+            buf.setProtocol(protocol);
+            buf.writeValue(PositionOrigin { data.player1.position });
+            buf.writeValue(data);
+            bytes += buf.size();
+
+            ByteBuffer in(buf.data());
+            in.setProtocol(protocol);
+            if (!in.readValue<PositionOrigin>()) return std::nullopt;
+
+            auto decoded = in.readValue<PlayerData>();
+            if (!decoded) return std::nullopt;
+
+            return decoded.unwrap();
+        };
+
+        // same as the interpolator, minus the spider special case which only affects y and is identical for both inputs
+        auto lerp = [](const SpecificIconData& older, const SpecificIconData& newer, float ratio) {
+            return std::make_pair(
+                older.position.lerp(newer.position, ratio),
+                older.rotation + util::math::angleDifference(older.rotation, newer.rotation) * ratio
+            );
+        };
+
+        size_t legacyBytes = 0, compactBytes = 0, failed = 0, flagMismatches = 0;
+        float maxPosError = 0.f, maxRotError = 0.f, maxTeleportError = 0.f;
+
+        std::optional<PlayerData> previous;
+
+        for (size_t i = 0; i < trace.size(); i++) {
+            auto& data = trace[i];
+
+            roundTrip(data, 0, legacyBytes);
+            auto decoded = roundTrip(data, COMPACT_ICON_DATA_PROTOCOL, compactBytes);
+
+            if (!decoded) {
+                failed++;
+                previous = std::nullopt;
+                continue;
+            }
+
+            for (auto [orig, dec] : { std::make_pair(&data.player1, &decoded->player1), std::make_pair(&data.player2, &decoded->player2) }) {
+                if (!orig->flagsEqual(*dec)) flagMismatches++;
+
+                if (orig->spiderTeleportData.has_value() != dec->spiderTeleportData.has_value()) {
+                    flagMismatches++;
+                } else if (orig->spiderTeleportData) {
+                    maxTeleportError = std::max({
+                        maxTeleportError,
+                        orig->spiderTeleportData->from.getDistance(dec->spiderTeleportData->from),
+                        orig->spiderTeleportData->to.getDistance(dec->spiderTeleportData->to),
+                    });
+                }
+            }
+
+            if (previous) {
+                auto& prevOrig = trace[i - 1];
+
+                for (float ratio : { 0.f, 0.25f, 0.5f, 0.75f, 1.f }) {
+                    auto check = [&](const SpecificIconData& o1, const SpecificIconData& o2, const SpecificIconData& d1, const SpecificIconData& d2) {
+                        auto [expectedPos, expectedRot] = lerp(o1, o2, ratio);
+                        auto [actualPos, actualRot] = lerp(d1, d2, ratio);
+
+                        maxPosError = std::max(maxPosError, expectedPos.getDistance(actualPos));
+                        maxRotError = std::max(maxRotError, std::abs(util::math::angleDifference(expectedRot, actualRot)));
+                    };
+
+                    check(prevOrig.player1, data.player1, previous->player1, decoded->player1);
+                    check(prevOrig.player2, data.player2, previous->player2, decoded->player2);
+                }
+            }
+
+            previous = std::move(decoded);
+        }
+
+        size_t icons = trace.size() * 2;
+
+        log::debug(
+            "Compact icon data: {:.1f} B/frame legacy, {:.1f} B/frame compact, max interpolated position error {:.3f}px, rotation {:.3f}deg, teleport {:.3f}px",
+            legacyBytes / (double) trace.size(), compactBytes / (double) trace.size(), maxPosError, maxRotError, maxTeleportError
+        );
+
+        if (failed != 0 || flagMismatches != 0 || maxPosError > 1.f || maxTeleportError > 1.f) {
+            log::error(
+                "Compact icon data round trip failed: {} undecodable frames, {} flag mismatches out of {} icons, position error {:.3f}px",
+                failed, flagMismatches, icons, maxPosError
+            );
+        }
+    }
+
+    void cryptoThroughput() {
+        constexpr size_t BATCH = 256;
+        constexpr size_t ROUNDS = 80;
+
+        // two ends of one session, like the client and the server
+        CryptoBox client, server;
+        client.setPeerKey(server.getPublicKey());
+        server.setPeerKey(client.getPublicKey());
+
+        std::vector<std::vector<util::data::byte>> messages(BATCH);
+
+        auto runMode = [&](CryptoBox::NonceMode mode, size_t payload) {
+            client.setNonceMode(mode, true);
+            server.setNonceMode(mode, false);
+
+            size_t prefix = client.messagePrefixLength(false);
+            uint64_t encryptMicros = 0, decryptMicros = 0;
+            size_t failed = 0;
+
+            for (size_t round = 0; round < ROUNDS; round++) {
+                for (auto& message : messages) {
+                    message.resize(prefix + payload);
+                    std::memset(message.data() + prefix, static_cast<int>(round), payload);
+                }
+
+                // timed in batches, a single message is too quick to measure
+                auto start = Instant::now();
+                for (auto& message : messages) {
+                    (void) client.encryptMessage(message.data(), message.data() + prefix, payload, false);
+                }
+                encryptMicros += start.elapsed().micros();
+
+                start = Instant::now();
+                for (auto& message : messages) {
+                    auto res = server.decryptMessage(message.data(), message.size(), false);
+                    if (!res || res.unwrap().size() != payload) failed++;
+                }
+                decryptMicros += start.elapsed().micros();
+            }
+
+            double megabytes = BATCH * ROUNDS * payload / (1024.0 * 1024.0);
+
+            log::debug(
+                "CryptoBox {} {}B: encrypt {:.1f} MB/s, decrypt {:.1f} MB/s, {} bytes of overhead per message",
+                mode == CryptoBox::NonceMode::Counter ? "counter" : "random", payload,
+                megabytes / (encryptMicros / 1'000'000.0), megabytes / (decryptMicros / 1'000'000.0), prefix
+            );
+
+            if (failed != 0) {
+                log::error("CryptoBox {}B: {} messages failed to decrypt", payload, failed);
+            }
+        };
+
+        for (size_t payload : { 64, 256, 1024, 4096 }) {
+            runMode(CryptoBox::NonceMode::Random, payload);
+            runMode(CryptoBox::NonceMode::Counter, payload);
+        }
+
+        // replayed messages must be rejected in the counter mode
+        size_t prefix = client.messagePrefixLength(false);
+        std::vector<util::data::byte> message(prefix + 64);
+
+        (void) client.encryptMessage(message.data(), message.data() + prefix, 64, false);
+        auto copy = message;
+
+        bool first = server.decryptMessage(message.data(), message.size(), false).isOk();
+        bool replayed = server.decryptMessage(copy.data(), copy.size(), false).isOk();
+
+        if (!first || replayed) {
+            log::error("CryptoBox replay protection failed: original accepted = {}, replay accepted = {}", first, replayed);
+        }
+    }
+
+    void decryptInPlace() {
+        using util::data::byte;
+
+        log::debug("CryptoBox algorithm: {}", CryptoBox::algorithm());
+
+        CryptoBox client, server;
+        client.setPeerKey(server.getPublicKey());
+        server.setPeerKey(client.getPublicKey());
+
+        size_t failed = 0, checked = 0;
+
+        // the plaintext must be left right after the prefix, untouched, and nothing before it may be read as plaintext
+        auto check = [&](std::vector<byte>& message, const std::vector<byte>& plaintext, size_t prefix, bool tcp) {
+            checked++;
+
+            auto res = server.decryptMessage(message.data(), message.size(), tcp);
+            if (!res) {
+                failed++;
+                log::error("CryptoBox in place decrypt failed ({}B, tcp = {}): {}", plaintext.size(), tcp, res.unwrapErr());
+                return;
+            }
+
+            auto out = res.unwrap();
+            if (out.data() != message.data() + prefix || out.size() != plaintext.size() || !std::equal(out.begin(), out.end(), plaintext.begin())) {
+                failed++;
+                log::error("CryptoBox in place decrypt returned the wrong plaintext ({}B, tcp = {}), offset {}", plaintext.size(), tcp, out.data() - message.data());
+            }
+        };
+
+        for (size_t payload : { 0, 1, 63, 64, 1400, 4096 }) {
+            std::vector<byte> plaintext(payload);
+            for (size_t i = 0; i < payload; i++) {
+                plaintext[i] = static_cast<byte>(i * 31 + payload);
+            }
+
+            // random nonces must stay compatible with the combined format of encryptInto, which the server uses
+            client.setNonceMode(CryptoBox::NonceMode::Random, true);
+            server.setNonceMode(CryptoBox::NonceMode::Random, false);
+
+            std::vector<byte> message(CryptoBox::PREFIX_LEN + payload);
+            (void) client.encryptInto(plaintext.data(), message.data(), payload);
+            check(message, plaintext, CryptoBox::PREFIX_LEN, true);
+
+            for (bool tcp : { true, false }) {
+                for (auto mode : { CryptoBox::NonceMode::Random, CryptoBox::NonceMode::Counter }) {
+                    client.setNonceMode(mode, true);
+                    server.setNonceMode(mode, false);
+
+                    size_t prefix = client.messagePrefixLength(tcp);
+                    message.assign(prefix + payload, 0);
+                    std::copy(plaintext.begin(), plaintext.end(), message.begin() + prefix);
+
+                    (void) client.encryptMessage(message.data(), message.data() + prefix, payload, tcp);
+                    check(message, plaintext, prefix, tcp);
+                }
+            }
+        }
+
+        // a tampered message must be rejected, without exposing any of it as plaintext
+        std::vector<byte> message(CryptoBox::PREFIX_LEN + 64);
+        client.setNonceMode(CryptoBox::NonceMode::Random, true);
+        server.setNonceMode(CryptoBox::NonceMode::Random, false);
+        (void) client.encryptMessage(message.data(), message.data() + CryptoBox::PREFIX_LEN, 64, true);
+        message.back() ^= 1;
+
+        bool tamperedAccepted = server.decryptMessage(message.data(), message.size(), true).isOk();
+
+        if (failed != 0 || tamperedAccepted) {
+            log::error("CryptoBox in place decrypt: {} out of {} messages failed, tampered message accepted = {}", failed, checked, tamperedAccepted);
+        } else {
+            log::debug("CryptoBox in place decrypt: {} messages decrypted at their natural offset", checked);
+        }
+    }
+
+    void sampleQueue() {
+#ifdef GLOBED_VOICE_SUPPORT
+        constexpr size_t STREAMS = 50;
+        constexpr size_t SAMPLE_RATE = 24000;
+        constexpr size_t FRAME = SAMPLE_RATE * 60 / 1000; // one decoded opus frame
+        constexpr size_t CALLBACK_SAMPLES = 1024; // samples requested by one FMOD pcmreadcallback
+        constexpr size_t CAPACITY = SAMPLE_RATE * 2;
+        constexpr size_t STRESS_SAMPLES = SAMPLE_RATE * 30; // 30 seconds per stream
+
+        // stress test, a decoder thread and an FMOD thread going through 50 streams as fast as they can.
+        // every sample is its index in the stream, so a single lost, duplicated or torn sample shows up.
+        {
+            std::vector<AudioSampleQueue> queues;
+            queues.reserve(STREAMS);
+            for (size_t i = 0; i < STREAMS; i++) {
+                queues.emplace_back(CAPACITY);
+            }
+
+            std::atomic_bool done = false;
+            size_t mismatches = 0, received = 0;
+
+            auto sampleAt = [](size_t index) {
+                return static_cast<float>(index % (1 << 24)); // exactly representable
+            };
+
+            std::thread producer([&] {
+                std::vector<size_t> written(STREAMS, 0);
+                float frame[FRAME];
+                size_t finished = 0;
+
+                while (finished < STREAMS) {
+                    finished = 0;
+
+                    for (size_t s = 0; s < STREAMS; s++) {
+                        auto& queue = queues[s];
+
+                        if (written[s] >= STRESS_SAMPLES) {
+                            finished++;
+                            continue;
+                        }
+
+                        // don't overflow, that is tested separately
+                        if (queue.capacity() - queue.size() < FRAME) continue;
+
+                        for (size_t i = 0; i < FRAME; i++) {
+                            frame[i] = sampleAt(written[s] + i);
+                        }
+
+                        written[s] += queue.writeData(frame, FRAME);
+                    }
+
+                    std::this_thread::yield();
+                }
+
+                done = true;
+            });
+
+            auto start = Instant::now();
+
+            std::vector<size_t> read(STREAMS, 0);
+            float out[CALLBACK_SAMPLES];
+
+            while (true) {
+                bool producerDone = done;
+                size_t got = 0;
+
+                for (size_t s = 0; s < STREAMS; s++) {
+                    size_t copied = queues[s].copyTo(out, CALLBACK_SAMPLES);
+
+                    for (size_t i = 0; i < copied; i++) {
+                        if (out[i] != sampleAt(read[s] + i)) mismatches++;
+                    }
+
+                    read[s] += copied;
+                    got += copied;
+                }
+
+                received += got;
+
+                // the producer is done and everything was drained
+                if (producerDone && got == 0) break;
+            }
+
+            producer.join();
+
+            auto took = start.elapsed();
+            size_t overflowed = 0;
+            for (auto& queue : queues) {
+                overflowed += queue.overflowCount();
+            }
+
+            log::debug(
+                "AudioSampleQueue stress: {} streams, {} samples in {} ({:.1f}x realtime), {} mismatched, {} overflowed",
+                STREAMS, received, took.toString(),
+                (STRESS_SAMPLES / static_cast<double>(SAMPLE_RATE)) / (took.micros() / 1'000'000.0),
+                mismatches, overflowed
+            );
+
+            if (mismatches != 0 || overflowed != 0 || received != STREAMS * STRESS_SAMPLES) {
+                log::error("AudioSampleQueue stress test failed, expected {} samples", STREAMS * STRESS_SAMPLES);
+            }
+        }
+
+        // overflow and underrun counters
+        {
+            AudioSampleQueue queue(CALLBACK_SAMPLES);
+            std::vector<float> data(CALLBACK_SAMPLES + 100, 1.f);
+
+            size_t written = queue.writeData(data.data(), data.size());
+            size_t copied = queue.copyTo(data.data(), data.size());
+
+            if (written != CALLBACK_SAMPLES || queue.overflowCount() != 100 || copied != CALLBACK_SAMPLES || queue.underrunCount() != 100) {
+                log::error(
+                    "AudioSampleQueue counters are wrong: written {}, overflowed {}, copied {}, underran {}",
+                    written, queue.overflowCount(), copied, queue.underrunCount()
+                );
+            }
+        }
+
+        // cost of the playback callbacks of 50 streams for one minute of audio, with about half a second queued in each
+        constexpr size_t CALLBACK_COUNT = SAMPLE_RATE * 60 / CALLBACK_SAMPLES;
+        constexpr size_t BACKLOG = SAMPLE_RATE / 2;
+
+        std::vector<float> frame(FRAME, 0.5f);
+        float out[CALLBACK_SAMPLES];
+
+        auto runMode = [&](const char* name, auto& queues, auto&& write, auto&& read) {
+            for (auto& queue : queues) {
+                while (queue.size() < BACKLOG) write(queue);
+            }
+
+            uint64_t readMicros = 0;
+            auto start = Instant::now();
+
+            for (size_t c = 0; c < CALLBACK_COUNT; c++) {
+                // keep the backlog steady, like a decoder that keeps up
+                for (auto& queue : queues) {
+                    if (queue.size() < BACKLOG) write(queue);
+                }
+
+                auto readStart = Instant::now();
+                for (auto& queue : queues) {
+                    read(queue);
+                }
+                readMicros += readStart.elapsed().micros();
+            }
+
+            log::debug(
+                "AudioSampleQueue ({}): {} callbacks for {} streams in {}, {:.2f}us per callback",
+                name, CALLBACK_COUNT, STREAMS, start.elapsed().toString(), readMicros / static_cast<double>(CALLBACK_COUNT * STREAMS)
+            );
+        };
+
+        // how AudioSampleQueue used to work, an ever growing vector where every read shifts the remaining samples
+        struct VectorQueue {
+            std::vector<float> buf;
+            size_t size() const { return buf.size(); }
+        };
+
+        std::vector<VectorQueue> vectorQueues(STREAMS);
+        runMode("vector", vectorQueues, [&](VectorQueue& q) {
+            q.buf.insert(q.buf.end(), frame.begin(), frame.end());
+        }, [&](VectorQueue& q) {
+            size_t count = std::min(CALLBACK_SAMPLES, q.buf.size());
+            std::copy(q.buf.begin(), q.buf.begin() + count, out);
+            q.buf.erase(q.buf.begin(), q.buf.begin() + count);
+        });
+
+        std::vector<AudioSampleQueue> ringQueues;
+        ringQueues.reserve(STREAMS);
+        for (size_t i = 0; i < STREAMS; i++) {
+            ringQueues.emplace_back(CAPACITY);
+        }
+
+        runMode("ring", ringQueues, [&](AudioSampleQueue& q) {
+            q.writeData(frame.data(), frame.size());
+        }, [&](AudioSampleQueue& q) {
+            q.copyTo(out, CALLBACK_SAMPLES);
+        });
+#endif // GLOBED_VOICE_SUPPORT
+    }
+
+    void voiceAllocations() {
+#ifdef GLOBED_VOICE_SUPPORT
+        constexpr size_t ROUNDS = 200;
+        constexpr size_t WARMUP_ROUNDS = 2;
+
+        AudioEncoder encoder(VOICE_TARGET_SAMPLERATE, VOICE_TARGET_FRAMESIZE, VOICE_CHANNELS);
+        AudioDecoder decoder(VOICE_TARGET_SAMPLERATE, VOICE_TARGET_FRAMESIZE, VOICE_CHANNELS);
+        AudioSampleQueue queue(VOICE_TARGET_SAMPLERATE * VOICE_STREAM_BUFFER_TIME);
+
+        // a 440 Hz tone, so opus has something to encode
+        std::vector<float> pcm(VOICE_TARGET_FRAMESIZE * VOICE_CHANNELS);
+        for (size_t i = 0; i < pcm.size(); i++) {
+            pcm[i] = 0.25f * std::sin(2.f * 3.14159265f * 440.f * i / VOICE_TARGET_SAMPLERATE);
+        }
+
+        float decoded[VOICE_TARGET_FRAMESIZE * VOICE_CHANNELS];
+
+        auto& pool = OpusFramePool::get();
+        size_t baseline = 0, failed = 0, frames = 0;
+
+        EncodedAudioFrame frame(EncodedAudioFrame::LIMIT_REGULAR);
+        ByteBuffer buf;
+
+        auto start = Instant::now();
+
+        // the whole voice pipeline: record path encoding a frame, sending it, receiving it without borrowing and decoding it into a stream
+        for (size_t round = 0; round < ROUNDS; round++) {
+            if (round == WARMUP_ROUNDS) {
+                baseline = pool.allocationCount();
+                start = Instant::now();
+            }
+
+            for (size_t i = 0; i < EncodedAudioFrame::LIMIT_REGULAR; i++) {
+                auto opusFrame = encoder.encode(pcm.data());
+                if (!opusFrame || !frame.pushOpusFrame(opusFrame.unwrap())) {
+                    failed++;
+                }
+            }
+
+            buf.clear();
+            buf.writeValue(frame);
+            frame.clear();
+
+            ByteReader reader(buf.data());
+            auto received = reader.readValue<EncodedAudioFrame>();
+            if (!received) {
+                failed++;
+                continue;
+            }
+
+            for (const auto& opusFrame : received.unwrap().getFrames()) {
+                auto samples = decoder.decodeInto(opusFrame.ptr, opusFrame.length, decoded, std::size(decoded));
+                if (!samples) {
+                    failed++;
+                    continue;
+                }
+
+                queue.writeData(decoded, samples.unwrap());
+                queue.skip(samples.unwrap());
+                frames++;
+            }
+        }
+
+        size_t allocations = pool.allocationCount() - baseline;
+
+        log::debug(
+            "Voice pipeline: {} opus frames encoded and decoded in {}, {} frame buffers allocated after warmup ({} idle in the pool)",
+            frames, start.elapsed().toString(), allocations, pool.idleCount()
+        );
+
+        if (failed != 0 || allocations != 0) {
+            log::error("Voice pipeline allocation test failed: {} failures, {} allocations after warmup", failed, allocations);
+        }
+#endif // GLOBED_VOICE_SUPPORT
+    }
+
+    void voiceMixer() {
+#ifdef GLOBED_VOICE_SUPPORT
+        constexpr size_t CALLBACK_SAMPLES = 1024;
+        constexpr size_t CALLBACK_COUNT = VOICE_TARGET_SAMPLERATE * 30 / CALLBACK_SAMPLES; // 30 seconds of audio
+
+        std::vector<float> pcm(CALLBACK_SAMPLES);
+        for (size_t i = 0; i < pcm.size(); i++) {
+            pcm[i] = 0.25f * std::sin(2.f * 3.14159265f * 440.f * i / VOICE_TARGET_SAMPLERATE);
+        }
+
+        std::vector<float> out(CALLBACK_SAMPLES);
+
+        for (size_t speakers : { 5, 20, 50 }) {
+            // one stream per speaker, like before: every stream has its own callback that copies its queue out and feeds its estimator,
+            // and then FMOD mixes the channels together (approximated by adding them up with the channel volume)
+            struct SeparateStream {
+                AudioSampleQueue queue{CALLBACK_SAMPLES * 4};
+                VolumeEstimator estimator{VOICE_TARGET_SAMPLERATE};
+                std::vector<float> buf = std::vector<float>(CALLBACK_SAMPLES);
+            };
+
+            std::vector<std::unique_ptr<SeparateStream>> separate;
+            for (size_t i = 0; i < speakers; i++) {
+                separate.push_back(std::make_unique<SeparateStream>());
+            }
+
+            uint64_t separateMicros = 0;
+            for (size_t c = 0; c < CALLBACK_COUNT; c++) {
+                for (auto& stream : separate) {
+                    stream->queue.writeData(pcm.data(), pcm.size());
+                }
+
+                auto start = Instant::now();
+
+                std::fill(out.begin(), out.end(), 0.f);
+                for (auto& stream : separate) {
+                    size_t copied = stream->queue.copyTo(stream->buf.data(), CALLBACK_SAMPLES);
+                    stream->estimator.feedData(stream->buf.data(), copied);
+
+                    for (size_t i = 0; i < CALLBACK_SAMPLES; i++) {
+                        out[i] += stream->buf[i] * 0.8f;
+                    }
+                }
+
+                separateMicros += start.elapsed().micros();
+            }
+
+            // all speakers mixed in a single callback, loudness calculated while mixing
+            VoiceMixer mixer;
+            std::vector<std::shared_ptr<AudioStream>> mixed;
+            for (size_t i = 0; i < speakers; i++) {
+                auto stream = std::make_shared<AudioStream>(AudioDecoder{}, true);
+                stream->setVolume(0.8f);
+                mixer.addStream(stream);
+                mixed.push_back(std::move(stream));
+            }
+
+            uint64_t mixedMicros = 0;
+            for (size_t c = 0; c < CALLBACK_COUNT; c++) {
+                for (auto& stream : mixed) {
+                    stream->writeData(pcm.data(), pcm.size());
+                }
+
+                auto start = Instant::now();
+                mixer.mix(out.data(), CALLBACK_SAMPLES);
+                mixedMicros += start.elapsed().micros();
+            }
+
+            // a 0.25 amplitude sine has an average volume of ~0.16, times the volume
+            float loudness = mixed.front()->getLoudness();
+            bool speaking = !mixed.front()->starving;
+
+            log::debug(
+                "Voice output, {} speakers: separate streams {:.2f}us per callback, mixer {:.2f}us per callback, loudness {:.3f}",
+                speakers, separateMicros / static_cast<double>(CALLBACK_COUNT), mixedMicros / static_cast<double>(CALLBACK_COUNT), loudness
+            );
+
+            if (!speaking || loudness < 0.1f || loudness > 0.15f) {
+                log::error("Voice mixer: unexpected state after mixing, speaking = {}, loudness = {}", speaking, loudness);
+            }
+        }
+#endif // GLOBED_VOICE_SUPPORT
+    }
+
+#ifdef GLOBED_VOICE_SUPPORT
+    // Arrival of one voice packet, in seconds. `sequence` is -1 if it wasn't sent
+    struct VoiceArrival {
+        int64_t sequence;
+        size_t frames;
+        double time;
+    };
+
+    struct NetworkProfile {
+        const char* name;
+        double delay;     // base one way delay
+        double jitter;    // extra delay, uniformly distributed between 0 and this
+        double loss;      // chance of a packet getting lost
+        double spikes;    // chance of a packet getting delayed by another 400ms, which also reorders it
+        double drift;     // how much faster the sender's clock runs than ours
+        bool continuous;  // talking without any pauses
+    };
+
+    // Voice packets arriving from a speaker talking in 4.8 second spurts with 1.5 seconds of silence in between, a minute in total.
+    // Seeded, so every run gets the same trace.
+    static std::vector<VoiceArrival> makeVoiceTrace(const NetworkProfile& profile, uint32_t seed) {
+        constexpr size_t PACKET_FRAMES = EncodedAudioFrame::LIMIT_REGULAR;
+        constexpr size_t PACKETS_PER_SPURT = 8;
+        constexpr double SILENCE = 1.5;
+        constexpr double DURATION = 60.0;
+
+        std::mt19937 rng(seed);
+        auto uniform = [&] { return rng() / 4294967296.0; };
+
+        std::vector<VoiceArrival> trace;
+        uint32_t sequence = 0;
+        double time = 0.0;
+
+        while (time < DURATION) {
+            for (size_t i = 0; i < PACKETS_PER_SPURT; i++) {
+                // the packet is sent once all of its frames are recorded
+                time += PACKET_FRAMES * VOICE_CHUNK_RECORD_TIME / (1.0 + profile.drift);
+
+                if (uniform() >= profile.loss) {
+                    double delay = profile.delay + uniform() * profile.jitter + (uniform() < profile.spikes ? 0.4 : 0.0);
+                    trace.push_back(VoiceArrival { sequence, PACKET_FRAMES, time + delay });
+                }
+
+                sequence += PACKET_FRAMES;
+            }
+
+            if (!profile.continuous) {
+                time += SILENCE;
+            }
+        }
+
+        std::stable_sort(trace.begin(), trace.end(), [](auto& a, auto& b) { return a.time < b.time; });
+
+        return trace;
+    }
+
+    // Arrival traces recorded with `VoicePlaybackManager::setTraceRecording`, one per speaker
+    static std::vector<std::pair<std::string, std::vector<VoiceArrival>>> loadVoiceTraces() {
+        std::vector<std::pair<std::string, std::vector<VoiceArrival>>> traces;
+
+        auto folder = Mod::get()->getSaveDir() / "voice-traces";
+        std::error_code ec;
+        if (!std::filesystem::exists(folder, ec)) return traces;
+
+        for (auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+            std::ifstream file(entry.path());
+            std::vector<VoiceArrival> trace;
+
+            VoiceArrival arrival;
+            double millis;
+            while (file >> arrival.sequence >> arrival.frames >> millis) {
+                arrival.time = millis / 1000.0;
+                trace.push_back(arrival);
+            }
+
+            if (!trace.empty()) {
+                traces.emplace_back(entry.path().filename().string(), std::move(trace));
+            }
+        }
+
+        return traces;
+    }
+
+    struct JitterReport {
+        VoiceJitterBuffer::Stats stats;
+        double avgLatency = 0.0; // from the arrival of a frame until it's played, in seconds
+        double p95Latency = 0.0;
+        double maxTarget = 0.0;
+        // frames that would have played silence instead, if frames were played as soon as they arrived
+        size_t directUnderruns = 0;
+
+        double concealmentRate() const {
+            size_t total = stats.played + stats.recovered + stats.concealed;
+            return total ? static_cast<double>(stats.recovered + stats.concealed) / total : 0.0;
+        }
+    };
+
+    // Replays a trace through a jitter buffer, with playback taking out a frame exactly every frame duration
+    static JitterReport replayVoiceTrace(const std::vector<VoiceArrival>& trace) {
+        JitterReport report;
+        if (trace.empty()) return report;
+
+        // the jitter buffer only copies the frames, so the contents don't matter
+        util::data::byte payload[80] = {};
+        std::vector<EncodedOpusData> frames(EncodedAudioFrame::VOICE_MAX_FRAMES_IN_AUDIO_FRAME, EncodedOpusData { payload, sizeof(payload) });
+
+        VoiceJitterBuffer buffer(VOICE_CHUNK_RECORD_TIME);
+        std::unordered_map<uint32_t, double> arrivals;
+        std::vector<double> latencies;
+
+        constexpr double PACKET_DURATION = EncodedAudioFrame::LIMIT_REGULAR * VOICE_CHUNK_RECORD_TIME;
+
+        uint32_t localSequence = 0;
+        size_t next = 0;
+        size_t directQueued = 0, directEmptyTicks = 0;
+        double lastArrival = -PACKET_DURATION * 2;
+
+        double end = trace.back().time + 2.0;
+
+        for (double now = trace.front().time; now < end; now += VOICE_CHUNK_RECORD_TIME) {
+            for (; next < trace.size() && trace[next].time <= now; next++) {
+                auto& arrival = trace[next];
+                size_t count = std::min(arrival.frames, frames.size());
+
+                uint32_t sequence = arrival.sequence >= 0 ? static_cast<uint32_t>(arrival.sequence) : localSequence;
+                localSequence = sequence + static_cast<uint32_t>(count);
+
+                for (size_t i = 0; i < count; i++) {
+                    arrivals[sequence + static_cast<uint32_t>(i)] = arrival.time;
+                }
+
+                buffer.push(sequence, std::span(frames.data(), count), arrival.time);
+
+                // the old playback played frames as soon as they arrived, so the queue ran empty whenever a packet came in late.
+                // a gap of more than a couple of packets is the speaker pausing instead
+                if (directQueued == 0 && arrival.time - lastArrival < PACKET_DURATION * 2) {
+                    report.directUnderruns += directEmptyTicks;
+                }
+
+                directQueued += count;
+                directEmptyTicks = 0;
+                lastArrival = arrival.time;
+            }
+
+            auto out = buffer.pop(now);
+            if (out.action == VoiceJitterBuffer::Action::Play) {
+                latencies.push_back(now - arrivals[out.sequence]);
+            }
+
+            report.maxTarget = std::max(report.maxTarget, buffer.getTargetDelay());
+
+            if (directQueued > 0) {
+                directQueued--;
+            } else {
+                directEmptyTicks++;
+            }
+        }
+
+        report.stats = buffer.getStats();
+
+        if (!latencies.empty()) {
+            std::sort(latencies.begin(), latencies.end());
+
+            double sum = 0.0;
+            for (double l : latencies) sum += l;
+
+            report.avgLatency = sum / latencies.size();
+            report.p95Latency = latencies[latencies.size() * 95 / 100];
+        }
+
+        return report;
+    }
+
+    static void logJitterReport(std::string_view name, const JitterReport& report) {
+        auto& stats = report.stats;
+
+        log::debug(
+            "Jitter buffer, {}: latency avg {:.0f}ms, p95 {:.0f}ms (target up to {:.0f}ms), concealment {:.2f}% ({} fec, {} plc), {} skipped, {} late, {} dropped, {} underruns without the buffer",
+            name, report.avgLatency * 1000.0, report.p95Latency * 1000.0, report.maxTarget * 1000.0, report.concealmentRate() * 100.0,
+            stats.recovered, stats.concealed, stats.skipped, stats.late, stats.dropped, report.directUnderruns
+        );
+    }
+#endif // GLOBED_VOICE_SUPPORT
+
+    void voiceJitter() {
+#ifdef GLOBED_VOICE_SUPPORT
+        constexpr NetworkProfile PROFILES[] = {
+            { "lan", 0.005, 0.002, 0.0, 0.0, 0.0, false },
+            { "wifi", 0.030, 0.040, 0.01, 0.0, 0.0, false },
+            { "mobile", 0.080, 0.150, 0.03, 0.02, 0.0, false },
+            { "fast sender clock", 0.030, 0.010, 0.0, 0.0, 0.005, true },
+        };
+
+        for (auto& profile : PROFILES) {
+            auto report = replayVoiceTrace(makeVoiceTrace(profile, 0x676c6f62));
+            logJitterReport(profile.name, report);
+
+            if (profile.loss == 0.0 && profile.spikes == 0.0 && report.concealmentRate() != 0.0) {
+                log::error("Jitter buffer: concealed frames on a lossless network ({})", profile.name);
+            }
+
+            if (profile.drift > 0.0 && report.stats.dropped == 0) {
+                log::error("Jitter buffer: no frames dropped to make up for clock drift ({})", profile.name);
+            }
+        }
+
+        auto recorded = loadVoiceTraces();
+        if (recorded.empty()) {
+            log::debug("No recorded voice traces found (enable packet logging while others are talking to record some)");
+        }
+
+        for (auto& [name, trace] : recorded) {
+            logJitterReport(name, replayVoiceTrace(trace));
+        }
+#endif // GLOBED_VOICE_SUPPORT
+    }
+
+    void interpolation() {
+        constexpr size_t PLAYERS = 1000;
+        constexpr size_t LANES = PLAYERS * 6;
+        constexpr float TPS = 30.f;
+        constexpr float FRAME_DT = 1.f / 240.f;
+        constexpr size_t FRAMES = 240 * 20; // 20 seconds
+
+        auto trace = makeSyntheticTrace();
+
+        // the kernel alone, on the layout the interpolator gathers into
+        std::mt19937 rng(0x676c6f62);
+        std::uniform_real_distribution<float> posDist(-1000.f, 1000.f), ratioDist(0.f, 1.f);
+
+        std::vector<float> from(LANES), to(LANES), ratio(LANES), outFast(LANES), outSlow(LANES);
+        for (size_t i = 0; i < LANES; i++) {
+            from[i] = posDist(rng);
+            to[i] = from[i] + posDist(rng) / 100.f;
+            ratio[i] = ratioDist(rng);
+        }
+
+        auto start = Instant::now();
+        for (size_t i = 0; i < FRAMES; i++) {
+            util::math::lerpSlow(from.data(), to.data(), ratio.data(), outSlow.data(), LANES);
+        }
+        auto slowTook = start.elapsed();
+
+        start = Instant::now();
+        for (size_t i = 0; i < FRAMES; i++) {
+            util::simd::lerp(from.data(), to.data(), ratio.data(), outFast.data(), LANES);
+        }
+        auto fastTook = start.elapsed();
+
+        float maxError = 0.f;
+        for (size_t i = 0; i < LANES; i++) {
+            maxError = std::max(maxError, std::abs(outFast[i] - outSlow[i]));
+        }
+
+        log::debug(
+            "Lerp kernel, {} lanes: scalar {:.2f}us, simd {:.2f}us per call, max difference {}",
+            LANES, slowTook.micros() / static_cast<double>(FRAMES), fastTook.micros() / static_cast<double>(FRAMES), maxError
+        );
+
+        if (maxError > 0.001f) {
+            log::error("Lerp kernel: simd results differ from the scalar ones by {}", maxError);
+        }
+
+        // how interpolation used to work: a hash map of two frames per player, lerped one player at a time,
+        // and looked up again by id to read the result
+        struct MapState {
+            PlayerData older, newer;
+            VisualPlayerState out;
+        };
+
+        std::unordered_map<int, MapState> mapPlayers;
+        for (size_t p = 0; p < PLAYERS; p++) {
+            mapPlayers.emplace(static_cast<int>(p) + 1000, MapState{trace[0], trace[1], {}});
+        }
+
+        // the interpolator, fed with the same trace (offset for every player) at the server tickrate
+        PlayerInterpolator interpolator(InterpolatorSettings {
+            .realtime = false,
+            .isPlatformer = false,
+            .expectedDelta = 1.f / TPS,
+            .minDelay = 1.f / TPS,
+            .maxDelay = 0.4f,
+            .extrapolation = true,
+            .maxExtrapolation = 0.25f,
+        });
+
+        for (size_t p = 0; p < PLAYERS; p++) {
+            interpolator.addPlayer(static_cast<int>(p) + 1000);
+        }
+
+        uint64_t mapMicros = 0, soaMicros = 0;
+        size_t nextSnapshot = 0;
+        float localTs = 0.f;
+        float checksum = 0.f;
+
+        for (size_t frame = 0; frame < FRAMES; frame++) {
+            localTs += FRAME_DT;
+
+            if (localTs >= nextSnapshot / TPS && nextSnapshot < trace.size()) {
+                for (size_t p = 0; p < PLAYERS; p++) {
+                    PlayerData data = trace[nextSnapshot];
+                    data.player1.position.y += static_cast<float>(p);
+                    interpolator.updatePlayer(static_cast<int>(p) + 1000, data, localTs);
+
+                    auto& state = mapPlayers.at(static_cast<int>(p) + 1000);
+                    state.older = state.newer;
+                    state.newer = data;
+                }
+
+                nextSnapshot++;
+            }
+
+            start = Instant::now();
+            for (auto& [id, state] : mapPlayers) {
+                float delta = state.newer.timestamp - state.older.timestamp;
+                float lerpRatio = delta == 0.f ? 0.f : std::clamp((localTs - FRAME_DT * 8 - state.older.timestamp) / delta, 0.f, 1.f);
+
+                for (auto [o, n, out] : {
+                    std::tuple{&state.older.player1, &state.newer.player1, &state.out.player1},
+                    std::tuple{&state.older.player2, &state.newer.player2, &state.out.player2}
+                }) {
+                    out->copyFlagsFrom(*o);
+                    out->position = o->position.lerp(n->position, lerpRatio);
+                    out->rotation = o->rotation + util::math::angleDifference(o->rotation, n->rotation) * lerpRatio;
+                }
+            }
+
+            for (size_t p = 0; p < PLAYERS; p++) {
+                checksum += mapPlayers.at(static_cast<int>(p) + 1000).out.player1.position.x;
+            }
+            mapMicros += start.elapsed().micros();
+
+            start = Instant::now();
+            interpolator.tick(FRAME_DT, localTs);
+
+            for (size_t p = 0; p < PLAYERS; p++) {
+                auto slot = interpolator.getSlot(static_cast<int>(p) + 1000);
+                checksum += interpolator.getPlayerStateAt(*slot).player1.position.x;
+            }
+            soaMicros += start.elapsed().micros();
+        }
+
+        log::debug(
+            "Interpolation, {} players: per player from a map {:.2f}us, interpolator {:.2f}us per frame (checksum {})",
+            PLAYERS, mapMicros / static_cast<double>(FRAMES), soaMicros / static_cast<double>(FRAMES), checksum
+        );
+
+        // every player follows the same trace, shifted up by its index
+        auto& first = interpolator.getPlayerState(1000);
+        auto& last = interpolator.getPlayerState(static_cast<int>(1000 + PLAYERS - 1));
+        float shift = last.player1.position.y - first.player1.position.y;
+
+        if (std::abs(shift - (PLAYERS - 1)) > 0.01f || std::abs(last.player1.position.x - first.player1.position.x) > 0.01f) {
+            log::error("Interpolator: players with the same trace ended up in different places (vertical shift {})", shift);
+        }
+    }
+
+    void collisionBroadphase() {
+        constexpr size_t PLAYERS = 500;
+        constexpr size_t FRAMES = 60 * 20; // 20 seconds
+        constexpr size_t SUBSTEPS = 4;     // physics steps per frame at 60 fps
+        constexpr float FRAME_DT = 1.f / 60.f;
+        constexpr float SPEED = 311.58f;   // normal speed, units per second
+        constexpr float SIZE = 30.f;
+
+        // players spread over the first part of the level at different heights, bouncing up and down
+        std::mt19937 rng(0x676c6f62);
+        std::uniform_real_distribution<float> startDist(0.f, 3000.f), heightDist(105.f, 600.f), phaseDist(0.f, 6.28f);
+
+        // stands in for a PlayerObject, which is a few kilobytes on the heap, the rect is all that gets read
+        struct SimObject {
+            CCRect rect;
+            char rest[2048];
+        };
+
+        struct SimPlayer {
+            float x, y, phase;
+            std::unique_ptr<SimObject> player1, player2;
+        };
+
+        std::unordered_map<int, SimPlayer> players;
+        for (size_t p = 0; p < PLAYERS; p++) {
+            players.emplace(static_cast<int>(p) + 1000, SimPlayer {
+                startDist(rng), heightDist(rng), phaseDist(rng), std::make_unique<SimObject>(), std::make_unique<SimObject>()
+            });
+        }
+
+        SpatialGrid grid;
+        std::vector<int> gridPlayers;
+
+        uint64_t bruteMicros = 0, gridMicros = 0;
+        size_t bruteHits = 0, gridHits = 0, mismatches = 0;
+        std::vector<std::pair<size_t, int>> bruteFound, gridFound;
+
+        for (size_t frame = 0; frame < FRAMES; frame++) {
+            float time = frame * FRAME_DT;
+
+            for (auto& [_, sim] : players) {
+                float x = sim.x + time * SPEED;
+                float y = sim.y + std::sin(time * 4.f + sim.phase) * 60.f;
+
+                sim.player1->rect = CCRect{x, y, SIZE, SIZE};
+                // the second player a bit higher, as in dual mode
+                sim.player2->rect = CCRect{x, y + 90.f, SIZE, SIZE};
+            }
+
+            // our two players move through the middle of the crowd
+            std::array<CCRect, SUBSTEPS * 2> ours;
+            for (size_t step = 0; step < SUBSTEPS; step++) {
+                float stepTime = time + step * FRAME_DT / SUBSTEPS;
+                float y = std::sin(stepTime * 3.f) * 100.f;
+
+                ours[step * 2] = CCRect{1500.f + stepTime * SPEED, 300.f + y, SIZE, SIZE};
+                ours[step * 2 + 1] = CCRect{1500.f + stepTime * SPEED, 420.f + y, SIZE, SIZE};
+            }
+
+            // what collision used to do, every step tests every remote player
+            auto start = Instant::now();
+            bruteFound.clear();
+            for (size_t q = 0; q < ours.size(); q++) {
+                for (auto& [id, sim] : players) {
+                    if (ours[q].intersectsRect(sim.player1->rect)) {
+                        bruteFound.emplace_back(q, id * 2);
+                    }
+
+                    if (ours[q].intersectsRect(sim.player2->rect)) {
+                        bruteFound.emplace_back(q, id * 2 + 1);
+                    }
+                }
+            }
+            bruteMicros += start.elapsed().micros();
+
+            // the grid is built once per frame, then every step only tests its neighbours
+            start = Instant::now();
+            grid.clear();
+            gridPlayers.clear();
+            for (auto& [id, sim] : players) {
+                uint32_t idx = static_cast<uint32_t>(gridPlayers.size());
+                gridPlayers.push_back(id);
+
+                grid.insert(sim.player1->rect, idx * 2);
+                grid.insert(sim.player2->rect, idx * 2 + 1);
+            }
+            grid.build();
+
+            gridFound.clear();
+            for (size_t q = 0; q < ours.size(); q++) {
+                grid.query(ours[q], [&](uint32_t value) {
+                    int id = gridPlayers[value / 2];
+                    auto& sim = players.at(id);
+
+                    // exact test against the object itself, like the collision module does
+                    if (ours[q].intersectsRect(value % 2 ? sim.player2->rect : sim.player1->rect)) {
+                        gridFound.emplace_back(q, id * 2 + static_cast<int>(value % 2));
+                    }
+                });
+            }
+            gridMicros += start.elapsed().micros();
+
+            std::sort(bruteFound.begin(), bruteFound.end());
+            std::sort(gridFound.begin(), gridFound.end());
+            if (bruteFound != gridFound) {
+                mismatches++;
+            }
+
+            bruteHits += bruteFound.size();
+            gridHits += gridFound.size();
+        }
+
+        log::debug(
+            "Collision broadphase, {} players and {} physics steps: testing all {:.2f}us, grid {:.2f}us per frame including the rebuild ({} hits, {} with the grid)",
+            PLAYERS, SUBSTEPS,
+            bruteMicros / static_cast<double>(FRAMES),
+            gridMicros / static_cast<double>(FRAMES),
+            bruteHits, gridHits
+        );
+
+        if (mismatches != 0) {
+            log::error("Collision broadphase: the grid found different players than testing all of them in {} frames", mismatches);
+        }
+    }
+}
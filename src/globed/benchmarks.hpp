@@ -0,0 +1,57 @@
+#pragma once
+#include <defs/minimal_geode.hpp>
+
+// Benchmarks for the hot paths of the mod. They are never run automatically,
+// but can be started from the advanced settings popup. Results are written to the log.
+namespace globed::bench {
+    // Run every benchmark in this file
+    void runAll();
+
+    // UDP throughput against a loopback echo server, one datagram per syscall versus batched I/O
+    void udpThroughput();
+
+    // Encoding (and encrypting) outgoing packets into a fresh buffer versus the reused send arena
+    void encodePackets();
+
+    // Decoding a LevelDataPacket with 100 players from a copy of the received data versus reading it in place
+    void decodePackets();
+
+    // Encoding and decoding vectors of primitives in packets element by element versus in bulk
+    void bulkVectors();
+
+    // Latency between queueing a packet and sending it, old channel + sleep loop versus the reactor used by the network thread
+    void sendLatency();
+
+    // Dispatching received packets to listeners, map + sort per packet versus the presorted listener table
+    void dispatchListeners();
+
+    // Bytes per player per second of full versus delta coded player data, over recorded level data packets if there are any
+    void playerDataSize();
+
+    // Round trip of player positions through the compact icon data encoding, checking that interpolated positions stay within a pixel
+    void compactIconData();
+
+    // Encrypt and decrypt throughput of CryptoBox for 64B to 4KB messages, random versus counter based nonces
+    void cryptoThroughput();
+
+    // Decrypting messages in place with both nonce modes, checking the plaintext is returned at its offset after the prefix
+    void decryptInPlace();
+
+    // Stress test of AudioSampleQueue with 50 streams at 24 kHz, and the cost of playback callbacks with the old vector queue versus the ring
+    void sampleQueue();
+
+    // Encoding and decoding voice frames through pooled buffers, checking that no frame buffers are allocated once the pool is warm
+    void voiceAllocations();
+
+    // CPU cost of playing 5, 20 and 50 speakers through one FMOD stream each versus the voice mixer
+    void voiceMixer();
+
+    // Replays synthetic and recorded voice arrival traces through the jitter buffer, reporting latency and concealment rate
+    void voiceJitter();
+
+    // Interpolating 1000 players per frame, per player lerps out of a hash map versus the batched simd kernel, and the kernel on its own
+    void interpolation();
+
+    // Finding the remote players colliding with ours, with 500 players moving through a level, testing all of them versus the spatial grid
+    void collisionBroadphase();
+}
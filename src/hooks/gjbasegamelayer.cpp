@@ -17,6 +17,8 @@
 #include <data/packets/client/general.hpp>
 #include <data/packets/server/game.hpp>
 #include <game/module/all.hpp>
+#include <net/clock_sync.hpp>
+#include <net/udp_frame_buffer.hpp>
 #include <game/camera_state.hpp>
 #include <hooks/game_manager.hpp>
 #include <hooks/triggers/gjeffectmanager.hpp>
@@ -305,35 +307,32 @@ void GlobedGJBGL::setupPacketListeners() {
     });
 
     nm.addListener<LevelDataPacket>(this, [this](std::shared_ptr<LevelDataPacket> packet){
+        this->handleLevelData(packet->players, packet->customItems, this->levelDataPacketTime(packet->serverTime.micros));
+    });
+
+    nm.addListener<LevelDataDeltaPacket>(this, [this](std::shared_ptr<LevelDataDeltaPacket> packet) {
         auto& fields = this->getFields();
+        float packetTime = this->levelDataPacketTime(packet->serverTime.micros);
 
-        fields.lastServerUpdate = fields.timeCounter;
-        bool firstPacket = util::misc::swapFlag(fields.firstReceivedData);
+        if (packet->ackedKeyframe) {
+            fields.deltaEncoder.acknowledge(*packet->ackedKeyframe);
+        }
 
-        for (const auto& player : packet->players) {
-            if (!fields.players.contains(player.accountId)) {
-                // new player joined
-                this->handlePlayerJoin(player.accountId);
-            }
+        std::vector<AssociatedPlayerData> players;
+        players.reserve(packet->players.size());
 
-            fields.interpolator->updatePlayer(player.accountId, player.data, fields.lastServerUpdate);
-        }
+        for (const auto& player : packet->players) {
+            auto result = fields.deltaDecoders[player.accountId].decode(player.frame);
 
-#ifdef GLOBED_GP_CHANGES
-        if (packet->customItems) {
-            for (const auto& [itemId, value] : *packet->customItems) {
-                static_cast<GJEffectManagerHook*>(m_effectManager)->applyItem(
-                    globed::customItemToItemId(itemId),
-                    value
-                );
+            if (result) {
+                players.emplace_back(player.accountId, result.unwrap());
+            } else if (fields.interpolator->hasPlayer(player.accountId)) {
+                // the keyframe was lost, the next one will fix it. until then, the player is still on the level
+                fields.interpolator->keepPlayer(player.accountId, packetTime);
             }
         }
 
-        if (firstPacket) {
-            fields.lastJoinedPlayer = GJAccountManager::get()->m_accountID;
-            this->updateCountersForCustomItem(globed::ITEM_LAST_JOINED);
-        }
-#endif
+        this->handleLevelData(players, packet->customItems, packetTime);
     });
 
     nm.addListener<LevelPlayerMetadataPacket>(this, [this](std::shared_ptr<LevelPlayerMetadataPacket> packet) {
@@ -366,11 +365,9 @@ void GlobedGJBGL::setupPacketListeners() {
 
             vpm.setVolume(packet->sender, settings.communication.voiceVolume);
             this->updateProximityVolume(packet->sender);
-            auto result = vpm.playFrameStreamed(packet->sender, packet->frame);
 
-            if (result.isErr()) {
-                ErrorQueues::get().debugWarn(std::string("Failed to play a voice frame: ") + result.unwrapErr());
-            }
+            // decoded on a voice worker, the frame keeps the packet alive until then
+            vpm.queueFrameStreamed(packet->sender, std::shared_ptr<const EncodedAudioFrame>(packet, &packet->frame));
         } catch(const std::exception& e) {
             ErrorQueues::get().debugWarn(std::string("Failed to play a voice frame: ") + e.what());
         }
@@ -427,11 +424,17 @@ void GlobedGJBGL::setupMisc() {
     // set the configured tps
     fields.configuredTps = nm.getServerTps();
 
+    fields.useDeltaPlayerData = settings.globed.deltaPlayerData && nm.getServerProtocol() >= DELTA_PLAYER_DATA_PROTOCOL;
+
     // interpolator
     fields.interpolator = std::make_unique<PlayerInterpolator>(InterpolatorSettings {
         .realtime = false,
         .isPlatformer = m_level->isPlatformer(),
-        .expectedDelta = (1.0f / fields.configuredTps)
+        .expectedDelta = (1.0f / fields.configuredTps),
+        .minDelay = (1.0f / fields.configuredTps),
+        .maxDelay = 0.4f,
+        .extrapolation = settings.players.extrapolation,
+        .maxExtrapolation = 0.25f,
     });
 
     // player store
@@ -594,10 +597,70 @@ void GlobedGJBGL::selSendPlayerData(float) {
         meta = self->gatherPlayerMetadata();
     }
 
-    NetworkManager::get().send(PlayerDataPacket::create(data, meta, std::move(fields.pendingCounterChanges)));
+    if (fields.useDeltaPlayerData) {
+        std::vector<PlayerKeyframeAck> acks;
+
+        for (const auto& [playerId, decoder] : fields.deltaDecoders) {
+            auto keyframe = decoder.latestKeyframe();
+            if (keyframe && !decoder.isAcknowledged()) {
+                acks.push_back(PlayerKeyframeAck { .accountId = playerId, .keyframeId = *keyframe });
+            }
+        }
+
+        auto frame = fields.deltaEncoder.encode(data);
+        NetworkManager::get().send(PlayerDataDeltaPacket::create(frame, std::move(acks), meta, std::move(fields.pendingCounterChanges)));
+    } else {
+        NetworkManager::get().send(PlayerDataPacket::create(data, meta, std::move(fields.pendingCounterChanges)));
+    }
 #undef this
 }
 
+float GlobedGJBGL::levelDataPacketTime(uint64_t serverTime) {
+    float now = this->getFields().timeCounter;
+
+    // place the data at the time the server sent it rather than when we got around to handling it,
+    // which leaves the jitter of the way here and of waiting for the next frame out of the interpolation.
+    // an age that makes no sense means the clocks aren't properly synchronized yet
+    auto age = NetworkManager::get().getServerTimeAge(serverTime);
+    if (age && std::abs(*age) < 1.0) {
+        return now - static_cast<float>(*age);
+    }
+
+    return now;
+}
+
+void GlobedGJBGL::handleLevelData(const std::vector<AssociatedPlayerData>& players, const std::optional<std::map<uint16_t, int>>& customItems, float packetTime) {
+    auto& fields = this->getFields();
+
+    fields.lastServerUpdate = packetTime;
+    bool firstPacket = util::misc::swapFlag(fields.firstReceivedData);
+
+    for (const auto& player : players) {
+        if (!fields.players.contains(player.accountId)) {
+            // new player joined
+            this->handlePlayerJoin(player.accountId);
+        }
+
+        fields.interpolator->updatePlayer(player.accountId, player.data, fields.lastServerUpdate);
+    }
+
+#ifdef GLOBED_GP_CHANGES
+    if (customItems) {
+        for (const auto& [itemId, value] : *customItems) {
+            static_cast<GJEffectManagerHook*>(m_effectManager)->applyItem(
+                globed::customItemToItemId(itemId),
+                value
+            );
+        }
+    }
+
+    if (firstPacket) {
+        fields.lastJoinedPlayer = GJAccountManager::get()->m_accountID;
+        this->updateCountersForCustomItem(globed::ITEM_LAST_JOINED);
+    }
+#endif
+}
+
 // selSendPlayerMetadata - runs every 10 seconds
 void GlobedGJBGL::selSendPlayerMetadata(float) {
 #define this GLOBED_INVALID_THIS
@@ -633,6 +696,9 @@ void GlobedGJBGL::selPeriodicalUpdate(float dt) {
         fields.overlay->updatePing(server->ping);
     }
 
+    fields.overlay->updateFrameStats(NetworkManager::get().getFrameStats());
+    fields.overlay->updateClockStats(NetworkManager::get().getClockStats());
+
     auto& pcm = ProfileCacheManager::get();
 
     util::collections::SmallVector<int, 32> toRemove;
@@ -784,6 +850,7 @@ void GlobedGJBGL::selUpdate(float timescaledDt) {
 
     fields.timeCounter += dt;
 
+    fields.interpolator->setExtrapolation(GlobedSettings::get().players.extrapolation);
     fields.interpolator->tick(dt);
 
     // update progress indicators only if in PlayLayer
@@ -802,14 +869,15 @@ void GlobedGJBGL::selUpdate(float timescaledDt) {
 
     for (const auto [playerId, remotePlayer] : fields.players) {
         // this should never happen, yet somehow it does for that one person
-        if (!fields.interpolator->hasPlayer(playerId)) {
+        auto slot = fields.interpolator->getSlot(playerId);
+        if (!slot) {
             log::error("Interpolator is missing a player: {}", playerId);
             continue;
         }
 
-        auto& vstate = fields.interpolator->getPlayerState(playerId);
+        auto& vstate = fields.interpolator->getPlayerStateAt(*slot);
 
-        auto frameFlags = fields.interpolator->swapFrameFlags(playerId);
+        auto frameFlags = fields.interpolator->swapFrameFlagsAt(*slot);
 
         bool isSpeaking = vpm.isSpeaking(playerId);
         remotePlayer->updateData(
@@ -1204,6 +1272,7 @@ void GlobedGJBGL::handlePlayerLeave(int playerId) {
     fields.players.erase(playerId);
     fields.interpolator->removePlayer(playerId);
     fields.playerStore->removePlayer(playerId);
+    fields.deltaDecoders.erase(playerId);
 
     fields.lastLeftPlayer = playerId;
     fields.totalLeaves++;
@@ -5,6 +5,7 @@
 
 #include <globed.hpp>
 
+#include <data/types/player_delta.hpp>
 #include <data/types/room.hpp>
 #include <game/interpolator.hpp>
 #include <game/player_store.hpp>
@@ -91,6 +92,11 @@ struct GLOBED_DLL GlobedGJBGL : geode::Modify<GlobedGJBGL, GJBaseGameLayer> {
 
         std::vector<GlobedCounterChange> pendingCounterChanges;
 
+        // delta coded player data, only used if enabled and supported by the server
+        bool useDeltaPlayerData = false;
+        PlayerDataDeltaEncoder deltaEncoder;
+        std::unordered_map<int, PlayerDataDeltaDecoder> deltaDecoders;
+
         // readonly custom items
         int lastJoinedPlayer = 0; // 1
         int lastLeftPlayer = 0;   // 2
@@ -171,6 +177,12 @@ struct GLOBED_DLL GlobedGJBGL : geode::Modify<GlobedGJBGL, GJBaseGameLayer> {
     void handlePlayerJoin(int playerId);
     void handlePlayerLeave(int playerId);
 
+    // applies player data and custom items received from the server, `packetTime` is when the server sent them on our time counter
+    void handleLevelData(const std::vector<AssociatedPlayerData>& players, const std::optional<std::map<uint16_t, int>>& customItems, float packetTime);
+
+    // when a level data packet stamped with `serverTime` was sent, on our time counter. the current time counter if the clocks aren't synchronized
+    float levelDataPacketTime(uint64_t serverTime);
+
     /* misc */
 
     bool established();
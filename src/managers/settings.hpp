@@ -264,6 +264,8 @@ public:
         Setting<bool, false> increaseLevelList;
         Setting<int, 0> fragmentationLimit;
         Setting<bool, false> forceTcp;
+        Setting<bool, true> batchedUdp;
+        Setting<bool, false> deltaPlayerData;
         Setting<bool, false> showRelays;
         Setting<bool, false> compressedPlayerCount;
         Setting<bool, true> useDiscordRPC;
@@ -299,6 +301,7 @@ public:
         Setting<int, 0> audioDevice;
         Setting<bool, true> deafenNotification;
         Setting<bool, false> voiceLoopback; // TODO unimpl
+        Setting<bool, false> voiceMixer;
     };
 
     struct LevelUI {
@@ -322,6 +325,7 @@ public:
         Setting<bool, false> ownName;
         Setting<bool, false> rotateNames;
         Setting<bool, false> hidePracticePlayers;
+        Setting<bool, true> extrapolation;
     };
 
     struct Advanced {};
@@ -432,7 +436,7 @@ GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::LaunchArgs, (
 // Settings
 
 GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::Globed, (
-    autoconnect, preloadAssets, deferPreloadAssets, invitesFrom, editorSupport, increaseLevelList, fragmentationLimit, forceTcp, showRelays,
+    autoconnect, preloadAssets, deferPreloadAssets, invitesFrom, editorSupport, increaseLevelList, fragmentationLimit, forceTcp, batchedUdp, deltaPlayerData, showRelays,
     compressedPlayerCount, useDiscordRPC, editorChanges, changelogPopups, pinnedLevelCollapsed,
     isInvisible, noInvites, hideInGame, hideRoles
 ));
@@ -442,7 +446,7 @@ GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::Overlay, (
 ));
 
 GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::Communication, (
-    voiceEnabled, voiceProximity, classicProximity, voiceVolume, onlyFriends, lowerAudioLatency, tcpAudio, audioDevice, deafenNotification, voiceLoopback
+    voiceEnabled, voiceProximity, classicProximity, voiceVolume, onlyFriends, lowerAudioLatency, tcpAudio, audioDevice, deafenNotification, voiceLoopback, voiceMixer
 ));
 
 GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::LevelUI, (
@@ -450,7 +454,7 @@ GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::LevelUI, (
 ));
 
 GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::Players, (
-    playerOpacity, showNames, dualName, nameOpacity, statusIcons, deathEffects, defaultDeathEffect, hideNearby, forceVisibility, ownName, hidePracticePlayers, rotateNames
+    playerOpacity, showNames, dualName, nameOpacity, statusIcons, deathEffects, defaultDeathEffect, hideNearby, forceVisibility, ownName, hidePracticePlayers, rotateNames, extrapolation
 ));
 
 GLOBED_SERIALIZABLE_STRUCT(GlobedSettings::Advanced, ());
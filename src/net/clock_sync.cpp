@@ -0,0 +1,135 @@
+#include "clock_sync.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace asp::time;
+
+ClockSync::ClockSync() : epoch(Instant::now()) {}
+
+double ClockSync::localNow() const {
+    return epoch.elapsed().micros() / 1'000'000.0;
+}
+
+void ClockSync::addSample(double sent, uint64_t serverTime, double received) {
+    if (received < sent) return;
+
+    Sample s {
+        .local = (sent + received) / 2.0,
+        .offset = serverTime / 1'000'000.0 - (sent + received) / 2.0,
+        .rtt = received - sent,
+    };
+
+    if (totalSamples == 0) {
+        firstOffset = s.offset;
+    } else {
+        jitter += (std::abs(s.offset - this->offsetAt(s.local)) - jitter) / 8.0;
+    }
+
+    if (sampleCount == WINDOW) {
+        sampleStart = (sampleStart + 1) % WINDOW;
+        sampleCount--;
+    }
+
+    samples[(sampleStart + sampleCount++) % WINDOW] = s;
+    totalSamples++;
+
+    this->update();
+}
+
+bool ClockSync::isSynchronized() const {
+    return totalSamples > 0;
+}
+
+double ClockSync::offsetAt(double local) const {
+    return baseOffset + skew * (local - baseLocal);
+}
+
+double ClockSync::toLocal(uint64_t serverTime) const {
+    // solve serverTime = t + offsetAt(t) for t
+    return (serverTime / 1'000'000.0 - baseOffset + skew * baseLocal) / (1.0 + skew);
+}
+
+ClockSyncStats ClockSync::getStats() const {
+    double now = this->localNow();
+
+    return ClockSyncStats {
+        .samples = totalSamples,
+        .offset = this->offsetAt(now),
+        .drift = totalSamples > 0 ? this->offsetAt(now) - firstOffset : 0.0,
+        .skew = skew,
+        .rtt = bestRtt,
+        .jitter = jitter,
+    };
+}
+
+void ClockSync::reset() {
+    sampleStart = 0;
+    sampleCount = 0;
+    totalSamples = 0;
+    baseLocal = 0.0;
+    baseOffset = 0.0;
+    skew = 0.0;
+    bestRtt = 0.0;
+    firstOffset = 0.0;
+    jitter = 0.0;
+}
+
+const ClockSync::Sample& ClockSync::sample(size_t i) const {
+    return samples[(sampleStart + i) % WINDOW];
+}
+
+void ClockSync::update() {
+    // the offset from the recent exchange with the lowest round trip, it has the least room for asymmetric delays
+    const Sample* best = nullptr;
+    for (size_t i = sampleCount - std::min(sampleCount, FILTER_SAMPLES); i < sampleCount; i++) {
+        auto& s = this->sample(i);
+        if (!best || s.rtt < best->rtt) best = &s;
+    }
+
+    baseLocal = best->local;
+    baseOffset = best->offset;
+    bestRtt = best->rtt;
+
+    // least squares fit of the offset over time, through the exchanges that weren't delayed much
+    double minRtt = best->rtt;
+    for (size_t i = 0; i < sampleCount; i++) {
+        minRtt = std::min(minRtt, this->sample(i).rtt);
+    }
+
+    double maxRtt = minRtt + std::max(0.002, minRtt * 0.2);
+    double sumT = 0.0, sumO = 0.0, sumTT = 0.0, sumTO = 0.0;
+    double firstT = 0.0, lastT = 0.0;
+    size_t n = 0;
+
+    for (size_t i = 0; i < sampleCount; i++) {
+        auto& s = this->sample(i);
+        if (s.rtt > maxRtt) continue;
+
+        // relative to the base sample, to keep the numbers small
+        double t = s.local - baseLocal;
+        double o = s.offset - baseOffset;
+
+        if (n == 0) firstT = t;
+        lastT = t;
+
+        sumT += t;
+        sumO += o;
+        sumTT += t * t;
+        sumTO += t * o;
+        n++;
+    }
+
+    // keep the previous skew if there isn't enough to fit a new one
+    if (n < 3 || lastT - firstT < MIN_SKEW_SPAN) return;
+
+    double denom = n * sumTT - sumT * sumT;
+    if (denom <= 0.0) return;
+
+    double slope = (n * sumTO - sumT * sumO) / denom;
+    if (std::abs(slope) > MAX_SKEW) return;
+
+    // the fitted line averages out the noise of single exchanges, use it for the offset too
+    skew = slope;
+    baseOffset += (sumO - slope * sumT) / n;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <asp/time/Instant.hpp>
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+
+// Current state of a `ClockSync`
+struct ClockSyncStats {
+    size_t samples = 0;
+    // server time minus local time, in seconds
+    double offset = 0.0;
+    // how much the offset changed since the first exchange, in seconds
+    double drift = 0.0;
+    // how much faster the server's clock runs than ours, in seconds per second
+    double skew = 0.0;
+    // round trip time of the exchange the offset is taken from, in seconds
+    double rtt = 0.0;
+    // how far the measured offsets are from the estimate on average, in seconds
+    double jitter = 0.0;
+};
+
+/*
+* NTP style estimate of how the server's clock relates to ours, from the timestamps of keepalive exchanges.
+* Every exchange gives an offset between the clocks, which is off by at most half of its round trip time,
+* so the offset is taken from the exchange with the lowest round trip out of the recent ones, and the skew
+* (the clocks running at slightly different speeds) from a line fitted through the good exchanges.
+*
+* Local times are in seconds since the object was created, server times in microseconds of the server's clock.
+* Not thread safe.
+*/
+class ClockSync {
+public:
+    // how many exchanges are kept for fitting the skew
+    static constexpr size_t WINDOW = 16;
+    // the offset is taken from the best of this many newest exchanges, so an old one can't be used forever
+    static constexpr size_t FILTER_SAMPLES = 8;
+    // the skew is only fitted once the exchanges span at least this long, in seconds
+    static constexpr double MIN_SKEW_SPAN = 20.0;
+    // real clocks don't drift apart faster than this, a steeper fit is a bad one
+    static constexpr double MAX_SKEW = 500e-6;
+
+    ClockSync();
+
+    // the current local time
+    double localNow() const;
+
+    // a keepalive sent at local time `sent` was answered by the server when its clock read `serverTime`,
+    // and the answer arrived at local time `received`
+    void addSample(double sent, uint64_t serverTime, double received);
+
+    // true once there has been at least one exchange
+    bool isSynchronized() const;
+
+    // server time minus local time, at the local time `local`
+    double offsetAt(double local) const;
+
+    // the local time at which the server's clock read `serverTime`, only meaningful if synchronized
+    double toLocal(uint64_t serverTime) const;
+
+    ClockSyncStats getStats() const;
+
+    void reset();
+
+private:
+    struct Sample {
+        double local; // halfway between sending and receiving
+        double offset;
+        double rtt;
+    };
+
+    asp::time::Instant epoch;
+
+    std::array<Sample, WINDOW> samples;
+    size_t sampleStart = 0, sampleCount = 0, totalSamples = 0;
+
+    // offset(t) = baseOffset + skew * (t - baseLocal)
+    double baseLocal = 0.0, baseOffset = 0.0, skew = 0.0, bestRtt = 0.0;
+    double firstOffset = 0.0;
+    double jitter = 0.0;
+
+    const Sample& sample(size_t i) const;
+    void update();
+};
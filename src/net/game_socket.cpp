@@ -16,6 +16,10 @@
 #endif
 
 constexpr size_t DATA_BUF_SIZE = 2 << 18;
+// batched udp receives split the data buffer into slots that fit any datagram
+constexpr size_t UDP_BATCH_SLOT_SIZE = 1 << 16;
+constexpr size_t UDP_BATCH_COUNT = std::min(DATA_BUF_SIZE / UDP_BATCH_SLOT_SIZE, UdpSocket::MAX_BATCH);
+constexpr size_t UDP_MAX_DRAIN_ROUNDS = 16;
 constexpr uint32_t RELAY_MAGIC = 0x7f8a9b0c;
 constexpr uint32_t RELAY_MAGIC_SKIP_LINK = 0x7f8a9b0d;
 
@@ -50,6 +54,8 @@ Result<> GameSocket::connect(const NetworkAddress& address, bool isRecovering) {
     log::debug("Connecting to {} (resolved to {})", address.toString(), resolved);
 #endif
 
+    tcpPartial = {};
+
     GLOBED_UNWRAP(tcpSocket.connect(address))
     GLOBED_UNWRAP(udpSocket.connect(address))
 
@@ -59,6 +65,13 @@ Result<> GameSocket::connect(const NetworkAddress& address, bool isRecovering) {
     uint8_t byte = isRecovering ? MARKER_CONN_RECOVERY : MARKER_CONN_INITIAL;
     GLOBED_UNWRAP(tcpSocket.send(reinterpret_cast<const char*>(&byte), 1));
 
+    // the session continues over a new tcp connection, so messages that were lost with the old one must not desync the counters
+    if (isRecovering && cryptoBox) {
+        // encrypting happens while the send arena is locked
+        auto arena = sendArena.lock();
+        cryptoBox->startTcpStream();
+    }
+
     return Ok();
 }
 
@@ -83,6 +96,7 @@ void GameSocket::disconnect() {
     tcpSocket.disconnect();
     udpSocket.disconnect();
     udpBuffer.clear();
+    tcpPartial = {};
 }
 
 bool GameSocket::isConnected() {
@@ -90,103 +104,220 @@ bool GameSocket::isConnected() {
 }
 
 Result<std::shared_ptr<Packet>> GameSocket::recvPacketTCP() {
-    ByteBuffer bb;
-    bb.grow(4);
+    // the socket is blocking, so each receive waits for more data
+    while (true) {
+        GLOBED_UNWRAP_INTO(this->recvPacketTCPPartial(), auto packet);
 
-    // receive the packet length
-    GLOBED_UNWRAP(tcpSocket.recvExact(reinterpret_cast<char*>(bb.data().data()), 4));
+        if (packet) {
+            return Ok(std::move(packet.value()));
+        }
+    }
+}
 
-    auto packetSize = bb.readU32().unwrapOr(0); // must always be 4 bytes so cant error
-    globed::netLog("GameSocket::recvPacketTCP received message length, {} bytes", packetSize);
+Result<std::optional<std::shared_ptr<Packet>>> GameSocket::recvPacketTCPPartial() {
+    auto& partial = tcpPartial;
+
+    // a single receive never blocks once the socket is readable, so each step receives once,
+    // and only goes on if there is still more data to read
+    while (true) {
+        if (partial.lengthReceived < sizeof(uint32_t)) {
+            // receive the packet length
+            char* dest = reinterpret_cast<char*>(partial.lengthBytes) + partial.lengthReceived;
+            GLOBED_UNWRAP_INTO(this->recvTcpChunk(dest, sizeof(uint32_t) - partial.lengthReceived), size_t received);
+            partial.lengthReceived += received;
+
+            if (partial.lengthReceived == sizeof(uint32_t)) {
+                uint32_t packetSize;
+                std::memcpy(&packetSize, partial.lengthBytes, sizeof(uint32_t));
+                packetSize = maybeByteswap(packetSize);
+
+                globed::netLog("GameSocket::recvPacketTCPPartial received message length, {} bytes", packetSize);
+
+                if (packetSize >= DATA_BUF_SIZE) {
+                    partial = {};
+                    return Err("packet is too big, rejecting");
+                }
+
+                // receive straight into a pooled buffer, so the data never has to be copied
+                partial.length = packetSize;
+                partial.buffer = this->acquireBuffer(packetSize);
+                partial.received = 0;
+            }
+        } else {
+            char* dest = reinterpret_cast<char*>(partial.buffer->data.data()) + partial.received;
+            GLOBED_UNWRAP_INTO(this->recvTcpChunk(dest, partial.length - partial.received), size_t received);
+            partial.received += received;
+        }
 
-    GLOBED_REQUIRE_SAFE(packetSize < DATA_BUF_SIZE, "packet is too big, rejecting")
+        if (partial.lengthReceived == sizeof(uint32_t) && partial.received == partial.length) {
+            globed::netLog("GameSocket::recvPacketTCPPartial received entirety of the message, decoding!");
 
-    GLOBED_UNWRAP(tcpSocket.recvExact(reinterpret_cast<char*>(dataBuffer), packetSize));
+            auto pbuf = std::move(partial.buffer);
+            partial = {};
 
-    globed::netLog("GameSocket::recvPacketTCP received entirety of the message, decoding!");
+            GLOBED_UNWRAP_INTO(this->decodePooledPacket(std::move(pbuf), 0, true), auto packet);
+            return Ok(std::move(packet));
+        }
 
-    ByteBuffer buf(dataBuffer, packetSize);
+        GLOBED_UNWRAP_INTO(tcpSocket.poll(0), bool readable);
+        if (!readable) {
+            globed::netLog("GameSocket::recvPacketTCPPartial waiting for the rest of the message ({} / {} bytes)", partial.received, partial.length);
+            return Ok(std::nullopt);
+        }
+    }
+}
+
+Result<size_t> GameSocket::recvTcpChunk(char* dest, size_t size) {
+    GLOBED_REQUIRE_SAFE(tcpSocket.connected, "attempting to receive from a disconnected tcp socket")
 
-    auto retval = this->decodePacket(buf);
-    if (retval) {
-        auto& pkt = retval.unwrap();
-        PacketLogger::get().record(pkt->getPacketId(), pkt->getEncrypted(), false, buf.size());
+    int result = tcpSocket.receive(dest, static_cast<int>(size)).result;
+
+    // the stream can't be resumed after either of these
+    if (result < 0) {
+        tcpPartial = {};
+        return Err(fmt::format("tcp recv failed ({}): {}", result, util::net::lastErrorString()));
+    } else if (result == 0) {
+        tcpPartial = {};
+        return Err("connection was closed by the server");
     }
 
-    return retval;
+    return Ok(static_cast<size_t>(result));
 }
 
 Result<std::optional<ReceivedPacket>> GameSocket::recvPacketUDP(bool skipMarker) {
     auto recvResult = udpSocket.receive(reinterpret_cast<char*>(dataBuffer), DATA_BUF_SIZE);
 
-    ReceivedPacket out;
-    out.fromConnected = recvResult.fromServer;
-
     if (recvResult.result < 0) {
-        auto code = util::net::lastErrorCode();
+        return Err(this->udpRecvError(recvResult.result));
+    }
 
-        // So ios likes to be quirky, and if you close gd and leave it in the background for some time,
-        // after coming back it will kill the udp socket and return ENOTCONN.
-        // we don't have much choice but to just recreate the socket here.
-        // i made this GLOBED_IS_UNIX because in theory this may happen on android at some point too (?) although i have never seen it
-#ifdef GLOBED_IS_UNIX
-        if (code == ENOTCONN) {
-            globed::netLog("GameSocket::recvPacketUDP - recreating UDP socket that was killed by the OS..");
-            this->disconnect();
-            udpSocket = UdpSocket{};
-            return Err("socket was destroyed");
+    globed::netLog("GameSocket::recvPacketUDP received {} bytes (fromConnected = {})", (size_t)recvResult.result, recvResult.fromServer);
+
+    return this->processDatagram(dataBuffer, recvResult.result, recvResult.fromServer, skipMarker);
+}
+
+Result<> GameSocket::recvPacketsUDP(std::vector<ReceivedPacket>& out) {
+    // split the scratch buffer into slots, one for each datagram in a batch
+    UdpDatagram datagrams[UDP_BATCH_COUNT];
+
+    for (size_t i = 0; i < UDP_BATCH_COUNT; i++) {
+        datagrams[i].data = reinterpret_cast<char*>(dataBuffer + i * UDP_BATCH_SLOT_SIZE);
+        datagrams[i].size = UDP_BATCH_SLOT_SIZE;
+    }
+
+    // keep draining until nothing is queued, but limit the amount of rounds so that TCP doesn't get starved
+    for (size_t round = 0; round < UDP_MAX_DRAIN_ROUNDS; round++) {
+        int count = udpSocket.receiveBatch(datagrams, UDP_BATCH_COUNT);
+
+        if (count < 0) {
+            return Err(this->udpRecvError(count));
+        }
+
+        globed::netLog("GameSocket::recvPacketsUDP received {} datagrams (round {})", count, round);
+
+        for (int i = 0; i < count; i++) {
+            auto& dgram = datagrams[i];
+
+            auto packet = this->processDatagram(reinterpret_cast<byte*>(dgram.data), dgram.result.result, dgram.result.fromServer, false);
+
+            // a bad datagram (corrupted, duplicate, outdated) only loses itself, not the rest of the batch
+            if (!packet) {
+                PacketLogger::get().recordDroppedDatagram();
+                globed::netLog("GameSocket::recvPacketsUDP dropping datagram {} of {}: {}", i, count, packet.unwrapErr());
+                continue;
+            }
+
+            if (packet.unwrap()) {
+                out.push_back(std::move(packet.unwrap().value()));
+            }
         }
-#endif
 
-        globed::netLog("GameSocket::recvPacketUDP fail: code {}", recvResult.result);
-        return Err(fmt::format("udp recv failed ({}): {}", recvResult.result, util::net::lastErrorString(code)));
+        if ((size_t) count < UDP_BATCH_COUNT) {
+            break;
+        }
     }
 
-    globed::netLog("GameSocket::recvPacketUDP received {} bytes (fromConnected = {})", (size_t)recvResult.result, out.fromConnected);
+    return Ok();
+}
 
-    ByteBuffer buf(dataBuffer, (size_t)recvResult.result);
+Result<std::optional<ReceivedPacket>> GameSocket::processDatagram(byte* data, size_t received, bool fromConnected, bool skipMarker) {
+    ReceivedPacket out;
+    out.fromConnected = fromConnected;
 
     // if not from active server, dont't read the marker
-    if (!out.fromConnected || skipMarker) {
-        GLOBED_UNWRAP_INTO(this->decodePacket(buf), out.packet);
+    size_t offset = 0;
 
-        if (out.packet) {
-            PacketLogger::get().record(out.packet->getPacketId(), out.packet->getEncrypted(), false, buf.size());
+    if (out.fromConnected && !skipMarker) {
+        // check if it is a full packet or a frame,
+        if (received == 0) {
+            return Err(fmt::to_string(ByteBuffer::DecodeError::NotEnoughData));
         }
 
-        return Ok(std::move(out));
-    }
+        auto marker = data[0];
 
-    // check if it is a full packet or a frame,
-    auto marker = buf.readU8();
+        globed::netLog("GameSocket::processDatagram marker = {:X}", (int) marker);
 
-    if (marker.isErr()) {
-        return Err(fmt::to_string(marker.unwrapErr()));
-    }
+        if (marker == MARKER_UDP_FRAME) {
+            ByteReader reader(data + 1, received - 1);
 
-    globed::netLog("GameSocket::recvPacketUDP marker = {:X}", (int) *marker);
+            GLOBED_UNWRAP_INTO(udpBuffer.pushFrameFromBuffer(reader), auto pbuf);
+            if (!pbuf) {
+                return Ok(std::nullopt);
+            }
 
-    if (*marker == MARKER_UDP_PACKET) {
-        GLOBED_UNWRAP_INTO(this->decodePacket(buf), out.packet);
-    } else if (*marker == MARKER_UDP_FRAME) {
-        GLOBED_UNWRAP_INTO(udpBuffer.pushFrameFromBuffer(buf), auto maybeBuf);
-        if (!maybeBuf.empty()) {
-            ByteBuffer toDecode(std::move(maybeBuf));
-            GLOBED_UNWRAP_INTO(this->decodePacket(toDecode), out.packet);
-        } else {
-            return Ok(std::nullopt);
+            GLOBED_UNWRAP_INTO(this->decodePooledPacket(std::move(pbuf), 0, false), out.packet);
+
+            return Ok(std::move(out));
+        } else if (marker != MARKER_UDP_PACKET) {
+            return Err("invalid marker at the start of a udp packet");
         }
-    } else {
-        return Err("invalid marker at the start of a udp packet");
+
+        offset = 1;
     }
 
-    if (out.packet) {
-        PacketLogger::get().record(out.packet->getPacketId(), out.packet->getEncrypted(), false, buf.size());
+    // decode straight from the receive buffer, without copying the datagram anywhere
+    GLOBED_UNWRAP_INTO(this->openPacket(std::span(data + offset, received - offset), false), auto opened);
+
+    size_t borrowedReads = 0;
+    GLOBED_UNWRAP_INTO(this->decodeMessage(opened, borrowedReads), out.packet);
+
+    // the receive buffer is reused for the next datagram, so a packet that borrowed from it is decoded again
+    // from a pooled copy of the already decrypted message, which it can then keep alive.
+    if (borrowedReads > 0) {
+        auto pbuf = this->acquireBuffer(opened.message.size());
+        std::memcpy(pbuf->data.data(), opened.message.data(), opened.message.size());
+
+        GLOBED_UNWRAP_INTO(this->decodeMessage(OpenedPacket { opened.header, pbuf->data }, borrowedReads), out.packet);
+
+        PacketLogger::get().recordAllocationsAvoided(borrowedReads);
+        out.packet->setBackingBuffer(std::move(pbuf));
     }
 
+    PacketLogger::get().record(out.packet->getPacketId(), out.packet->getEncrypted(), false, received);
+
     return Ok(std::move(out));
 }
 
+std::string GameSocket::udpRecvError(int result) {
+    auto code = util::net::lastErrorCode();
+
+    // So ios likes to be quirky, and if you close gd and leave it in the background for some time,
+    // after coming back it will kill the udp socket and return ENOTCONN.
+    // we don't have much choice but to just recreate the socket here.
+    // i made this GLOBED_IS_UNIX because in theory this may happen on android at some point too (?) although i have never seen it
+#ifdef GLOBED_IS_UNIX
+    if (code == ENOTCONN) {
+        globed::netLog("GameSocket::udpRecvError - recreating UDP socket that was killed by the OS..");
+        this->disconnect();
+        udpSocket = UdpSocket{};
+        return "socket was destroyed";
+    }
+#endif
+
+    globed::netLog("GameSocket udp receive fail: code {}", result);
+    return fmt::format("udp recv failed ({}): {}", result, util::net::lastErrorString(code));
+}
+
 Result<ReceivedPacket> GameSocket::recvPacket(int timeoutMs) {
     // negative value means poll indefinitely until either tcp or udp receives data
     GLOBED_UNWRAP_INTO(this->poll(timeoutMs), auto pollResult);
@@ -270,6 +401,74 @@ Result<ReceivedPacket> GameSocket::recvPacket(int timeoutMs) {
     }
 }
 
+Result<> GameSocket::recvPackets(int timeoutMs, std::vector<ReceivedPacket>& out) {
+    GLOBED_UNWRAP_INTO(this->poll(timeoutMs), auto pollResult);
+
+    if (pollResult == PollResult::None) {
+        return Err("timed out");
+    }
+
+    globed::netLog("GameSocket::recvPackets successful poll on {}, trying to receive", (int) pollResult);
+
+    return this->recvReadyPackets(pollResult, out);
+}
+
+Result<> GameSocket::recvReadyPackets(PollResult ready, std::vector<ReceivedPacket>& out) {
+    auto pollResult = ready;
+
+    if (pollResult == PollResult::None) {
+        return Ok();
+    }
+
+    if (pollResult != PollResult::Udp) {
+        if (!tcpSocket.connected) {
+            if (pollResult == PollResult::Tcp) {
+                return Err("socket was abruptly disconnected");
+            }
+        } else {
+            auto res = this->recvPacketTCPPartial();
+
+            if (!res) {
+                globed::netLog("GameSocket::recvPackets error receiving TCP packet: {}", res.unwrapErr());
+                return Err(fmt::format("recvPacketTCP failed: {}", res.unwrapErr()));
+            }
+
+            // nullopt if only a part of the packet has arrived, the reactor reports the socket as readable once more does
+            if (auto packet = std::move(res).unwrap()) {
+                out.push_back(ReceivedPacket {
+                    .packet = std::move(packet.value()),
+                    .fromConnected = true
+                });
+            }
+        }
+    }
+
+    if (pollResult != PollResult::Tcp) {
+        if (batchedUdp) {
+            auto res = this->recvPacketsUDP(out);
+
+            if (!res) {
+                globed::netLog("GameSocket::recvPackets error receiving UDP packets: {}", res.unwrapErr());
+                return Err(fmt::format("recvPacketsUDP failed: {}", res.unwrapErr()));
+            }
+        } else {
+            auto res = this->recvPacketUDP();
+
+            if (!res) {
+                globed::netLog("GameSocket::recvPackets error receiving UDP packet: {}", res.unwrapErr());
+                return Err(fmt::format("recvPacketUDP failed: {}", res.unwrapErr()));
+            }
+
+            // nullopt if it was a frame of an incomplete message, the rest will come with the next datagrams
+            if (auto packet = std::move(res).unwrap()) {
+                out.push_back(std::move(packet.value()));
+            }
+        }
+    }
+
+    return Ok();
+}
+
 Result<std::vector<uint8_t>> GameSocket::recvRawTcpData(size_t size, int timeoutMs) {
     GLOBED_UNWRAP_INTO(this->poll(Protocol::Tcp, timeoutMs), auto pollResult);
 
@@ -332,7 +531,10 @@ Result<> GameSocket::sendPacket(std::shared_ptr<Packet> packet, Protocol protoco
         default: useTcp = packet->getUseTcp(); break;
     }
 
-    ByteBuffer buf;
+    auto arena = sendArena.lock();
+    ByteBuffer& buf = *arena;
+    this->resetSendArena(buf);
+
     GLOBED_UNWRAP(this->encodePacket(*packet, buf, useTcp))
 
     if (dumpPackets) {
@@ -343,6 +545,7 @@ Result<> GameSocket::sendPacket(std::shared_ptr<Packet> packet, Protocol protoco
     PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, buf.size());
 #endif
 
+    // length, header, prefix and payload are all laid out contiguously in the arena, so this is a single syscall
     if (useTcp) {
         GLOBED_UNWRAP(tcpSocket.sendAll(reinterpret_cast<const char*>(buf.data().data()), buf.size()));
     } else {
@@ -360,12 +563,70 @@ Result<> GameSocket::sendPacketUDP(std::shared_ptr<Packet> packet) {
     return this->sendPacket(packet, Protocol::Udp);
 }
 
+Result<> GameSocket::sendPacketsUDP(std::vector<std::shared_ptr<Packet>>& packets) {
+    if (forceUseTcp || packets.size() == 1) {
+        for (auto& packet : packets) {
+            GLOBED_UNWRAP(this->sendPacket(packet));
+        }
+
+        return Ok();
+    }
+
+    GLOBED_REQUIRE_SAFE(this->isConnected(), "attempting to send a packet while disconnected")
+
+    globed::netLog("GameSocket::sendPacketsUDP(count={})", packets.size());
+
+    // encode everything into one buffer, then point the datagrams into it
+    auto arena = sendArena.lock();
+    ByteBuffer& buf = *arena;
+    this->resetSendArena(buf);
+
+    // reserve for all packets at once, reserving for each one separately in `encodePacket` would reallocate every time
+    size_t totalSize = 0;
+    for (auto& packet : packets) {
+        totalSize += this->encodedPacketSize(*packet, false);
+    }
+
+    buf.reserve(totalSize);
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.reserve(packets.size());
+
+    for (auto& packet : packets) {
+        size_t start = buf.size();
+
+        GLOBED_UNWRAP(this->encodePacket(*packet, buf, false))
+        ranges.emplace_back(start, buf.size() - start);
+
+#ifdef GLOBED_DEBUG_PACKETS
+        PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), true, ranges.back().second);
+#endif
+    }
+
+    std::vector<UdpDatagram> datagrams;
+    datagrams.reserve(ranges.size());
+
+    for (auto& [start, size] : ranges) {
+        datagrams.push_back(UdpDatagram {
+            .data = reinterpret_cast<char*>(buf.data().data() + start),
+            .size = static_cast<int>(size),
+        });
+    }
+
+    GLOBED_UNWRAP(udpSocket.sendBatch(datagrams.data(), datagrams.size()));
+
+    return Ok();
+}
+
 Result<> GameSocket::sendPacketTo(std::shared_ptr<Packet> packet, const NetworkAddress& address) {
     globed::netLog("GameSocket::sendPacketTo(packet={{id={}, encrypted={}}}, address={})", packet->getPacketId(), packet->getEncrypted(), address.toString());
 
     GLOBED_REQUIRE_SAFE(!packet->getUseTcp(), "cannot send a TCP packet to a UDP connection")
 
-    ByteBuffer buf;
+    auto arena = sendArena.lock();
+    ByteBuffer& buf = *arena;
+    this->resetSendArena(buf);
+
     GLOBED_UNWRAP(this->encodePacket(*packet, buf, false))
 
     if (dumpPackets) {
@@ -386,6 +647,23 @@ Result<> GameSocket::sendPacketTo(std::shared_ptr<Packet> packet, const NetworkA
     return Ok();
 }
 
+Result<size_t> GameSocket::encodeWithoutSending(Packet& packet, bool tcp, ByteBuffer* buffer) {
+    if (buffer) {
+        size_t startPos = buffer->size();
+        GLOBED_UNWRAP(this->encodePacket(packet, *buffer, tcp))
+
+        return Ok(buffer->size() - startPos);
+    }
+
+    auto arena = sendArena.lock();
+    ByteBuffer& buf = *arena;
+    this->resetSendArena(buf);
+
+    GLOBED_UNWRAP(this->encodePacket(packet, buf, tcp))
+
+    return Ok(buf.size());
+}
+
 Result<> GameSocket::sendRecoveryData(int accountId, uint32_t secretKey) {
     globed::netLog("GameSocket::sendRecoveryData(accountId={}, secretKey={})", accountId, secretKey);
 
@@ -401,9 +679,13 @@ void GameSocket::cleanupBox() {
     cryptoBox = std::unique_ptr<CryptoBox>(nullptr);
 }
 
-void GameSocket::createBox() {
+void GameSocket::createBox(const byte* peerKey) {
     globed::netLog("GameSocket::createBox");
     cryptoBox = std::make_unique<CryptoBox>();
+
+    if (peerKey) {
+        cryptoBox->setPeerKey(peerKey);
+    }
 }
 
 void GameSocket::togglePacketLogging(bool state) {
@@ -414,6 +696,18 @@ void GameSocket::toggleForceTcp(bool enabled) {
     forceUseTcp = enabled;
 }
 
+void GameSocket::toggleBatchedUdp(bool enabled) {
+    batchedUdp = enabled;
+}
+
+bool GameSocket::isBatchedUdp() {
+    return batchedUdp;
+}
+
+void GameSocket::setProtocol(uint16_t protocol) {
+    this->protocol = protocol;
+}
+
 Result<PollResult> GameSocket::poll(int timeoutMs) {
     globed::netLog("GameSocket::poll(timeoutMs={})", timeoutMs);
 
@@ -494,6 +788,9 @@ Result<> GameSocket::encodePacket(Packet& packet, ByteBuffer& buffer, bool tcp)
         .encrypted = packet.getEncrypted(),
     };
 
+    // reserve space for the entire packet upfront, so encoding it never has to reallocate the buffer
+    buffer.reserve(this->encodedPacketSize(packet, tcp));
+
     // reserve space for packet length when using TCP
     size_t startPos = buffer.getPosition();
 
@@ -502,22 +799,29 @@ Result<> GameSocket::encodePacket(Packet& packet, ByteBuffer& buffer, bool tcp)
     }
 
     buffer.writeValue<PacketHeader>(header);
-    packet.encode(buffer);
 
-    globed::netLog("GameSocket::encodePacket: encoding packet: id={}, encrypted={}, totalsize={} (pre-encryption)", header.id, header.encrypted, buffer.size());
+    size_t prefixPos = buffer.getPosition();
 
     if (packet.getEncrypted()) {
         GLOBED_REQUIRE_SAFE(cryptoBox.get() != nullptr, "attempted to encrypt a packet when no cryptobox is initialized")
 
-        // grow the vector by CryptoBox::PREFIX_LEN extra bytes to do in-place encryption
-        buffer.grow(CryptoBox::PREFIX_LEN);
-        uint32_t headerSize = PacketHeader::SIZE;
-        if (tcp) {
-            headerSize += sizeof(uint32_t);
-        }
+        // reserve space for the nonce and the mac, the payload is then encoded right where it will be encrypted
+        buffer.grow(cryptoBox->messagePrefixLength(tcp));
+        buffer.setPosition(prefixPos + cryptoBox->messagePrefixLength(tcp));
+    }
 
-        auto rawSize = buffer.size() - headerSize - startPos - CryptoBox::PREFIX_LEN;
-        cryptoBox->encryptInPlace(buffer.data().data() + startPos + headerSize, rawSize);
+    buffer.setProtocol(protocol);
+    buffer.setPositionOrigin(cocos2d::CCPoint{});
+    packet.encode(buffer);
+
+    globed::netLog("GameSocket::encodePacket: encoding packet: id={}, encrypted={}, totalsize={}", header.id, header.encrypted, buffer.size() - startPos);
+
+    if (packet.getEncrypted()) {
+        size_t prefixLength = cryptoBox->messagePrefixLength(tcp);
+        byte* prefix = buffer.data().data() + prefixPos;
+        size_t rawSize = buffer.size() - prefixPos - prefixLength;
+
+        GLOBED_UNWRAP(cryptoBox->encryptMessage(prefix, prefix + prefixLength, rawSize, tcp));
     }
 
     // write length
@@ -533,50 +837,113 @@ Result<> GameSocket::encodePacket(Packet& packet, ByteBuffer& buffer, bool tcp)
     return Ok();
 }
 
-Result<std::shared_ptr<Packet>> GameSocket::decodePacket(ByteBuffer& buffer) {
+size_t GameSocket::encodedPacketSize(const Packet& packet, bool tcp) {
+    return (tcp ? sizeof(uint32_t) : 0)
+        + PacketHeader::SIZE
+        + (packet.getEncrypted() ? (cryptoBox ? cryptoBox->messagePrefixLength(tcp) : CryptoBox::PREFIX_LEN) : 0)
+        + packet.getEncodedSize();
+}
+
+void GameSocket::resetSendArena(ByteBuffer& arena) {
+    if (arena.data().capacity() > SEND_ARENA_MAX_CAPACITY) {
+        arena = ByteBuffer{};
+    } else {
+        arena.clear();
+    }
+}
+
+Result<GameSocket::OpenedPacket> GameSocket::openPacket(std::span<byte> data, bool tcp) {
+    ByteReader reader(data);
+
     // read header
-    auto header = buffer.readValue<PacketHeader>().unwrap(); // we know that the header must be present by now.
+    auto header = reader.readValue<PacketHeader>().unwrap(); // we know that the header must be present by now.
 
     // packet size without the header
-    size_t messageStart = buffer.getPosition();
-    size_t messageLength = buffer.size() - messageStart;
+    size_t messageStart = reader.getPosition();
+    size_t messageLength = data.size() - messageStart;
+
+    globed::netLog("GameSocket::openPacket: Decoded header: id={}, encrypted={}, length={}", header.id, header.encrypted, messageLength);
+
+    auto message = data.subspan(messageStart, messageLength);
+
+    if (header.encrypted) {
+        GLOBED_REQUIRE_SAFE(cryptoBox.get() != nullptr, "attempted to decrypt a packet when no cryptobox is initialized")
+
+        // the plaintext is left where the ciphertext was, right after the nonce/mac prefix
+        GLOBED_UNWRAP_INTO(cryptoBox->decryptMessage(message.data(), message.size(), tcp), message);
+    }
+
+    if (dumpPackets) {
+        this->dumpPacket(header.id, ByteReader(data.first(messageStart)), false, message);
+    }
 
-    globed::netLog("GameSocket::decodePacket: Decoded header: id={}, encrypted={}, length={}", header.id, header.encrypted, messageLength);
+    return Ok(OpenedPacket {
+        .header = header,
+        .message = message,
+    });
+}
 
+Result<std::shared_ptr<Packet>> GameSocket::decodeMessage(const OpenedPacket& opened, size_t& borrowedReads) {
+    auto& header = opened.header;
     auto packet = matchPacket(header.id);
 
     GLOBED_REQUIRE_SAFE(packet.get() != nullptr, std::string("invalid server-side packet: ") + std::to_string(header.id))
 
     if (packet->getEncrypted() && !header.encrypted) {
-        globed::netLog("(W) GameSocket::decodePacket: warning, mismatched encryption!!");
+        globed::netLog("(W) GameSocket::decodeMessage: warning, mismatched encryption!!");
         GLOBED_REQUIRE_SAFE(false, fmt::format("server sent a cleartext packet when expected an encrypted one ({})", header.id))
     }
 
-    if (header.encrypted) {
-        GLOBED_REQUIRE_SAFE(cryptoBox.get() != nullptr, "attempted to decrypt a packet when no cryptobox is initialized")
-        bytevector& bufvec = buffer.data();
+    ByteReader reader(opened.message);
+    reader.setProtocol(protocol);
+    reader.setBorrowing(true);
+
+    auto result = packet->decode(reader);
+    if (result.isErr()) {
+        auto errmsg = ByteReader::strerror(result.unwrapErr());
+
+        globed::netLog("(W) GameSocket::decodeMessage: failed to decode packet: {}", errmsg);
 
-        GLOBED_UNWRAP_INTO(cryptoBox->decryptInPlace(bufvec.data() + messageStart, messageLength), messageLength);
-        buffer.resize(messageStart + messageLength);
+        return Err(fmt::format("Decoding packet ID {} failed: {}", header.id, errmsg));
     }
 
-    if (dumpPackets) {
-        this->dumpPacket(header.id, buffer, false);
+    borrowedReads = reader.getBorrowedReads();
+
+    return Ok(std::move(packet));
+}
+
+PacketBufferRef GameSocket::acquireBuffer(size_t size) {
+    bool reused;
+    auto pbuf = PacketBufferPool::get().acquire(size, &reused);
+
+    if (reused) {
+        PacketLogger::get().recordAllocationsAvoided(1);
     }
 
-    auto result = packet->decode(buffer);
-    if (result.isErr()) {
-        auto errmsg = ByteBuffer::strerror(result.unwrapErr());
+    return pbuf;
+}
 
-        globed::netLog("(W) GameSocket::decodePacket: failed to decode packet: {}", errmsg);
+Result<std::shared_ptr<Packet>> GameSocket::decodePooledPacket(PacketBufferRef pbuf, size_t offset, bool tcp) {
+    size_t size = pbuf->data.size();
 
-        return Err(fmt::format("Decoding packet ID {} failed: {}", header.id, errmsg));
+    GLOBED_UNWRAP_INTO(this->openPacket(std::span(pbuf->data).subspan(offset), tcp), auto opened);
+
+    size_t borrowedReads = 0;
+    GLOBED_UNWRAP_INTO(this->decodeMessage(opened, borrowedReads), auto packet);
+
+    PacketLogger::get().record(packet->getPacketId(), packet->getEncrypted(), false, size);
+
+    // if the packet borrowed any data, keep the buffer alive until the packet is destroyed.
+    // otherwise it goes back to the pool right away.
+    if (borrowedReads > 0) {
+        PacketLogger::get().recordAllocationsAvoided(borrowedReads);
+        packet->setBackingBuffer(std::move(pbuf));
     }
 
     return Ok(std::move(packet));
 }
 
-void GameSocket::dumpPacket(packetid_t id, ByteBuffer& buffer, bool sending) {
+void GameSocket::dumpPacket(packetid_t id, const ByteReader& buffer, bool sending, std::span<const byte> message) {
     log::debug("{} packet {}", sending ? "Sending" : "Receiving", id);
 
     auto folder = Mod::get()->getSaveDir() / "packets";
@@ -590,6 +957,7 @@ void GameSocket::dumpPacket(packetid_t id, ByteBuffer& buffer, bool sending) {
 
     std::ofstream fs(filepath, std::ios::binary);
 
-    const auto& vec = buffer.data();
-    fs.write(reinterpret_cast<const char*>(vec.data()), vec.size());
+    auto data = buffer.span();
+    fs.write(reinterpret_cast<const char*>(data.data()), data.size());
+    fs.write(reinterpret_cast<const char*>(message.data()), message.size());
 }
\ No newline at end of file
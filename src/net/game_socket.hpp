@@ -6,6 +6,7 @@
 #include "udp_frame_buffer.hpp"
 
 #include <data/packets/packet.hpp>
+#include <data/bytebuffer.hpp>
 #include <crypto/box.hpp>
 
 class GLOBED_DLL GameSocket {
@@ -33,18 +34,39 @@ public:
         Unspecified, Tcp, Udp
     };
 
-    // Try to receive a packet on the TCP socket
+    // Try to receive a packet on the TCP socket, blocks until the whole packet is received
     Result<std::shared_ptr<Packet>> recvPacketTCP();
 
+    // Receive whatever part of the next TCP packet can be read without blocking. Must only be called once the socket is readable.
+    // Returns the packet once all of it has been received, nullopt if the rest hasn't arrived yet.
+    Result<std::optional<std::shared_ptr<Packet>>> recvPacketTCPPartial();
+
     // Try to receive a packet on the UDP socket
     Result<std::optional<ReceivedPacket>> recvPacketUDP(bool skipMarker = false);
 
+    // Receive every queued UDP datagram in batches and push the resulting packets to `out`.
+    // Datagrams that fail to decode are skipped and counted, only socket errors are returned.
+    Result<> recvPacketsUDP(std::vector<ReceivedPacket>& out);
+
     // Try to receive a packet
     Result<ReceivedPacket> recvPacket();
 
     // Try to receive a packet, returns "timed out" if timeout is reached.
     Result<ReceivedPacket> recvPacket(int timeoutMs);
 
+    // Like `recvPacket`, but drains all queued UDP datagrams at once. Returns "timed out" if timeout is reached.
+    // Packets decoded before an error occurs are still pushed to `out`.
+    Result<> recvPackets(int timeoutMs, std::vector<ReceivedPacket>& out);
+
+    enum class PollResult {
+        None, Tcp, Udp, Both
+    };
+
+    // Receive from the sockets that are already known to be readable, without polling them again.
+    // TCP yields at most one packet and never waits for the rest of one, UDP drains all queued datagrams if batching is enabled, otherwise reads one.
+    // Packets decoded before an error occurs are still pushed to `out`.
+    Result<> recvReadyPackets(PollResult ready, std::vector<ReceivedPacket>& out);
+
     // Receive raw bytes from a TCP socket. if size is not specified, reads 4 bytes from the socket and uses that as the length.
     // Blocks until either an error occurs, the timeout expires or the data is ready.
     Result<std::vector<uint8_t>> recvRawTcpData(size_t size, int timeoutMs);
@@ -61,20 +83,29 @@ public:
     // Like sendPacket, but forcefully sends via the UDP connection
     Result<> sendPacketUDP(std::shared_ptr<Packet> packet);
 
+    // Send multiple UDP packets with as few syscalls as possible. Falls back to `sendPacket` when TCP is forced.
+    Result<> sendPacketsUDP(std::vector<std::shared_ptr<Packet>>& packets);
+
     // Send a UDP packet to a specific address
     Result<> sendPacketTo(std::shared_ptr<Packet> packet, const NetworkAddress& address);
 
+    // Encode a packet exactly like `sendPacket` would, without sending it. The packet is written to `buffer` if given,
+    // otherwise to the send arena, which is reused the same way as when sending. Returns the amount of encoded bytes.
+    Result<size_t> encodeWithoutSending(Packet& packet, bool tcp, ByteBuffer* buffer = nullptr);
+
     Result<> sendRecoveryData(int accountId, uint32_t secretKey);
 
     void cleanupBox();
-    void createBox();
+    // if `peerKey` is given, packets can be encrypted right away, without the handshake
+    void createBox(const util::data::byte* peerKey = nullptr);
 
     void togglePacketLogging(bool enabled);
     void toggleForceTcp(bool enabled);
+    void toggleBatchedUdp(bool enabled);
+    bool isBatchedUdp();
 
-    enum class PollResult {
-        None, Tcp, Udp, Both
-    };
+    // Set the negotiated protocol version, packets are then encoded and decoded in the wire format of that version
+    void setProtocol(uint16_t protocol);
 
     Result<PollResult> poll(int timeoutMs);
 
@@ -83,21 +114,72 @@ public:
 private:
     friend class NetworkManager;
 
+    // the send arena is freed instead of being reused if it grows bigger than this
+    static constexpr size_t SEND_ARENA_MAX_CAPACITY = 1 << 18;
+
     TcpSocket tcpSocket;
     UdpSocket udpSocket;
     UdpFrameBuffer udpBuffer;
 
+    // the TCP packet that is being received, possibly over multiple reactor iterations
+    struct PartialTcpPacket {
+        util::data::byte lengthBytes[sizeof(uint32_t)];
+        size_t lengthReceived = 0;
+        uint32_t length = 0;
+        PacketBufferRef buffer;
+        size_t received = 0;
+    };
+
+    PartialTcpPacket tcpPartial;
+
     std::unique_ptr<CryptoBox> cryptoBox;
     util::data::byte* dataBuffer;
+    // reused for encoding outgoing packets, so sending does not allocate once it has grown big enough
+    asp::Mutex<ByteBuffer> sendArena;
 
     bool dumpPackets = false;
     bool forceUseTcp = false;
+    bool batchedUdp = false;
+    uint16_t protocol = 0;
 
     // Write a packet, packet header, and optionally length if the packet is TCP to the given buffer.
+    // The packet is appended at the current position, which must be at the end of the buffer.
+    // Space for the encryption prefix is reserved before encoding, so the payload is encrypted where it was written.
     Result<> encodePacket(Packet& packet, ByteBuffer& buffer, bool tcp);
 
-    // Decode a packet from a buffer
-    Result<std::shared_ptr<Packet>> decodePacket(ByteBuffer& buffer);
+    // Amount of bytes `encodePacket` will write for the packet, may be a few bytes more than the actual size
+    size_t encodedPacketSize(const Packet& packet, bool tcp);
+
+    // Clear the send arena, releasing its memory if a large packet made it grow too much
+    void resetSendArena(ByteBuffer& arena);
+
+    struct OpenedPacket {
+        PacketHeader header;
+        std::span<const util::data::byte> message;
+    };
+
+    // Read the header of a received packet and decrypt its message in place if needed. `tcp` is the channel it was received on.
+    Result<OpenedPacket> openPacket(std::span<util::data::byte> data, bool tcp);
+
+    // Decode the message of an opened packet where it is. The packet may keep views into the message, `borrowedReads` is set to how many it has.
+    Result<std::shared_ptr<Packet>> decodeMessage(const OpenedPacket& opened, size_t& borrowedReads);
+
+    // Decode a single received UDP datagram in place. Returns nullopt if it was a frame of an incomplete message.
+    Result<std::optional<ReceivedPacket>> processDatagram(util::data::byte* data, size_t length, bool fromConnected, bool skipMarker);
+
+    // Receive up to `size` bytes of the current TCP packet with a single receive, which blocks only if nothing is readable
+    Result<size_t> recvTcpChunk(char* dest, size_t size);
+
+    // Build an error message from a failed UDP receive, recreating the socket if the OS has destroyed it
+    std::string udpRecvError(int result);
+
+    // Get a receive buffer of `size` bytes from the buffer pool
+    PacketBufferRef acquireBuffer(size_t size);
+
+    // Decode a packet from a pooled receive buffer, starting at `offset`. The decoded packet may borrow data from the buffer.
+    Result<std::shared_ptr<Packet>> decodePooledPacket(PacketBufferRef buffer, size_t offset, bool tcp);
 
-    void dumpPacket(packetid_t id, ByteBuffer& buffer, bool sending);
+    // Write a packet to the packet dump folder. `message` is written right after `buffer`, this is used for received packets,
+    // whose decrypted message is not contiguous with the header.
+    void dumpPacket(packetid_t id, const ByteReader& buffer, bool sending, std::span<const util::data::byte> message = {});
 };
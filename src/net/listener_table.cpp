@@ -0,0 +1,83 @@
+#include "listener_table.hpp"
+
+using namespace geode::prelude;
+
+PacketListenerTable::PacketListenerTable() : slotIndex(std::numeric_limits<packetid_t>::max() + 1, 0) {}
+
+bool PacketListenerTable::add(packetid_t id, PacketListener* listener) {
+    auto& index = slotIndex[id];
+    if (index == 0) {
+        slots.emplace_back();
+        index = slots.size();
+    }
+
+    auto& slot = slots[index - 1];
+    this->compactSlot(slot);
+
+    for (auto& l : slot.listeners) {
+        if (l.lock() == listener) {
+            return false;
+        }
+    }
+
+    // insert after all listeners with the same priority, so they run in the order they were added
+    auto it = std::upper_bound(slot.listeners.begin(), slot.listeners.end(), listener->priority, [](int priority, auto& l) {
+        auto r = l.lock();
+        return !r || priority < r->priority;
+    });
+
+    slot.listeners.insert(it, WeakRef(listener));
+
+    return true;
+}
+
+void PacketListenerTable::dispatch(const std::shared_ptr<Packet>& packet) {
+    uint16_t index = slotIndex[packet->getPacketId()];
+    if (index == 0) return;
+
+    // callbacks may add new listeners, which can reallocate both `slots` and the list, so always go through indices
+    for (size_t i = 0; i < slots[index - 1].listeners.size(); i++) {
+        auto l = slots[index - 1].listeners[i].lock();
+
+        if (!l) {
+            slots[index - 1].hasDead = true;
+            anyDead = true;
+            continue;
+        }
+
+        l->invokeCallback(packet);
+
+        if (l->isFinal) {
+            break;
+        }
+    }
+}
+
+void PacketListenerTable::compact() {
+    if (!anyDead) return;
+
+    for (auto& slot : slots) {
+        if (slot.hasDead) {
+            this->compactSlot(slot);
+        }
+    }
+
+    anyDead = false;
+}
+
+size_t PacketListenerTable::listenerCount(packetid_t id) {
+    auto slot = this->getSlot(id);
+    return slot ? slot->listeners.size() : 0;
+}
+
+PacketListenerTable::Slot* PacketListenerTable::getSlot(packetid_t id) {
+    uint16_t index = slotIndex[id];
+    return index == 0 ? nullptr : &slots[index - 1];
+}
+
+void PacketListenerTable::compactSlot(Slot& slot) {
+    // listeners registered by a node that was destroyed are only found when walking the list,
+    // so always check all of them when the list is about to be modified anyway
+    std::erase_if(slot.listeners, [](auto& l) { return !l.valid(); });
+    slot.hasDead = false;
+}
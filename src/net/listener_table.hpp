@@ -0,0 +1,36 @@
+#pragma once
+
+#include "listener.hpp"
+
+// Packet listeners grouped by packet id. Each list is kept sorted by priority as listeners are added,
+// so dispatching a packet is a walk over a single flat list, without sorting or a hash lookup.
+// Listeners that died are skipped during dispatch and removed on the next `compact` or `add` for that id.
+class PacketListenerTable {
+public:
+    PacketListenerTable();
+
+    // Add a listener for the given packet id. Returns false if it is already registered.
+    bool add(packetid_t id, PacketListener* listener);
+
+    // Invoke all live listeners for the id of this packet, lowest priority first, stopping after a final listener.
+    void dispatch(const std::shared_ptr<Packet>& packet);
+
+    // Remove listeners that were found dead during dispatch. Cheap if there are none.
+    void compact();
+
+    size_t listenerCount(packetid_t id);
+
+private:
+    struct Slot {
+        std::vector<WeakRef<PacketListener>> listeners;
+        bool hasDead = false;
+    };
+
+    // packet id -> index into `slots` plus one, zero means no listeners were ever added for the id
+    std::vector<uint16_t> slotIndex;
+    std::vector<Slot> slots;
+    bool anyDead = false;
+
+    Slot* getSlot(packetid_t id);
+    void compactSlot(Slot& slot);
+};
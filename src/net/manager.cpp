@@ -1,8 +1,11 @@
 #include "manager.hpp"
 
 #include "address.hpp"
+#include "clock_sync.hpp"
 #include "listener.hpp"
+#include "listener_table.hpp"
 #include "game_socket.hpp"
+#include "reactor.hpp"
 
 #include <Geode/ui/GeodeUI.hpp>
 #include <asp/sync.hpp>
@@ -26,7 +29,9 @@
 #include <managers/role.hpp>
 #include <managers/motd_cache.hpp>
 #include <util/cocos.hpp>
+#include <util/collections.hpp>
 #include <util/crypto.hpp>
+#include <util/debug.hpp>
 #include <util/format.hpp>
 #include <util/time.hpp>
 #include <util/net.hpp>
@@ -39,6 +44,9 @@ using namespace asp::time;
 using namespace geode::prelude;
 using ConnectionState = NetworkManager::ConnectionState;
 
+// the newest entry is also the version we ask for in the handshake, and servers reject versions they don't know.
+// everything gated on protocol 15 (clock sync, compact icons, counter nonces, voice sequence numbers, delta player data)
+// stays inactive until 15 is added here, once the server implements it.
 static constexpr std::array SUPPORTED_PROTOCOLS = std::to_array<uint16_t>({13, 14});
 static constexpr uint16_t MIN_PROTOCOL_VERSION = SUPPORTED_PROTOCOLS.front();
 static constexpr uint16_t MAX_PROTOCOL_VERSION = SUPPORTED_PROTOCOLS.back();
@@ -80,17 +88,6 @@ static std::string formatListenerKey(packetid_t id) {
     return util::cocos::spr(fmt::format("packet-listener-{}", id));
 }
 
-struct WeakRefDummy {
-    std::shared_ptr<WeakRefController> ctrl;
-};
-
-template <typename T>
-static void* addrFromWeakRef(const WeakRef<T>& ref) {
-    // Do not do this.
-    auto dummy = reinterpret_cast<const WeakRefDummy&>(ref);
-    return dummy.ctrl ? dummy.ctrl->get() : nullptr;
-}
-
 // Packet listener pool. Most of the functions must not be used on a different thread than main.
 class GLOBED_DLL PacketListenerPool : public SingletonNodeBase<PacketListenerPool, true> {
     friend class SingletonNodeBase;
@@ -109,93 +106,228 @@ public:
 
             // clear the queue
             while (auto t = packetQueue.tryPop());
+            (void) this->takeOverflow();
 
             return;
         }
 
-        if (packetQueue.empty()) return;
-
-        // clear any dead listeners
-        this->removeDeadListeners();
+        if (packetQueue.empty() && !hasOverflow.load(std::memory_order_acquire)) return;
 
         while (auto packet_ = packetQueue.tryPop()) {
-            auto& packet = packet_.value();
-            packetid_t id = packet->getPacketId();
+            pending.push_back(std::move(packet_.value()));
+        }
 
-            bool invoked = false;
-            auto& lsm = listeners[id];
+        // overflowed packets are always newer than the ones that were in the ring, so they go last
+        if (hasOverflow.load(std::memory_order_acquire)) {
+            for (auto& packet : this->takeOverflow()) {
+                pending.push_back(std::move(packet));
+            }
+        }
 
-            // reorder them based on priority
-            std::sort(lsm.begin(), lsm.end(), [](auto& l1, auto& l2) -> bool {
-                auto r1 = l1.lock();
-                auto r2 = l2.lock();
+        this->coalescePending();
 
-                if (!r1) return false;
-                if (!r2) return true;
+        for (auto& packet : pending) {
+            listeners.dispatch(packet);
+        }
 
-                return r1->priority < r2->priority;
-            });
+        pending.clear();
 
-            for (auto& listener : lsm) {
-                if (auto l = listener.lock()) {
-                    l->invokeCallback(packet);
+        // clear any listeners that turned out to be dead
+        listeners.compact();
+    }
 
-                    if (l->isFinal) {
-                        break;
-                    }
-                }
-            }
+    void registerListener(packetid_t id, PacketListener* listener) {
+        TRACE("Registering listener {} (id {}) for {}", listener, id, listener->owner);
+
+        if (!listeners.add(id, listener)) {
+            log::warn("duped listener ({}, id {}, owner {}), not adding again", listener, id, listener->owner);
         }
     }
 
-    void removeDeadListeners() {
-        for (auto& [id, listeners] : listeners) {
-            for (int i = listeners.size() - 1; i >= 0; i--) {
-#ifdef GLOBED_DEBUG
-                auto addr = addrFromWeakRef(listeners[i]);
-#else
-                void* addr = nullptr;
-#endif
+    // Push a packet to the queue. Must only be called from the network thread.
+    void pushPacket(std::shared_ptr<Packet> packet) {
+        this->enqueue(std::move(packet));
+        this->recordQueueDepth();
+    }
 
-                if (!listeners[i].valid()) {
-                    TRACE("Unregistering listener {} (id {})", addr, id);
-                    listeners.erase(listeners.begin() + i);
-                }
-            }
+    // Push multiple packets to the queue, leaves the vector empty. Must only be called from the network thread.
+    void pushPackets(std::vector<std::shared_ptr<Packet>>& packets) {
+        for (auto& packet : packets) {
+            this->enqueue(std::move(packet));
         }
+
+        packets.clear();
+        this->recordQueueDepth();
     }
 
-    void registerListener(packetid_t id, PacketListener* listener) {
-        TRACE("Registering listener {} (id {}) for {}", listener, id, listener->owner);
+private:
+    static constexpr size_t QUEUE_CAPACITY = 512;
+    // every snapshot within the playout delay of the interpolator is worth dispatching on its own, even if several arrive
+    // in one frame. its delay is at most 0.4 seconds, this is that much level data at 60 tps
+    static constexpr size_t MAX_UNCOALESCED_LEVEL_DATA = 24;
+    // how much level data may pile up in the overflow before it is coalesced down to `MAX_UNCOALESCED_LEVEL_DATA`,
+    // so the network thread only walks the overflow once every few dozen packets
+    static constexpr size_t OVERFLOW_COALESCE_THRESHOLD = MAX_UNCOALESCED_LEVEL_DATA * 4;
+
+    // Packets that did not fit in the ring. Once anything is in here, new packets are appended here too
+    // to keep the order, until the main thread takes all of them.
+    struct Overflow {
+        std::vector<std::shared_ptr<Packet>> packets;
+        // how many of `packets` are level data
+        size_t levelData = 0;
+    };
+
+    PacketListenerTable listeners;
+
+    // network thread -> main thread
+    util::collections::SpscRing<std::shared_ptr<Packet>, QUEUE_CAPACITY> packetQueue;
+
+    asp::Mutex<Overflow> overflow;
+    std::atomic_bool hasOverflow = false;
+
+    // packets taken out of the queue that are about to be dispatched, only touched by the main thread
+    std::vector<std::shared_ptr<Packet>> pending;
+
+    void enqueue(std::shared_ptr<Packet>&& packet) {
+        if (!hasOverflow.load(std::memory_order_acquire) && packetQueue.tryPush(packet)) {
+            return;
+        }
+
+        auto ovf = overflow.lock();
+
+        if (packet->getPacketId() == LevelDataPacket::PACKET_ID) {
+            ovf->levelData++;
+        }
+
+        ovf->packets.push_back(std::move(packet));
+        hasOverflow.store(true, std::memory_order_release);
+
+        // the main thread is not keeping up, don't let level data it can never play out pile up
+        if (ovf->levelData >= OVERFLOW_COALESCE_THRESHOLD) {
+            size_t coalesced = coalesceOldLevelData(ovf->packets);
+            std::erase_if(ovf->packets, [](auto& p) { return !p; });
+            ovf->levelData -= coalesced;
+
+#ifdef GLOBED_DEBUG_PACKETS
+            util::debug::PacketLogger::get().recordCoalesced(coalesced);
+#endif
+        }
+    }
+
+    std::vector<std::shared_ptr<Packet>> takeOverflow() {
+        auto ovf = overflow.lock();
+
+        auto out = std::move(ovf->packets);
+        ovf->packets.clear();
+        ovf->levelData = 0;
+        hasOverflow.store(false, std::memory_order_release);
+
+        return out;
+    }
+
+    // If more level data packets were received since the last frame than the interpolator could ever play out
+    // (after a hitch), merge the older ones, so that those players are not updated many times for nothing.
+    void coalescePending() {
+        size_t coalesced = coalesceOldLevelData(pending);
+        if (coalesced == 0) return;
+
+        std::erase_if(pending, [](auto& p) { return !p; });
+
+#ifdef GLOBED_DEBUG_PACKETS
+        util::debug::PacketLogger::get().recordCoalesced(coalesced);
+#endif
+    }
+
+    // Merge all but the newest `MAX_UNCOALESCED_LEVEL_DATA` level data packets in `packets` into the oldest of those,
+    // and reset the merged ones to nullptr. Returns how many were merged.
+    static size_t coalesceOldLevelData(std::vector<std::shared_ptr<Packet>>& packets) {
+        auto isLevelData = [](const std::shared_ptr<Packet>& p) {
+            return p && p->getPacketId() == LevelDataPacket::PACKET_ID;
+        };
+
+        // find the oldest level data packet that is kept, everything before it goes
+        size_t seen = 0;
+        auto keptIt = packets.rbegin();
+        for (; keptIt != packets.rend(); keptIt++) {
+            if (isLevelData(*keptIt) && ++seen == MAX_UNCOALESCED_LEVEL_DATA) break;
+        }
+
+        if (keptIt == packets.rend()) return 0;
 
-        auto& ls = listeners[id];
+        auto& kept = static_cast<LevelDataPacket&>(**keptIt);
 
-        this->removeDeadListeners();
+        std::unordered_map<int, PlayerData*> keptPlayers;
+        keptPlayers.reserve(kept.players.size());
 
-        // verify it's not a duplicate
-        bool duped = false;
-        for (auto& l : ls) {
-            if (l.lock() == listener) {
-                duped = true;
-                break;
+        for (auto& player : kept.players) {
+            keptPlayers.emplace(player.accountId, &player.data);
+        }
+
+        size_t coalesced = 0;
+
+        // go from newest to oldest, so that the most recent state is merged first and never gets overwritten
+        for (auto it = std::next(keptIt); it != packets.rend(); it++) {
+            if (!isLevelData(*it)) continue;
+
+            // only the first one merged directly precedes `kept`
+            coalesceLevelData(static_cast<LevelDataPacket&>(**it), kept, keptPlayers, coalesced == 0);
+            it->reset();
+            coalesced++;
+        }
+
+        return coalesced;
+    }
+
+    // Merge `older` into `newer`, so that skipping `older` does not lose any state it would have applied.
+    // `newerPlayers` maps the account IDs in `newer` to their data, `adjacent` is whether `older` directly precedes `newer`.
+    // Every level data packet contains all players on the level, so players missing from `newer` have left and are not carried over.
+    static void coalesceLevelData(LevelDataPacket& older, LevelDataPacket& newer, const std::unordered_map<int, PlayerData*>& newerPlayers, bool adjacent) {
+        if (!newerPlayers.empty()) {
+            for (auto& player : older.players) {
+                auto it = newerPlayers.find(player.accountId);
+                if (it == newerPlayers.end()) continue;
+
+                coalescePlayerData(player.data, *it->second, adjacent);
             }
         }
 
-        if (!duped) {
-            ls.push_back(WeakRef(listener));
-        } else {
-            log::warn("duped listener ({}, id {}, owner {}), not adding again", listener, id, listener->owner);
+        if (older.customItems) {
+            if (!newer.customItems) {
+                newer.customItems = std::move(older.customItems);
+            } else {
+                // newer values win, `insert` does not overwrite existing keys
+                newer.customItems->insert(older.customItems->begin(), older.customItems->end());
+            }
         }
     }
 
-    // Push a packet to the queue. Thread safe.
-    void pushPacket(std::shared_ptr<Packet> packet) {
-        packetQueue.push(std::move(packet));
+    // Carry over one-shot events from `older`. The death counter itself is cumulative, so the newest value already accounts
+    // for any deaths that happened in between and the interpolator will still see it change.
+    // A spider teleport is only carried over from the directly preceding packet, an older one has already finished
+    // by the time `newer` is played and would be replayed from a position the player has left.
+    static void coalescePlayerData(const PlayerData& older, PlayerData& newer, bool adjacent) {
+        auto coalesceSpecific = [adjacent](const SpecificIconData& older, SpecificIconData& newer) {
+            newer.didJustJump = newer.didJustJump || older.didJustJump;
+
+            if (adjacent && !newer.spiderTeleportData) {
+                newer.spiderTeleportData = older.spiderTeleportData;
+            }
+        };
+
+        coalesceSpecific(older.player1, newer.player1);
+        coalesceSpecific(older.player2, newer.player2);
     }
 
-private:
-    std::unordered_map<packetid_t, std::vector<WeakRef<PacketListener>>> listeners;
-    asp::Channel<std::shared_ptr<Packet>> packetQueue;
+    void recordQueueDepth() {
+#ifdef GLOBED_DEBUG_PACKETS
+        size_t depth = packetQueue.size();
+        if (hasOverflow.load(std::memory_order_acquire)) {
+            depth += overflow.lock()->packets.size();
+        }
+
+        util::debug::PacketLogger::get().recordQueueDepth(depth);
+#endif
+    }
 };
 
 class GLOBED_DLL NetworkManager::Impl {
@@ -208,6 +340,7 @@ protected:
     struct TaskPingServers {};
     struct TaskSendPacket {
         std::shared_ptr<Packet> packet;
+        Instant queuedAt;
     };
     struct TaskPingActive {};
 
@@ -232,10 +365,20 @@ protected:
     AtomicConnectionState state;
     AbortData requestedAbort;
     GameSocket socket;
-    asp::Thread<NetworkManager::Impl*> threadRecv, threadMain;
+    asp::Thread<NetworkManager::Impl*> threadMain;
+    // the network thread blocks on this, anything that needs its attention must call `reactor.wake()`
+    NetReactor reactor;
     asp::Channel<Task> taskQueue;
     NetworkAddress relayAddress;
 
+    // only used by the network thread, kept around to avoid reallocating them on every wakeup
+    std::vector<GameSocket::ReceivedPacket> recvBatch;
+    std::vector<std::shared_ptr<Packet>> dispatchBatch;
+
+    // only used by the network thread, udp packets that are waiting to be sent in one batch
+    std::vector<std::shared_ptr<Packet>> sendBatch;
+    std::vector<Instant> sendBatchQueuedAt;
+
     // Note that we intentionally don't use Ref here,
     // as we use the destructor to know if the object owning the listener has been destroyed.
     asp::Mutex<std::unordered_map<packetid_t, GlobalListener>> listeners;
@@ -249,8 +392,12 @@ protected:
     asp::Mutex<asp::time::SystemTime> lastReceivedPacket; // last time we received a packet, accessed in both threads!
     asp::time::SystemTime lastSentKeepalive; // last time we sent a keepalive packet, accessed only in sender thread
     asp::time::SystemTime lastTcpExchange; // last time we sent a tcp packet, accessed only in sender thread
+    asp::time::Instant lastRecoverAttempt; // when the last failed recovery attempt happened, accessed only in sender thread
+    asp::time::Duration recoverDelay; // how long to wait after `lastRecoverAttempt` before trying again
+    asp::Mutex<ClockSync> clockSync; // fed by keepalive responses in the network thread, read by the main thread
 
     AtomicBool suspended;
+    AtomicBool stopping;
     AtomicBool standalone;
     AtomicBool recovering;
     AtomicBool handshakeDone;
@@ -272,16 +419,15 @@ protected:
         // initialize winsock
         util::net::initialize();
 
-        this->setupGlobalListeners();
+        auto reactorResult = reactor.init();
+        GLOBED_REQUIRE(reactorResult.isOk(), fmt::format("failed to initialize the network reactor: {}", reactorResult.unwrapErr()));
 
-        // start up the threads
+        this->setupGlobalListeners();
 
-        threadRecv.setLoopFunction(&NetworkManager::Impl::threadRecvFunc);
-        threadRecv.setStartFunction([] { geode::utils::thread::setName("Network Thread (in)"); });
-        threadRecv.start(this);
+        // start up the thread
 
         threadMain.setLoopFunction(&NetworkManager::Impl::threadMainFunc);
-        threadMain.setStartFunction([] { geode::utils::thread::setName("Network Thread (out)"); });
+        threadMain.setStartFunction([] { geode::utils::thread::setName("Network Thread"); });
         threadMain.start(this);
 
         this->resetConnectionState();
@@ -297,7 +443,8 @@ protected:
 
         TRACE("[NetworkManager] waiting for threads to stop");
 
-        threadRecv.stopAndWait();
+        stopping = true;
+        reactor.wake();
         threadMain.stopAndWait();
 
         TRACE("[NetworkManager] threads stopped, disconnecting");
@@ -327,6 +474,7 @@ protected:
         recovering = false;
         handshakeDone = false;
         recoverAttempt = 0;
+        recoverDelay = Duration{};
         wasFromRecovery = false;
         cancellingRecovery = false;
         relayConnFinished = false;
@@ -336,6 +484,8 @@ protected:
         relayUdpId = 0;
         serverTps = 0;
         serverProtocol = 0;
+        socket.setProtocol(0);
+        clockSync.lock()->reset();
         *lastReceivedPacket.lock() = SystemTime::now();
         lastSentKeepalive = SystemTime::now();
         lastTcpExchange = SystemTime::now();
@@ -363,6 +513,7 @@ protected:
 
         auto& settings = GlobedSettings::get();
         socket.toggleForceTcp(settings.globed.forceTcp);
+        socket.toggleBatchedUdp(settings.globed.batchedUdp);
 
         // if we are already connected, disconnect first
         if (state == ConnectionState::Established) {
@@ -401,6 +552,7 @@ protected:
         flm.maybeLoad();
 
         // actual connection is deferred - the network thread does DNS resolution and TCP connection.
+        reactor.wake();
 
         return Ok();
     }
@@ -432,6 +584,7 @@ protected:
         requestedAbort.requested = true;
         requestedAbort.quiet = quiet;
         requestedAbort.noclear = noclear;
+        reactor.wake();
     }
 
     void disconnectWithMessage(std::string_view message, bool quiet = true) {
@@ -441,6 +594,7 @@ protected:
 
     void cancelReconnect() {
         cancellingRecovery = true;
+        reactor.wake();
     }
 
     void onConnectionError(std::string_view reason) {
@@ -451,16 +605,20 @@ protected:
     void send(std::shared_ptr<Packet> packet) {
         globed::netLog("NetworkManagerImpl::send(packet = {{id = {}}})", packet->getPacketId());
         taskQueue.push(TaskSendPacket {
-            .packet = std::move(packet)
+            .packet = std::move(packet),
+            .queuedAt = Instant::now(),
         });
+        reactor.wake();
     }
 
     void pingServers() {
         taskQueue.push(TaskPingServers {});
+        reactor.wake();
     }
 
     void updateServerPing() {
         taskQueue.push(TaskPingActive {});
+        reactor.wake();
     }
 
     ConnectionState getConnectionState() {
@@ -562,9 +720,15 @@ protected:
             this->onCryptoHandshakeResponse(std::move(packet));
         });
 
-        addInternalListener<KeepaliveResponsePacket>([](auto packet) {
+        addInternalListener<KeepaliveResponsePacket>([this](auto packet) {
             globed::netLog("NetworkManagerImpl received keepalive response");
             GameServerManager::get().finishKeepalive(packet->playerCount);
+
+            // servers that don't synchronize clocks leave the server time empty
+            if (packet->times.serverTime != 0) {
+                auto cs = clockSync.lock();
+                cs->addSample(packet->times.clientTime / 1'000'000.0, packet->times.serverTime, cs->localNow());
+            }
         });
 
         addInternalListener<KeepaliveTCPResponsePacket>([](auto) {});
@@ -724,6 +888,7 @@ protected:
         auto key = packet->data.key;
 
         socket.cryptoBox->setPeerKey(key.data());
+        socket.cryptoBox->setNonceMode(packet->nonceMode.mode);
         auto& am = GlobedAccountManager::get();
         std::string authtoken;
 
@@ -782,6 +947,7 @@ protected:
         serverTps = packet->tps;
         secretKey = packet->secretKey;
         serverProtocol = packet->serverProtocol;
+        socket.setProtocol(packet->serverProtocol);
 
         state = ConnectionState::Established;
 
@@ -916,132 +1082,269 @@ protected:
 
     void suspend() {
         suspended = true;
+        reactor.wake();
     }
 
     void resume() {
         suspended = false;
+        reactor.wake();
     }
 
-    /* worker threads */
+    /* network thread */
 
-    void threadRecvFunc(decltype(threadRecv)::StopToken&) {
-        if (this->suspended || state == ConnectionState::TcpConnecting || requestedAbort) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // A single iteration of the network thread. Everything is driven by the reactor: socket readiness,
+    // queued tasks (which wake it up), and timers, which become the timeout of the next wait.
+    void threadMainFunc(decltype(threadMain)::StopToken&) {
+        // the destructor wakes us up right before stopping the thread, don't go back to waiting
+        if (stopping) {
+            std::this_thread::yield();
             return;
         }
 
-        bool usingRelay = !relayAddress.isEmpty();
+        if (this->suspended) {
+            // wait until `resume` wakes us up, queued tasks are handled afterwards
+            (void) reactor.wait(NetReactor::INVALID_HANDLE, NetReactor::INVALID_HANDLE, -1);
+            return;
+        }
 
-        if (usingRelay && (state == ConnectionState::RelayAuthStage1 || state == ConnectionState::RelayAuthStage2)) {
-            bool stage2 = state == ConnectionState::RelayAuthStage2;
+        this->updateConnection();
 
-            if (!socket.tcpSocket.connected) {
-                // wait..
-                std::this_thread::sleep_for(std::chrono::milliseconds(25));
-                return;
-            }
+        if (this->established()) {
+            this->maybeSendKeepalive();
+            this->maybeSendFriendList();
+        }
 
-            if ((relayStage1Finished && !stage2) || relayConnFinished) {
-                // for some time, even after stage 1/2 are finished, recv thread will keep running
-                // prevent the code below from misfiring when not needed
+        this->processTasks();
 
-                std::this_thread::sleep_for(std::chrono::milliseconds{10});
-                return;
+        this->waitAndReceive(this->nextTimeout());
+    }
+
+    // Block until a socket is readable, the reactor is woken up or the timeout passes, then receive everything that is ready
+    void waitAndReceive(int timeoutMs) {
+        // tcp is only watched once connected, udp is always watched so that ping responses get through
+        bool watchTcp = socket.tcpSocket.connected && state != ConnectionState::TcpConnecting;
+
+        auto tcpHandle = watchTcp ? static_cast<NetReactor::SocketHandle>(socket.tcpSocket.socket_.load()) : NetReactor::INVALID_HANDLE;
+        auto udpHandle = static_cast<NetReactor::SocketHandle>(socket.udpSocket.socket_.load());
+
+        auto result = reactor.wait(tcpHandle, udpHandle, timeoutMs);
+        if (!result) {
+            globed::netLog("NetworkManagerImpl::waitAndReceive reactor wait failed: {}", result.unwrapErr());
+            this->onConnectionError(result.unwrapErr());
+            reactor.resetSockets();
+            return;
+        }
+
+        auto events = result.unwrap();
+        bool tcpReady = events.tcp;
+
+        // during relay authentication, tcp data is the relay's response and not a packet
+        bool usingRelay = !relayAddress.isEmpty();
+        if (usingRelay && (state == ConnectionState::RelayAuthStage1 || state == ConnectionState::RelayAuthStage2)) {
+            if (tcpReady) {
+                this->receiveRelayResponse(state == ConnectionState::RelayAuthStage2);
             }
 
-            globed::netLog("Polling relay TCP data, stage2: {}", stage2);
+            tcpReady = false;
+        }
+
+        using PollResult = GameSocket::PollResult;
+
+        PollResult ready = PollResult::None;
+        if (tcpReady && events.udp) ready = PollResult::Both;
+        else if (tcpReady) ready = PollResult::Tcp;
+        else if (events.udp) ready = PollResult::Udp;
+
+        if (ready == PollResult::None) return;
 
-            auto res = socket.recvRawTcpData(stage2 ? 1 : 0, 100);
-            if (stage2) {
-                globed::netLog("Stage 2 response received, ok: {}, bytes: {}", res.isOk(), res.isOk() ? res.unwrap().size() : 0, 0);
+        auto recvResult = socket.recvReadyPackets(ready, recvBatch);
+
+        for (auto& received : recvBatch) {
+            if (auto packet = this->preprocessPacket(std::move(received))) {
+                dispatchBatch.push_back(std::move(packet));
             }
+        }
 
-            if (res.isErr()) {
-                auto error = std::move(res).unwrapErr();
-                if (error != "timed out") {
-                    this->disconnectWithMessage(fmt::format("Failed to receive data from the relay server: {}", error));
-                }
+        recvBatch.clear();
 
-                return;
+        if (!dispatchBatch.empty()) {
+            globed::netLog("NetworkManagerImpl::waitAndReceive dispatching {} packets", dispatchBatch.size());
+            PacketListenerPool::get().pushPackets(dispatchBatch);
+        }
+
+        if (recvResult.isErr()) {
+            // a socket may have been closed or recreated
+            reactor.resetSockets();
+            this->onConnectionError(recvResult.unwrapErr());
+        }
+    }
+
+    void receiveRelayResponse(bool stage2) {
+        if ((relayStage1Finished && !stage2) || relayConnFinished) {
+            // the state is advanced on the next iteration, the data (if any) is for the next stage
+            return;
+        }
+
+        globed::netLog("Receiving relay TCP data, stage2: {}", stage2);
+
+        auto res = socket.recvRawTcpData(stage2 ? 1 : 0, 0);
+        if (stage2) {
+            globed::netLog("Stage 2 response received, ok: {}, bytes: {}", res.isOk(), res.isOk() ? res.unwrap().size() : 0, 0);
+        }
+
+        if (res.isErr()) {
+            auto error = std::move(res).unwrapErr();
+            if (error != "timed out") {
+                this->disconnectWithMessage(fmt::format("Failed to receive data from the relay server: {}", error));
             }
 
-            auto data = std::move(res).unwrap();
-            globed::netLog("Relay server response (auth stage {}): {}", stage2 ? 2 : 1, data);
+            return;
+        }
+
+        auto data = std::move(res).unwrap();
+        globed::netLog("Relay server response (auth stage {}): {}", stage2 ? 2 : 1, data);
+
+        ByteBuffer buf(std::move(data));
 
-            ByteBuffer buf(std::move(data));
+        if (!stage2) {
+            bool success = buf.readU8().unwrapOr(0) == 1;
 
-            if (!stage2) {
-                bool success = buf.readU8().unwrapOr(0) == 1;
+            if (!success) {
+                auto msglen = buf.readU32().unwrapOr(0);
 
-                if (!success) {
-                    auto msglen = buf.readU32().unwrapOr(0);
+                if (msglen == 0 || msglen > 256) {
+                    this->disconnectWithMessage("Relay returned failure without a proper error message");
+                } else {
+                    std::string out;
+                    out.resize(msglen);
 
-                    if (msglen == 0 || msglen > 256) {
+                    if (!buf.readBytesInto((uint8_t*)out.data(), msglen) || !isValidAscii(out)) {
                         this->disconnectWithMessage("Relay returned failure without a proper error message");
                     } else {
-                        std::string out;
-                        out.resize(msglen);
-
-                        if (!buf.readBytesInto((uint8_t*)out.data(), msglen) || !isValidAscii(out)) {
-                            this->disconnectWithMessage("Relay returned failure without a proper error message");
-                        } else {
-                            this->disconnectWithMessage(fmt::format("Relay returned error: {}", out));
-                        }
+                        this->disconnectWithMessage(fmt::format("Relay returned error: {}", out));
                     }
-                } else {
-                    uint32_t udpId = buf.readU32().unwrapOr(0);
-                    relayUdpId = udpId;
-                    relayStage1Finished = true;
                 }
             } else {
-                // stage 2
-                if (buf.readU8().unwrapOr(0) != 1) {
-                    this->disconnectWithMessage(fmt::format("Relay returned auth failure"));
-                } else {
-                    relayConnFinished = true;
-                }
+                uint32_t udpId = buf.readU32().unwrapOr(0);
+                relayUdpId = udpId;
+                relayStage1Finished = true;
+            }
+        } else {
+            // stage 2
+            if (buf.readU8().unwrapOr(0) != 1) {
+                this->disconnectWithMessage(fmt::format("Relay returned auth failure"));
+            } else {
+                relayConnFinished = true;
             }
-
-            return;
         }
+    }
 
-        auto packet_ = socket.recvPacket(100);
-        if (packet_.isErr()) {
-            auto error = std::move(packet_.unwrapErr());
-            if (error != "timed out") {
-                this->onConnectionError(error);
+    static Duration remaining(Duration elapsed, Duration period) {
+        return elapsed >= period ? Duration{} : period - elapsed;
+    }
+
+    // How long the network thread may wait until a timer needs to fire, -1 if nothing is scheduled.
+    // Keep this in sync with the conditions in `updateConnection` and `maybeSendKeepalive`.
+    int nextTimeout() {
+        std::optional<Duration> next;
+
+        auto schedule = [&](Duration in) {
+            if (!next || in < *next) next = in;
+        };
+
+        if (requestedAbort) {
+            schedule(Duration{});
+        } else if (state == ConnectionState::TcpConnecting && recovering) {
+            schedule(remaining(lastRecoverAttempt.elapsed(), recoverDelay));
+        } else if (state == ConnectionState::Authenticating && !recovering) {
+            schedule(remaining(lastReceivedPacket.lock()->elapsed(), Duration::fromSecs(5)));
+        } else if (this->established()) {
+            auto now = SystemTime::now();
+
+            auto sinceLastPacket = (now - *lastReceivedPacket.lock()).value_or(Duration{});
+            auto sinceLastKeepalive = (now - lastSentKeepalive).value_or(Duration{});
+            auto sinceLastTcpExchange = (now - lastTcpExchange).value_or(Duration{});
+
+            // timeout
+            schedule(remaining(sinceLastPacket, Duration::fromSecs(20)));
+            // keepalives
+            schedule(std::max(remaining(sinceLastPacket, Duration::fromSecs(10)), remaining(sinceLastKeepalive, Duration::fromSecs(3))));
+            schedule(remaining(sinceLastKeepalive, Duration::fromSecs(30)));
+
+            if (this->wantsClockSync()) {
+                schedule(remaining(sinceLastKeepalive, this->clockSyncInterval()));
             }
 
-            return;
+            if (!socket.forceUseTcp) {
+                schedule(remaining(sinceLastTcpExchange, Duration::fromSecs(60)));
+            }
+
+            // the friend list is loaded by a web request, there is no way to get notified when it's done
+            if (!sentFriends) {
+                schedule(Duration::fromSecs(1));
+            }
         }
 
-        // this is awesome
-        auto packet__ = packet_.unwrap();
-        auto packet = std::move(packet__.packet);
-        bool fromServer = packet__.fromConnected;
+        if (!next) return -1;
+
+        // round up, so that we don't wake up right before the timer is due and then spin
+        return static_cast<int>((next->micros() + 999) / 1000);
+    }
+
+    // Handle every queued task without blocking, udp packets are collected and sent in one batch
+    void processTasks() {
+        while (auto task_ = taskQueue.tryPop()) {
+            auto task = std::move(task_.value());
+
+            if (auto* sendTask = std::get_if<TaskSendPacket>(&task); sendTask && this->canBatchSend(*sendTask)) {
+                sendBatch.push_back(std::move(sendTask->packet));
+                sendBatchQueuedAt.push_back(sendTask->queuedAt);
+            } else {
+                // flush first, so that packets are still sent in the order they were queued in
+                this->flushSendBatch();
+
+                if (std::holds_alternative<TaskPingServers>(task)) {
+                    this->handlePingTask();
+                } else if (std::holds_alternative<TaskSendPacket>(task)) {
+                    this->handleSendPacketTask(std::move(std::get<TaskSendPacket>(task)));
+                } else if (std::holds_alternative<TaskPingActive>(task)) {
+                    this->handlePingActive();
+                }
+            }
+        }
+
+        this->flushSendBatch();
+    }
+
+    // Handles ping responses, rejects packets from other sources and runs internal listeners.
+    // Returns the packet if it should be passed on to the listener pool, nullptr otherwise.
+    std::shared_ptr<Packet> preprocessPacket(GameSocket::ReceivedPacket&& received) {
+        auto packet = std::move(received.packet);
+        bool fromServer = received.fromConnected;
 
         packetid_t id = packet->getPacketId();
 
         if (id == PingResponsePacket::PACKET_ID) {
-            globed::netLog("NetworkManagerImpl::threadRecvFunc handling ping response");
+            globed::netLog("NetworkManagerImpl::preprocessPacket handling ping response");
             this->handlePingResponse(std::move(packet));
-            return;
+            return nullptr;
         }
 
         // if it's not a ping packet, and it's NOT from the currently connected server, we reject it
         if (!fromServer) {
-            globed::netLog("NetworkManagerImpl::threadRecvFunc rejecting packet NOT from the server (id = {})", id);
-            return;
+            globed::netLog("NetworkManagerImpl::preprocessPacket rejecting packet NOT from the server (id = {})", id);
+            return nullptr;
         }
 
         *lastReceivedPacket.lock() = SystemTime::now();
 
-        globed::netLog("NetworkManagerImpl::threadRecvFunc dispatching packet {}", id);
+        globed::netLog("NetworkManagerImpl::preprocessPacket dispatching packet {}", id);
 
-        this->callListener(std::move(packet));
+        return this->callInternalListener(std::move(packet));
     }
 
-    void callListener(std::shared_ptr<Packet>&& packet) {
+    // Calls the internal listener for this packet, if any. Returns the packet unless the listener was final.
+    std::shared_ptr<Packet> callInternalListener(std::shared_ptr<Packet>&& packet) {
         packetid_t packetId = packet->getPacketId();
 
         // go through internal listeners
@@ -1049,13 +1352,10 @@ protected:
         if (ls->contains(packetId)) {
             auto listener = ls->at(packetId);
             listener.callback(packet);
-            if (listener.isFinal) return;
+            if (listener.isFinal) return nullptr;
         }
 
-        ls.unlock();
-
-        // call other listeners
-        PacketListenerPool::get().pushPacket(std::move(packet));
+        return std::move(packet);
     }
 
     void handlePingResponse(std::shared_ptr<Packet>&& packet) {
@@ -1064,12 +1364,8 @@ protected:
         }
     }
 
-    void threadMainFunc(decltype(threadMain)::StopToken&) {
-        if (this->suspended) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            return;
-        }
-
+    // Drive the connection state machine. Blocking operations (connecting, DNS resolution) are done here directly.
+    void updateConnection() {
         // Initial tcp connection.
         if (state == ConnectionState::TcpConnecting && !recovering) {
             // try to connect
@@ -1090,6 +1386,9 @@ protected:
                 result = socket.connect(connectedAddress, recovering);
             }
 
+            // sockets may have been recreated
+            reactor.resetSockets();
+
             if (!result) {
                 this->disconnect(true);
 
@@ -1149,10 +1448,24 @@ protected:
         }
         // Connection recovery loop itself
         else if (state == ConnectionState::TcpConnecting && recovering) {
+            if (cancellingRecovery) {
+                log::debug("recovery attempts were cancelled.");
+                recovering = false;
+                recoverAttempt = 0;
+                state = ConnectionState::Disconnected;
+                return;
+            }
+
+            // wait a bit after a failed attempt, `nextTimeout` makes sure we wake up in time
+            if (lastRecoverAttempt.elapsed() < recoverDelay) {
+                return;
+            }
+
             globed::netLog("NetworkManagerImpl::threadMainFunc connection recovery attempt {}", recoverAttempt.load());
 
             // initiate TCP connection
             auto result = socket.connect(connectedAddress, recovering);
+            reactor.resetSockets();
 
             bool failed = false;
 
@@ -1184,28 +1497,14 @@ protected:
                     return;
                 }
 
-                auto sleepPeriod = Duration::fromSecs(10) * attemptNumber;
+                recoverDelay = Duration::fromSecs(10) * attemptNumber;
+                lastRecoverAttempt = Instant::now();
 
                 globed::netLog(
-                    "NetworkManagerImpl::threadMainFunc recovery connection failed, sleeping for {} before trying again",
-                    GLOBED_LAZY(sleepPeriod.toString())
+                    "NetworkManagerImpl::threadMainFunc recovery connection failed, waiting for {} before trying again",
+                    GLOBED_LAZY(recoverDelay.toString())
                 );
 
-                // wait for a bit before trying again
-
-                // we sleep 50 times because we want to check if the user cancelled the recovery
-                for (size_t i = 0; i < 50; i++) {
-                    asp::time::sleep(sleepPeriod / 50);
-
-                    if (cancellingRecovery) {
-                        log::debug("recovery attempts were cancelled.");
-                        recovering = false;
-                        recoverAttempt = 0;
-                        state = ConnectionState::Disconnected;
-                        return;
-                    }
-                }
-
                 return;
             }
         }
@@ -1219,6 +1518,7 @@ protected:
             recovering = true;
             cancellingRecovery = false;
             recoverAttempt = 0;
+            recoverDelay = Duration{};
             return;
         }
         // Detect if we disconnected while authenticating, likely the server doesn't expect us
@@ -1245,26 +1545,6 @@ protected:
             ));
             return;
         }
-        if (this->established()) {
-            this->maybeSendKeepalive();
-            this->maybeSendFriendList();
-        }
-
-        // poll for any incoming packets
-
-        while (auto task_ = taskQueue.popTimeout(Duration::fromMillis(50))) {
-            auto task = std::move(task_.value());
-
-            if (std::holds_alternative<TaskPingServers>(task)) {
-                this->handlePingTask();
-            } else if (std::holds_alternative<TaskSendPacket>(task)) {
-                this->handleSendPacketTask(std::move(std::get<TaskSendPacket>(task)));
-            } else if (std::holds_alternative<TaskPingActive>(task)) {
-                this->handlePingActive();
-            }
-        }
-
-        std::this_thread::yield();
     }
 
     void startCryptoHandshake() {
@@ -1273,9 +1553,11 @@ protected:
 
         socket.createBox();
 
+        // ask for counter based nonces, the server confirms it in the response if it supports them
         this->send(CryptoHandshakeStartPacket::create(
             proto,
-            CryptoPublicKey(socket.cryptoBox->extractPublicKey())
+            CryptoPublicKey(socket.cryptoBox->extractPublicKey()),
+            CryptoNonceMode { CryptoBox::NonceMode::Counter }
         ));
     }
 
@@ -1298,9 +1580,11 @@ protected:
         // send a keepalive if either one of those is true:
         // 1. last received packet was more than 10s ago and we haven't sent a keepalive in 3 seconds
         // 2. last keepalive was sent more than 30 seconds ago
+        // 3. the clocks are being synchronized and it's time for the next exchange
         else if (
             (sinceLastPacket > Duration::fromSecs(10) && sinceLastKeepalive > Duration::fromSecs(3))
             || (sinceLastKeepalive > Duration::fromSecs(30))
+            || (this->wantsClockSync() && sinceLastKeepalive > this->clockSyncInterval())
         ) {
             this->sendKeepalive();
         }
@@ -1332,11 +1616,35 @@ protected:
     void sendKeepalive() {
         globed::netLog("NetworkManagerImpl::sendKeepalive (previous was {} ago)", GLOBED_LAZY(lastSentKeepalive.elapsed().toString()));
         // send a keepalive
-        this->send(KeepalivePacket::create());
+        double now = clockSync.lock()->localNow();
+        this->send(KeepalivePacket::create(static_cast<uint64_t>(now * 1'000'000.0)));
         lastSentKeepalive = SystemTime::now();
         GameServerManager::get().startKeepalive();
     }
 
+    // whether keepalives are sent more often to synchronize clocks with the server
+    bool wantsClockSync() {
+        return serverProtocol.load() >= CLOCK_SYNC_PROTOCOL;
+    }
+
+    // exchanges are frequent until there are a few to go off of, after that they only need to keep up with drift
+    Duration clockSyncInterval() {
+        return clockSync.lock()->getStats().samples < 4 ? Duration::fromSecs(2) : Duration::fromSecs(10);
+    }
+
+    std::optional<double> getServerTimeAge(uint64_t serverTime) {
+        if (serverTime == 0) return std::nullopt;
+
+        auto cs = clockSync.lock();
+        if (!cs->isSynchronized()) return std::nullopt;
+
+        return cs->localNow() - cs->toLocal(serverTime);
+    }
+
+    ClockSyncStats getClockStats() {
+        return clockSync.lock()->getStats();
+    }
+
     void failedRecovery() {
         recovering = false;
         recoverAttempt = 0;
@@ -1384,7 +1692,42 @@ protected:
             }
         } catch (const std::exception& e) {
             this->onConnectionError(e.what());
+            return;
         }
+
+#ifdef GLOBED_DEBUG_PACKETS
+        util::debug::PacketLogger::get().recordSendLatency(task.queuedAt.elapsed());
+#endif
+    }
+
+    bool canBatchSend(const TaskSendPacket& task) {
+        return socket.isBatchedUdp() && !socket.forceUseTcp && !task.packet->getUseTcp();
+    }
+
+    void flushSendBatch() {
+        if (sendBatch.empty()) return;
+
+        try {
+            auto result = socket.sendPacketsUDP(sendBatch);
+            if (!result) {
+                auto error = result.unwrapErr();
+                log::debug("failed to send {} packets: {}", sendBatch.size(), error);
+                this->onConnectionError(error);
+            }
+
+#ifdef GLOBED_DEBUG_PACKETS
+            if (result) {
+                for (auto& queuedAt : sendBatchQueuedAt) {
+                    util::debug::PacketLogger::get().recordSendLatency(queuedAt.elapsed());
+                }
+            }
+#endif
+        } catch (const std::exception& e) {
+            this->onConnectionError(e.what());
+        }
+
+        sendBatch.clear();
+        sendBatchQueuedAt.clear();
     }
 
     void handlePingActive() {
@@ -1476,6 +1819,18 @@ uint16_t NetworkManager::getUsedProtocol() {
     return impl->getUsedProtocol();
 }
 
+UdpFrameStats NetworkManager::getFrameStats() {
+    return impl->socket.udpBuffer.getStats();
+}
+
+std::optional<double> NetworkManager::getServerTimeAge(uint64_t serverTime) {
+    return impl->getServerTimeAge(serverTime);
+}
+
+ClockSyncStats NetworkManager::getClockStats() {
+    return impl->getClockStats();
+}
+
 uint32_t NetworkManager::getServerTps() {
     return impl->getServerTps();
 }
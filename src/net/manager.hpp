@@ -12,6 +12,8 @@ class NetworkAddress;
 struct GameServer;
 class Packet;
 struct UserPrivacyFlags;
+struct UdpFrameStats;
+struct ClockSyncStats;
 
 template <typename T>
 concept HasPacketID = requires { T::PACKET_ID; };
@@ -123,6 +125,16 @@ public:
     // Returns whether we are currently trying to reconnect to a server due to an earlier connection break.
     bool reconnecting();
 
+    // Returns the counters of the UDP frame reassembly table
+    UdpFrameStats getFrameStats();
+
+    // How many seconds ago the server's clock read `serverTime` (in microseconds), nullopt if our clocks aren't synchronized
+    // or `serverTime` is 0. May be slightly negative, the synchronization is only as accurate as the network is symmetric.
+    std::optional<double> getServerTimeAge(uint64_t serverTime);
+
+    // Returns the state of the clock synchronization with the server
+    ClockSyncStats getClockStats();
+
     // Pause all network threads
     void suspend();
     // Resume all network threads
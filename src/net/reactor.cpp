@@ -0,0 +1,280 @@
+#include "reactor.hpp"
+
+#include <util/net.hpp>
+
+#ifdef GEODE_IS_WINDOWS
+# include <WinSock2.h>
+# include <Ws2tcpip.h>
+#else
+# include <sys/socket.h>
+# include <netinet/in.h>
+# include <unistd.h>
+# include <poll.h>
+# include <fcntl.h>
+#endif
+
+#ifdef GLOBED_SOCKET_EPOLL
+# include <sys/epoll.h>
+# include <sys/eventfd.h>
+#elif defined(GLOBED_SOCKET_KQUEUE)
+# include <sys/event.h>
+#endif
+
+constexpr uint32_t TAG_WAKE = 0;
+constexpr uint32_t TAG_TCP = 1;
+constexpr uint32_t TAG_UDP = 2;
+
+#ifdef GLOBED_SOCKET_KQUEUE
+// identifier of the EVFILT_USER event used for wakeups
+constexpr uintptr_t WAKE_IDENT = 1;
+#endif
+
+NetReactor::~NetReactor() {
+#ifdef GLOBED_SOCKET_EPOLL
+    if (wakeFd != -1) ::close(wakeFd);
+#elif !defined(GLOBED_SOCKET_KQUEUE)
+# ifdef GEODE_IS_WINDOWS
+    if (wakeSocket != INVALID_HANDLE) ::closesocket(wakeSocket);
+# else
+    if (wakeSocket != INVALID_HANDLE) ::close(wakeSocket);
+# endif
+#endif
+
+#if defined(GLOBED_SOCKET_EPOLL) || defined(GLOBED_SOCKET_KQUEUE)
+    if (pollFd != -1) ::close(pollFd);
+#endif
+}
+
+Result<> NetReactor::init() {
+#ifdef GLOBED_SOCKET_EPOLL
+    pollFd = epoll_create1(EPOLL_CLOEXEC);
+    GLOBED_REQUIRE_SAFE(pollFd != -1, fmt::format("epoll_create1 failed: {}", util::net::lastErrorString()))
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    GLOBED_REQUIRE_SAFE(wakeFd != -1, fmt::format("eventfd failed: {}", util::net::lastErrorString()))
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = TAG_WAKE;
+
+    GLOBED_REQUIRE_SAFE(
+        epoll_ctl(pollFd, EPOLL_CTL_ADD, wakeFd, &ev) == 0,
+        fmt::format("failed to register the wakeup fd: {}", util::net::lastErrorString())
+    )
+#elif defined(GLOBED_SOCKET_KQUEUE)
+    pollFd = kqueue();
+    GLOBED_REQUIRE_SAFE(pollFd != -1, fmt::format("kqueue failed: {}", util::net::lastErrorString()))
+
+    struct kevent ev;
+    EV_SET(&ev, WAKE_IDENT, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+
+    GLOBED_REQUIRE_SAFE(
+        kevent(pollFd, &ev, 1, nullptr, 0, nullptr) == 0,
+        fmt::format("failed to register the wakeup event: {}", util::net::lastErrorString())
+    )
+#else
+    // there is nothing like eventfd that WSAPoll can wait on, so use a udp socket that is connected to itself
+    wakeSocket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    GLOBED_REQUIRE_SAFE(wakeSocket != INVALID_HANDLE, fmt::format("failed to create the wakeup socket: {}", util::net::lastErrorString()))
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = 0;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen_t addrLen = sizeof(addr);
+
+    bool success = ::bind(wakeSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0
+        && ::getsockname(wakeSocket, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0
+        && ::connect(wakeSocket, reinterpret_cast<sockaddr*>(&addr), addrLen) == 0;
+
+    GLOBED_REQUIRE_SAFE(success, fmt::format("failed to set up the wakeup socket: {}", util::net::lastErrorString()))
+
+# ifdef GEODE_IS_WINDOWS
+    u_long mode = 1;
+    ::ioctlsocket(wakeSocket, FIONBIO, &mode);
+# else
+    ::fcntl(wakeSocket, F_SETFL, ::fcntl(wakeSocket, F_GETFL, 0) | O_NONBLOCK);
+# endif
+#endif
+
+    return Ok();
+}
+
+void NetReactor::wake() {
+    // if a wakeup is already pending, the waiting thread will see it anyway
+    if (wakePending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+#ifdef GLOBED_SOCKET_EPOLL
+    uint64_t one = 1;
+    (void) ::write(wakeFd, &one, sizeof(one));
+#elif defined(GLOBED_SOCKET_KQUEUE)
+    struct kevent ev;
+    EV_SET(&ev, WAKE_IDENT, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+    (void) kevent(pollFd, &ev, 1, nullptr, 0, nullptr);
+#else
+    char byte = 0;
+    (void) ::send(wakeSocket, &byte, 1, 0);
+#endif
+}
+
+Result<NetReactor::Events> NetReactor::wait(SocketHandle tcp, SocketHandle udp, int timeoutMs) {
+    GLOBED_UNWRAP(this->updateRegistration(registeredTcp, tcp, TAG_TCP));
+    GLOBED_UNWRAP(this->updateRegistration(registeredUdp, udp, TAG_UDP));
+
+    Events out;
+
+#ifdef GLOBED_SOCKET_EPOLL
+    epoll_event events[3];
+    int count = epoll_wait(pollFd, events, 3, timeoutMs);
+
+    if (count == -1) {
+        if (errno == EINTR) return Ok(out);
+        return Err(fmt::format("epoll_wait failed: {}", util::net::lastErrorString()));
+    }
+
+    for (int i = 0; i < count; i++) {
+        switch (events[i].data.u32) {
+            case TAG_WAKE: out.woken = true; break;
+            case TAG_TCP: out.tcp = true; break;
+            case TAG_UDP: out.udp = true; break;
+        }
+    }
+#elif defined(GLOBED_SOCKET_KQUEUE)
+    struct kevent events[3];
+    timespec ts;
+
+    if (timeoutMs >= 0) {
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1'000'000;
+    }
+
+    int count = kevent(pollFd, nullptr, 0, events, 3, timeoutMs >= 0 ? &ts : nullptr);
+
+    if (count == -1) {
+        if (errno == EINTR) return Ok(out);
+        return Err(fmt::format("kevent failed: {}", util::net::lastErrorString()));
+    }
+
+    for (int i = 0; i < count; i++) {
+        switch (reinterpret_cast<uintptr_t>(events[i].udata)) {
+            case TAG_WAKE: out.woken = true; break;
+            case TAG_TCP: out.tcp = true; break;
+            case TAG_UDP: out.udp = true; break;
+        }
+    }
+#else
+    GLOBED_SOCKET_POLLFD fds[3];
+    uint32_t tags[3];
+    size_t fdCount = 0;
+
+    auto addFd = [&](SocketHandle handle, uint32_t tag) {
+        if (handle == INVALID_HANDLE) return;
+
+        fds[fdCount].fd = handle;
+        fds[fdCount].events = POLLIN;
+        fds[fdCount].revents = 0;
+        tags[fdCount] = tag;
+        fdCount++;
+    };
+
+    addFd(wakeSocket, TAG_WAKE);
+    addFd(registeredTcp, TAG_TCP);
+    addFd(registeredUdp, TAG_UDP);
+
+    int count = GLOBED_SOCKET_POLL(fds, fdCount, timeoutMs);
+
+    if (count == -1) {
+        return Err(fmt::format("poll failed: {}", util::net::lastErrorString()));
+    }
+
+    for (size_t i = 0; i < fdCount; i++) {
+        if (fds[i].revents == 0) continue;
+
+        switch (tags[i]) {
+            case TAG_WAKE: out.woken = true; break;
+            case TAG_TCP: out.tcp = true; break;
+            case TAG_UDP: out.udp = true; break;
+        }
+    }
+#endif
+
+    if (out.woken) {
+        // reset the flag before draining, so a wakeup that races with us is never lost
+        wakePending.store(false, std::memory_order_release);
+        this->drainWakeups();
+    }
+
+    return Ok(out);
+}
+
+void NetReactor::resetSockets() {
+    this->unregister(registeredTcp);
+    this->unregister(registeredUdp);
+
+    registeredTcp = INVALID_HANDLE;
+    registeredUdp = INVALID_HANDLE;
+}
+
+Result<> NetReactor::updateRegistration(SocketHandle& registered, SocketHandle wanted, uint32_t tag) {
+    if (registered == wanted) {
+        return Ok();
+    }
+
+    this->unregister(registered);
+    registered = INVALID_HANDLE;
+
+    if (wanted == INVALID_HANDLE) {
+        return Ok();
+    }
+
+#ifdef GLOBED_SOCKET_EPOLL
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = tag;
+
+    if (epoll_ctl(pollFd, EPOLL_CTL_ADD, wanted, &ev) != 0) {
+        // the socket may still be registered if `resetSockets` was called while it was open
+        if (errno != EEXIST || epoll_ctl(pollFd, EPOLL_CTL_MOD, wanted, &ev) != 0) {
+            return Err(fmt::format("failed to register socket: {}", util::net::lastErrorString()));
+        }
+    }
+#elif defined(GLOBED_SOCKET_KQUEUE)
+    struct kevent ev;
+    EV_SET(&ev, wanted, EVFILT_READ, EV_ADD, 0, 0, reinterpret_cast<void*>(static_cast<uintptr_t>(tag)));
+
+    if (kevent(pollFd, &ev, 1, nullptr, 0, nullptr) != 0) {
+        return Err(fmt::format("failed to register socket: {}", util::net::lastErrorString()));
+    }
+#endif
+
+    registered = wanted;
+    return Ok();
+}
+
+void NetReactor::unregister(SocketHandle handle) {
+    if (handle == INVALID_HANDLE) return;
+
+    // closing a socket already removes it from the set, so failures here are expected and ignored
+#ifdef GLOBED_SOCKET_EPOLL
+    (void) epoll_ctl(pollFd, EPOLL_CTL_DEL, handle, nullptr);
+#elif defined(GLOBED_SOCKET_KQUEUE)
+    struct kevent ev;
+    EV_SET(&ev, handle, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+    (void) kevent(pollFd, &ev, 1, nullptr, 0, nullptr);
+#endif
+}
+
+void NetReactor::drainWakeups() {
+#ifdef GLOBED_SOCKET_EPOLL
+    uint64_t value;
+    (void) ::read(wakeFd, &value, sizeof(value));
+#elif defined(GLOBED_SOCKET_KQUEUE)
+    // EV_CLEAR resets the event automatically
+#else
+    char buf[64];
+    while (::recv(wakeSocket, buf, sizeof(buf), 0) > 0) {}
+#endif
+}
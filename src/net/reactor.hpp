@@ -0,0 +1,68 @@
+#pragma once
+#include <defs/minimal_geode.hpp>
+#include <defs/net.hpp>
+
+#include <atomic>
+
+// Event loop primitive for the network thread. Blocks until one of the game sockets becomes readable,
+// another thread calls `wake`, or the timeout expires, whichever happens first.
+// Uses epoll on Linux and Android, kqueue on Apple platforms, and elsewhere (Windows) falls back to
+// `GLOBED_SOCKET_POLL` with a loopback UDP socket for wakeups.
+class NetReactor {
+public:
+#ifdef GEODE_IS_WINDOWS
+    using SocketHandle = uintptr_t;
+#else
+    using SocketHandle = int;
+#endif
+
+    static constexpr SocketHandle INVALID_HANDLE = static_cast<SocketHandle>(-1);
+
+    struct Events {
+        bool tcp = false;
+        bool udp = false;
+        bool woken = false;
+    };
+
+    NetReactor() = default;
+    ~NetReactor();
+
+    NetReactor(const NetReactor&) = delete;
+    NetReactor& operator=(const NetReactor&) = delete;
+
+    // Create the underlying OS resources. On Windows, must be called after `util::net::initialize`.
+    Result<> init();
+
+    // Wake up the thread blocked in `wait`. If no thread is waiting, the next `wait` returns immediately.
+    // Multiple calls before the waiting thread wakes up are coalesced into a single one. Thread safe.
+    void wake();
+
+    // Wait until a socket is readable, `wake` is called or `timeoutMs` passes. A negative timeout waits indefinitely.
+    // Pass `INVALID_HANDLE` for a socket that should not be watched. Errors and hangups are reported as readable.
+    Result<Events> wait(SocketHandle tcp, SocketHandle udp, int timeoutMs);
+
+    // Forget registered sockets. Must be called after a socket is closed and recreated, since the new one may reuse the same handle.
+    void resetSockets();
+
+private:
+    std::atomic_bool wakePending = false;
+
+    SocketHandle registeredTcp = INVALID_HANDLE;
+    SocketHandle registeredUdp = INVALID_HANDLE;
+
+#if defined(GLOBED_SOCKET_EPOLL) || defined(GLOBED_SOCKET_KQUEUE)
+    // epoll or kqueue instance
+    int pollFd = -1;
+#endif
+
+#ifdef GLOBED_SOCKET_EPOLL
+    int wakeFd = -1;
+#elif !defined(GLOBED_SOCKET_KQUEUE)
+    // connected to itself, `wake` sends a byte to it
+    SocketHandle wakeSocket = INVALID_HANDLE;
+#endif
+
+    Result<> updateRegistration(SocketHandle& registered, SocketHandle wanted, uint32_t tag);
+    void unregister(SocketHandle handle);
+    void drainWakeups();
+};
@@ -2,11 +2,14 @@
 
 #include <data/bytebuffer.hpp>
 
-Result<std::vector<uint8_t>> UdpFrameBuffer::pushFrameFromBuffer(ByteBuffer& buf) {
+using namespace asp::time;
+using namespace util::data;
+
+Result<PacketBufferRef> UdpFrameBuffer::pushFrameFromBuffer(ByteReader& buf) {
     uint32_t packetId;
     uint8_t frameIdx, frameCount;
 
-    auto rres = [&]() -> ByteBuffer::DecodeResult<>{
+    auto rres = [&]() -> ByteReader::DecodeResult<>{
         GLOBED_UNWRAP_INTO(buf.readU32(), packetId);
         GLOBED_UNWRAP_INTO(buf.readU8(), frameIdx);
         GLOBED_UNWRAP_INTO(buf.readU8(), frameCount);
@@ -15,68 +18,185 @@ Result<std::vector<uint8_t>> UdpFrameBuffer::pushFrameFromBuffer(ByteBuffer& buf
     }();
 
     if (!rres) {
+        dropped++;
         return Err(fmt::to_string(rres.unwrapErr()));
     }
 
-    auto& frames = packets[packetId];
-
     // do some sanity checks
 
     if (frameIdx >= frameCount) {
+        dropped++;
         return Err("frame index/count invalid");
     }
 
-    for (const auto& frame : frames) {
-        if (frame.idx == frameIdx) {
-            return Err("repeated udp frame");
+    const byte* data = buf.span().data() + buf.getPosition();
+    size_t size = buf.size() - buf.getPosition();
+
+    auto now = Instant::now();
+    this->evictExpired(now);
+
+    auto& slot = this->findOrClaimSlot(packetId, frameCount, now);
+
+    if (slot.frameCount != frameCount) {
+        dropped++;
+        return Err("mismatched frame idx/max");
+    }
+
+    if (slot.hasFrame(frameIdx)) {
+        duplicate++;
+        return Ok(PacketBufferRef{});
+    }
+
+    bool isLast = frameIdx == frameCount - 1;
+
+    if (!isLast) {
+        if (slot.chunkSize == 0) {
+            if (size == 0 || size * frameCount > MAX_MESSAGE_SIZE) {
+                dropped++;
+                this->releaseSlot(slot);
+                return Err("invalid udp frame size");
+            }
+
+            // now that we know the size of each chunk, the last frame can be put in place as well
+            slot.chunkSize = size;
+            slot.buffer->data.resize(size * frameCount);
+
+            if (slot.lastSize != 0) {
+                if (slot.lastSize > slot.chunkSize) {
+                    dropped += slot.receivedCount + 1;
+                    this->releaseSlot(slot);
+                    return Err("udp frame larger than the chunk size");
+                }
+
+                this->writeFrame(slot, frameCount - 1, slot.pendingLast.data(), slot.lastSize);
+            }
+        } else if (size != slot.chunkSize) {
+            dropped++;
+            return Err("mismatched udp frame size");
         }
 
-        if (frame.max != frameCount) {
-            return Err("mismatched frame idx/max");
+        this->writeFrame(slot, frameIdx, data, size);
+    } else {
+        if (slot.chunkSize == 0 && frameCount > 1) {
+            // chunk size is not known yet, so we don't know where to put this frame
+            slot.pendingLast.assign(data, data + size);
+        } else if (size > slot.chunkSize && frameCount > 1) {
+            dropped++;
+            return Err("udp frame larger than the chunk size");
+        } else {
+            if (frameCount == 1) {
+                slot.buffer->data.resize(size);
+            }
+
+            this->writeFrame(slot, frameIdx, data, size);
         }
+
+        slot.lastSize = size;
     }
 
-    std::vector<uint8_t> data;
-    size_t remainderLength = buf.size() - buf.getPosition();
-    data.resize(remainderLength);
+    slot.markFrame(frameIdx);
+    slot.receivedCount++;
+
+    // check if we got all the needed frames
+    if (slot.receivedCount == slot.frameCount) {
+        slot.buffer->data.resize(slot.chunkSize * (slot.frameCount - 1) + slot.lastSize);
+
+        auto out = std::move(slot.buffer);
+        this->releaseSlot(slot);
+        completed++;
 
-    auto result = buf.readBytesInto(data.data(), remainderLength);
-    if (!result) {
-        return Err(fmt::to_string(result.unwrapErr()));
+        return Ok(std::move(out));
     }
 
-    frames.push_back(Frame {
-        .idx = frameIdx,
-        .max = frameCount,
-        .data = std::move(data)
-    });
+    return Ok(PacketBufferRef{});
+}
 
-    // check if we got all the needed frames
-    if (frames.size() == frameCount) {
-        std::sort(frames.begin(), frames.end(), [](auto& a, auto& b) {
-            return a.idx < b.idx;
-        });
+UdpFrameStats UdpFrameBuffer::getStats() {
+    return UdpFrameStats {
+        .completed = completed.load(),
+        .duplicate = duplicate.load(),
+        .dropped = dropped.load(),
+        .expired = expired.load(),
+    };
+}
+
+void UdpFrameBuffer::clear() {
+    for (auto& slot : slots) {
+        if (slot.used) {
+            this->releaseSlot(slot);
+        }
+    }
+
+    completed = 0;
+    duplicate = 0;
+    dropped = 0;
+    expired = 0;
+}
 
-        std::vector<uint8_t> data;
+UdpFrameBuffer::Slot& UdpFrameBuffer::findOrClaimSlot(uint32_t packetId, uint8_t frameCount, const Instant& now) {
+    Slot* freeSlot = nullptr;
+    Slot* oldestSlot = nullptr;
 
-        // calculate full frame size
-        size_t totalSize = 0;
-        for (auto& frame : frames) {
-            totalSize += frame.data.size();
+    for (auto& slot : slots) {
+        if (!slot.used) {
+            if (!freeSlot) freeSlot = &slot;
+            continue;
         }
 
-        data.reserve(totalSize);
+        if (slot.packetId == packetId) {
+            return slot;
+        }
 
-        for (auto& frame : frames) {
-            data.insert(data.end(), frame.data.begin(), frame.data.end());
+        if (!oldestSlot || slot.claimOrder < oldestSlot->claimOrder) {
+            oldestSlot = &slot;
         }
+    }
 
-        return Ok(std::move(data));
+    // table is full, evict the oldest incomplete message
+    if (!freeSlot) {
+        dropped += oldestSlot->receivedCount;
+        this->releaseSlot(*oldestSlot);
+        freeSlot = oldestSlot;
     }
 
-    return Ok(std::vector<uint8_t>{});
+    auto& slot = *freeSlot;
+    slot.used = true;
+    slot.packetId = packetId;
+    slot.frameCount = frameCount;
+    slot.receivedCount = 0;
+    slot.chunkSize = 0;
+    slot.lastSize = 0;
+    slot.createdAt = now;
+    slot.claimOrder = nextClaimOrder++;
+    slot.receivedMask.fill(0);
+    slot.buffer = PacketBufferPool::get().acquire(0);
+
+    return slot;
 }
 
-void UdpFrameBuffer::clear() {
-    packets.clear();
+void UdpFrameBuffer::evictExpired(const Instant& now) {
+    for (auto& slot : slots) {
+        if (slot.used && now.durationSince(slot.createdAt) > Duration::fromMillis(MAX_AGE_MS)) {
+            expired += slot.receivedCount;
+            this->releaseSlot(slot);
+        }
+    }
+}
+
+void UdpFrameBuffer::releaseSlot(Slot& slot) {
+    slot.used = false;
+    slot.buffer.reset();
+    // keeps the capacity around for the next message
+    slot.pendingLast.clear();
+}
+
+void UdpFrameBuffer::writeFrame(Slot& slot, size_t idx, const byte* data, size_t size) {
+    size_t offset = idx * slot.chunkSize;
+    auto& out = slot.buffer->data;
+
+    if (out.size() < offset + size) {
+        out.resize(offset + size);
+    }
+
+    std::memcpy(out.data() + offset, data, size);
 }
@@ -1,21 +1,74 @@
 #pragma once
 
 #include <defs/minimal_geode.hpp>
+#include <data/packet_buffer.hpp>
 
-class ByteBuffer;
+#include <asp/time/Instant.hpp>
 
+class ByteReader;
+
+struct UdpFrameStats {
+    size_t completed;  // messages that were fully reassembled
+    size_t duplicate;  // frames that were received more than once
+    size_t dropped;    // frames that were invalid or evicted to make space for newer messages
+    size_t expired;    // frames of messages that never completed in time
+};
+
+// Reassembles fragmented UDP messages. Holds a fixed amount of slots, each collecting the frames of one message.
+// Frames are written directly at their final offset, so a completed message can be handed off without copying.
 class UdpFrameBuffer {
 public:
-    // push a new frame, if a packet is completed, return the full data
-    Result<std::vector<uint8_t>> pushFrameFromBuffer(ByteBuffer& buf);
+    // max amount of incomplete messages at once, when full the oldest one is evicted
+    static constexpr size_t MAX_SLOTS = 16;
+    // max amount of frames in a message (the frame count is sent as a u8)
+    static constexpr size_t MAX_FRAMES = 256;
+    // max size of a reassembled message
+    static constexpr size_t MAX_MESSAGE_SIZE = 4 << 20;
+    // messages that did not complete in this time (in milliseconds) are discarded
+    static constexpr uint64_t MAX_AGE_MS = 1000;
+
+    // push a new frame, if a message is completed, return the full data. Otherwise returns an empty ref.
+    Result<PacketBufferRef> pushFrameFromBuffer(ByteReader& buf);
+
+    UdpFrameStats getStats();
 
     void clear();
+
 private:
-    struct Frame {
-        uint8_t idx;
-        uint8_t max;
-        std::vector<uint8_t> data;
+    struct Slot {
+        bool used = false;
+        uint32_t packetId;
+        uint16_t frameCount;
+        uint16_t receivedCount;
+        // size of every frame except the last one, 0 if not known yet
+        size_t chunkSize;
+        // size of the last frame, 0 if not received yet
+        size_t lastSize;
+        asp::time::Instant createdAt;
+        uint64_t claimOrder;
+        std::array<uint64_t, MAX_FRAMES / 64> receivedMask;
+        PacketBufferRef buffer;
+        // the last frame is stashed here if it arrives before the chunk size is known
+        util::data::bytevector pendingLast;
+
+        bool hasFrame(size_t idx) const {
+            return (receivedMask[idx / 64] >> (idx % 64)) & 1;
+        }
+
+        void markFrame(size_t idx) {
+            receivedMask[idx / 64] |= (uint64_t)1 << (idx % 64);
+        }
     };
 
-    std::map<int, std::vector<Frame>> packets;
+    std::array<Slot, MAX_SLOTS> slots;
+    uint64_t nextClaimOrder = 0;
+
+    std::atomic<size_t> completed = 0, duplicate = 0, dropped = 0, expired = 0;
+
+    Slot& findOrClaimSlot(uint32_t packetId, uint8_t frameCount, const asp::time::Instant& now);
+    void evictExpired(const asp::time::Instant& now);
+    void releaseSlot(Slot& slot);
+
+    // copy frame data at its final offset, growing the buffer if needed
+    void writeFrame(Slot& slot, size_t idx, const util::data::byte* data, size_t size);
 };
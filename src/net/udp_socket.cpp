@@ -14,6 +14,10 @@
 # include <poll.h>
 #endif
 
+#ifdef GLOBED_SOCKET_MMSG
+# include <sys/uio.h>
+#endif
+
 UdpSocket::UdpSocket() : socket_(-1) {
     destAddr_ = std::make_unique<sockaddr_in>();
     std::memset(destAddr_.get(), 0, sizeof(sockaddr_in));
@@ -119,6 +123,119 @@ RecvResult UdpSocket::receive(char* buffer, int bufferSize) {
     };
 }
 
+int UdpSocket::receiveBatch(UdpDatagram* datagrams, size_t count) {
+    count = std::min(count, MAX_BATCH);
+
+#ifdef GLOBED_SOCKET_MMSG
+    mmsghdr msgs[MAX_BATCH];
+    iovec iovecs[MAX_BATCH];
+    sockaddr_in sources[MAX_BATCH];
+
+    std::memset(msgs, 0, sizeof(mmsghdr) * count);
+
+    for (size_t i = 0; i < count; i++) {
+        iovecs[i].iov_base = datagrams[i].data;
+        iovecs[i].iov_len = datagrams[i].size;
+
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &sources[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+
+    int result = recvmmsg(socket_, msgs, count, MSG_DONTWAIT, nullptr);
+
+    if (result == -1) {
+        // nothing queued is not an error
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+
+        return -1;
+    }
+
+    for (int i = 0; i < result; i++) {
+        datagrams[i].result = RecvResult {
+            .fromServer = this->connected && util::net::sameSockaddr(sources[i], *destAddr_),
+            .result = static_cast<int>(msgs[i].msg_len),
+        };
+    }
+
+    return result;
+#else
+    size_t received = 0;
+
+    while (received < count) {
+        auto pollResult = this->poll(0);
+        if (!pollResult) {
+            return received > 0 ? (int) received : -1;
+        }
+
+        if (!pollResult.unwrap()) {
+            break;
+        }
+
+        auto& dgram = datagrams[received];
+        dgram.result = this->receive(dgram.data, dgram.size);
+
+        if (dgram.result.result < 0) {
+            return received > 0 ? (int) received : -1;
+        }
+
+        received++;
+    }
+
+    return (int) received;
+#endif
+}
+
+Result<size_t> UdpSocket::sendBatch(const UdpDatagram* datagrams, size_t count) {
+    GLOBED_REQUIRE_SAFE(connected, "attempting to call UdpSocket::sendBatch on a disconnected socket")
+
+    globed::netLog("UdpSocket::sendBatch(this={}, count={})", (void*)this, count);
+
+#ifdef GLOBED_SOCKET_MMSG
+    size_t sent = 0;
+
+    while (sent < count) {
+        size_t batch = std::min(count - sent, MAX_BATCH);
+
+        mmsghdr msgs[MAX_BATCH];
+        iovec iovecs[MAX_BATCH];
+
+        std::memset(msgs, 0, sizeof(mmsghdr) * batch);
+
+        for (size_t i = 0; i < batch; i++) {
+            iovecs[i].iov_base = datagrams[sent + i].data;
+            iovecs[i].iov_len = datagrams[sent + i].size;
+
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = destAddr_.get();
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        int retval = sendmmsg(socket_, msgs, batch, 0);
+
+        if (retval == -1) {
+            auto errmsg = util::net::lastErrorString();
+            globed::netLog("UdpSocket::sendBatch failed, code {}: {}", retval, errmsg);
+            return Err(fmt::format("sendmmsg failed ({}): {}", retval, errmsg));
+        }
+
+        sent += retval;
+    }
+
+    return Ok(sent);
+#else
+    for (size_t i = 0; i < count; i++) {
+        GLOBED_UNWRAP(this->send(datagrams[i].data, datagrams[i].size));
+    }
+
+    return Ok(count);
+#endif
+}
+
 bool UdpSocket::close() {
     if (!connected) return true;
 
@@ -6,6 +6,15 @@
 
 struct sockaddr_in;
 
+// A single datagram used in batched UDP operations
+struct UdpDatagram {
+    char* data;
+    // capacity of the buffer when receiving, length of the data when sending
+    int size;
+    // filled in by `UdpSocket::receiveBatch`
+    RecvResult result;
+};
+
 class UdpSocket : public Socket {
 public:
     using Socket::send;
@@ -18,6 +27,19 @@ public:
     Result<int> send(const char* data, unsigned int dataSize) override;
     Result<int> sendTo(const char* data, unsigned int dataSize, const NetworkAddress& address);
     RecvResult receive(char* buffer, int bufferSize) override;
+
+    // max amount of datagrams handled by a single batch call
+    static constexpr size_t MAX_BATCH = 32;
+
+    // Receive up to `count` datagrams that are already queued on the socket, without blocking.
+    // Returns the amount of datagrams received, or -1 on failure (check `util::net::lastErrorCode()`).
+    // Uses `recvmmsg` where available, otherwise falls back to a poll + recvfrom loop.
+    int receiveBatch(UdpDatagram* datagrams, size_t count);
+
+    // Send `count` datagrams to the connected address, returns the amount of datagrams sent.
+    // Uses `sendmmsg` where available, otherwise falls back to a sendto loop.
+    Result<size_t> sendBatch(const UdpDatagram* datagrams, size_t count);
+
     bool close() override;
     virtual void disconnect();
     Result<bool> poll(int msDelay, bool in = true) override;
@@ -3,6 +3,7 @@
 #ifdef GLOBED_ARM
 
 #include <util/misc.hpp>
+#include <util/math.hpp>
 #include <arm_neon.h>
 
 float globed::simd::arm::pcmVolume(const float* pcm, std::size_t samples) {
@@ -32,4 +33,50 @@ float globed::simd::arm::pcmVolume(const float* pcm, std::size_t samples) {
 #endif
 }
 
-#endif
\ No newline at end of file
+float globed::simd::arm::mixPcm(float* dest, const float* src, std::size_t samples, float gain) {
+#ifdef GLOBED_ARM64
+    size_t alignedSamples = samples / 4 * 4;
+
+    float32x4_t sumVec = vdupq_n_f32(0.0f);
+    float32x4_t gainVec = vdupq_n_f32(gain);
+
+    for (size_t i = 0; i < alignedSamples; i += 4) {
+        float32x4_t srcVec = vld1q_f32(src + i);
+        float32x4_t destVec = vld1q_f32(dest + i);
+        vst1q_f32(dest + i, vmlaq_f32(destVec, srcVec, gainVec));
+        sumVec = vaddq_f32(sumVec, vabsq_f32(srcVec));
+    }
+
+    float sum = vaddvq_f32(sumVec);
+
+    for (size_t i = alignedSamples; i < samples; i++) {
+        dest[i] += src[i] * gain;
+        sum += std::abs(src[i]);
+    }
+
+    return sum / samples;
+#else
+    return util::misc::mixPcmSlow(dest, src, samples, gain);
+#endif
+}
+
+void globed::simd::arm::lerp(const float* from, const float* to, const float* ratio, float* out, std::size_t count) {
+#ifdef GLOBED_ARM64
+    size_t alignedCount = count / 4 * 4;
+
+    for (size_t i = 0; i < alignedCount; i += 4) {
+        float32x4_t fromVec = vld1q_f32(from + i);
+        float32x4_t toVec = vld1q_f32(to + i);
+        float32x4_t ratioVec = vld1q_f32(ratio + i);
+        vst1q_f32(out + i, vmlaq_f32(fromVec, vsubq_f32(toVec, fromVec), ratioVec));
+    }
+
+    for (size_t i = alignedCount; i < count; i++) {
+        out[i] = from[i] + (to[i] - from[i]) * ratio[i];
+    }
+#else
+    util::math::lerpSlow(from, to, ratio, out, count);
+#endif
+}
+
+#endif
@@ -8,6 +8,8 @@
 
 namespace globed::simd::arm {
     float pcmVolume(const float* pcm, std::size_t samples);
+    float mixPcm(float* dest, const float* src, std::size_t samples, float gain);
+    void lerp(const float* from, const float* to, const float* ratio, float* out, std::size_t count);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include "x86simd.hpp"
+
+#ifdef GLOBED_X86
+
+namespace globed::simd::x86 {
+    void lerpSSE(const float* from, const float* to, const float* ratio, float* out, size_t count) {
+        size_t alignedCount = count / 4 * 4;
+
+        for (size_t i = 0; i < alignedCount; i += 4) {
+            __m128 fromVec = _mm_loadu_ps(from + i);
+            __m128 toVec = _mm_loadu_ps(to + i);
+            __m128 ratioVec = _mm_loadu_ps(ratio + i);
+            _mm_storeu_ps(out + i, _mm_add_ps(fromVec, _mm_mul_ps(_mm_sub_ps(toVec, fromVec), ratioVec)));
+        }
+
+        for (size_t i = alignedCount; i < count; i++) {
+            out[i] = from[i] + (to[i] - from[i]) * ratio[i];
+        }
+    }
+
+    void GLOBED_FEATURE_AVX2 lerpAVX2(const float* from, const float* to, const float* ratio, float* out, size_t count) {
+        size_t alignedCount = count / 8 * 8;
+
+        for (size_t i = 0; i < alignedCount; i += 8) {
+            __m256 fromVec = _mm256_loadu_ps(from + i);
+            __m256 toVec = _mm256_loadu_ps(to + i);
+            __m256 ratioVec = _mm256_loadu_ps(ratio + i);
+            _mm256_storeu_ps(out + i, _mm256_add_ps(fromVec, _mm256_mul_ps(_mm256_sub_ps(toVec, fromVec), ratioVec)));
+        }
+
+        for (size_t i = alignedCount; i < count; i++) {
+            out[i] = from[i] + (to[i] - from[i]) * ratio[i];
+        }
+    }
+}
+
+#endif
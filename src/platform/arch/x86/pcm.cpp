@@ -66,6 +66,54 @@ namespace globed::simd::x86 {
 
         return sum / samples;
     }
+
+    float mixPcmSSE(float* dest, const float* src, size_t samples, float gain) {
+        size_t alignedSamples = samples / 4 * 4;
+
+        __m128 sumVec = _mm_setzero_ps();
+        __m128 maskVec = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 gainVec = _mm_set1_ps(gain);
+
+        for (size_t i = 0; i < alignedSamples; i += 4) {
+            __m128 srcVec = _mm_loadu_ps(src + i);
+            __m128 destVec = _mm_loadu_ps(dest + i);
+            _mm_storeu_ps(dest + i, _mm_add_ps(destVec, _mm_mul_ps(srcVec, gainVec)));
+            sumVec = _mm_add_ps(sumVec, _mm_and_ps(srcVec, maskVec));
+        }
+
+        float sum = asp::simd::vec128sum(sumVec);
+
+        for (size_t i = alignedSamples; i < samples; i++) {
+            dest[i] += src[i] * gain;
+            sum += std::abs(src[i]);
+        }
+
+        return sum / samples;
+    }
+
+    float GLOBED_FEATURE_AVX2 mixPcmAVX2(float* dest, const float* src, size_t samples, float gain) {
+        size_t alignedSamples = samples / 8 * 8;
+
+        __m256 sumVec = _mm256_setzero_ps();
+        __m256 maskVec = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        __m256 gainVec = _mm256_set1_ps(gain);
+
+        for (size_t i = 0; i < alignedSamples; i += 8) {
+            __m256 srcVec = _mm256_loadu_ps(src + i);
+            __m256 destVec = _mm256_loadu_ps(dest + i);
+            _mm256_storeu_ps(dest + i, _mm256_add_ps(destVec, _mm256_mul_ps(srcVec, gainVec)));
+            sumVec = _mm256_add_ps(sumVec, _mm256_and_ps(srcVec, maskVec));
+        }
+
+        float sum = vec256sum(sumVec);
+
+        for (size_t i = alignedSamples; i < samples; i++) {
+            dest[i] += src[i] * gain;
+            sum += std::abs(src[i]);
+        }
+
+        return sum / samples;
+    }
 }
 
 #endif
\ No newline at end of file
@@ -38,6 +38,26 @@ namespace globed::simd::x86 {
             return pcmVolumeSSE(pcm, samples);
         }
     }
+
+    float mixPcm(float* dest, const float* src, size_t samples, float gain) {
+        const auto& features = asp::simd::getFeatures();
+
+        if (features.avx2) {
+            return mixPcmAVX2(dest, src, samples, gain);
+        } else {
+            return mixPcmSSE(dest, src, samples, gain);
+        }
+    }
+
+    void lerp(const float* from, const float* to, const float* ratio, float* out, size_t count) {
+        const auto& features = asp::simd::getFeatures();
+
+        if (features.avx2) {
+            lerpAVX2(from, to, ratio, out, count);
+        } else {
+            lerpSSE(from, to, ratio, out, count);
+        }
+    }
 }
 
 #endif
\ No newline at end of file
@@ -38,6 +38,12 @@ namespace globed::simd::x86 {
     // Calculate the volume of pcm samples, picking the fastest possible implementation.
     float pcmVolume(const float* pcm, size_t samples);
 
+    // Add `src * gain` to `dest` and calculate the volume of `src`, picking the fastest possible implementation.
+    float mixPcm(float* dest, const float* src, size_t samples, float gain);
+
+    // Lerp every element of `from` towards `to` by `ratio`, picking the fastest possible implementation.
+    void lerp(const float* from, const float* to, const float* ratio, float* out, size_t count);
+
 
     /* Functions written with a specific algorithm */
 
@@ -45,6 +51,12 @@ namespace globed::simd::x86 {
     float pcmVolumeSSE(const float* pcm, size_t samples);
     float GLOBED_FEATURE_AVX2 pcmVolumeAVX2(const float* pcm, size_t samples);
     float GLOBED_FEATURE_AVX512DQ pcmVolumeAVX512(const float* pcm, size_t samples);
+
+    float mixPcmSSE(float* dest, const float* src, size_t samples, float gain);
+    float GLOBED_FEATURE_AVX2 mixPcmAVX2(float* dest, const float* src, size_t samples, float gain);
+
+    void lerpSSE(const float* from, const float* to, const float* ratio, float* out, size_t count);
+    void GLOBED_FEATURE_AVX2 lerpAVX2(const float* from, const float* to, const float* ratio, float* out, size_t count);
 }
 
 #endif
\ No newline at end of file
@@ -5,3 +5,11 @@
 float util::simd::calcPcmVolume(const float* pcm, size_t samples) {
     return globed::simd::arm::pcmVolume(pcm, samples);
 }
+
+float util::simd::mixPcm(float* dest, const float* src, size_t samples, float gain) {
+    return globed::simd::arm::mixPcm(dest, src, samples, gain);
+}
+
+void util::simd::lerp(const float* from, const float* to, const float* ratio, float* out, size_t count) {
+    globed::simd::arm::lerp(from, to, ratio, out, count);
+}
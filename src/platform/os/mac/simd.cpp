@@ -16,3 +16,19 @@ float util::simd::calcPcmVolume(const float *pcm, size_t samples) {
     return globed::simd::x86::pcmVolume(pcm, samples);
 #endif
 }
+
+float util::simd::mixPcm(float* dest, const float* src, size_t samples, float gain) {
+#ifdef GEODE_IS_ARM_MAC
+    return globed::simd::arm::mixPcm(dest, src, samples, gain);
+#else
+    return globed::simd::x86::mixPcm(dest, src, samples, gain);
+#endif
+}
+
+void util::simd::lerp(const float* from, const float* to, const float* ratio, float* out, size_t count) {
+#ifdef GEODE_IS_ARM_MAC
+    globed::simd::arm::lerp(from, to, ratio, out, count);
+#else
+    globed::simd::x86::lerp(from, to, ratio, out, count);
+#endif
+}
@@ -1,6 +1,8 @@
 #include "overlay.hpp"
 
 #include <managers/settings.hpp>
+#include <net/clock_sync.hpp>
+#include <net/udp_frame_buffer.hpp>
 
 using namespace geode::prelude;
 
@@ -43,6 +45,26 @@ bool GlobedOverlay::init() {
         .parent(this)
         .id("ping-label"_spr);
 
+    // only shown once something goes wrong with fragmented packets
+    Build<CCLabelBMFont>::create("", "bigFont.fnt")
+        .opacity(static_cast<uint8_t>(settings.opacity * 255))
+        .scale(0.5f)
+        .store(frameStatsLabel)
+        .parent(this)
+        .id("frame-stats-label"_spr);
+
+    frameStatsLabel->setVisible(false);
+
+    // only shown once the clocks are synchronized with the server
+    Build<CCLabelBMFont>::create("", "bigFont.fnt")
+        .opacity(static_cast<uint8_t>(settings.opacity * 255))
+        .scale(0.5f)
+        .store(clockStatsLabel)
+        .parent(this)
+        .id("clock-stats-label"_spr);
+
+    clockStatsLabel->setVisible(false);
+
 #ifdef GLOBED_DEBUG
     std::string versionStr = Mod::get()->getVersion().toVString();
     Build<CCLabelBMFont>::create(versionStr.c_str(), "bigFont.fnt")
@@ -68,6 +90,43 @@ void GlobedOverlay::updatePing(uint32_t ms) {
     this->updateLayout();
 }
 
+void GlobedOverlay::updateFrameStats(const UdpFrameStats& stats) {
+    auto& settings = GlobedSettings::get();
+    if (!settings.overlay.enabled) return;
+
+    bool show = stats.dropped > 0 || stats.expired > 0 || stats.duplicate > 0;
+    if (show) {
+        auto fmted = fmt::format("Frames: {} dropped, {} expired, {} duplicate", stats.dropped, stats.expired, stats.duplicate);
+        frameStatsLabel->setString(fmted.c_str());
+    }
+
+    if (show != frameStatsLabel->isVisible()) {
+        frameStatsLabel->setVisible(show);
+    }
+
+    this->updateLayout();
+}
+
+void GlobedOverlay::updateClockStats(const ClockSyncStats& stats) {
+    auto& settings = GlobedSettings::get();
+    if (!settings.overlay.enabled) return;
+
+    bool show = stats.samples > 0;
+    if (show) {
+        auto fmted = fmt::format(
+            "Clock: drift {:+.1f} ms ({:+.0f} ppm), jitter {:.1f} ms",
+            stats.drift * 1000.0, stats.skew * 1'000'000.0, stats.jitter * 1000.0
+        );
+        clockStatsLabel->setString(fmted.c_str());
+    }
+
+    if (show != clockStatsLabel->isVisible()) {
+        clockStatsLabel->setVisible(show);
+    }
+
+    this->updateLayout();
+}
+
 void GlobedOverlay::updateWithDisconnected() {
     auto& settings = GlobedSettings::get();
     if (!settings.overlay.enabled) return;
@@ -1,11 +1,16 @@
 #pragma once
 #include <defs/all.hpp>
 
+struct UdpFrameStats;
+struct ClockSyncStats;
+
 class GlobedOverlay : public cocos2d::CCNode {
 public:
     bool init();
 
     void updatePing(uint32_t ms);
+    void updateFrameStats(const UdpFrameStats& stats);
+    void updateClockStats(const ClockSyncStats& stats);
     void updateWithDisconnected();
     void updateWithEditor();
 
@@ -14,5 +19,7 @@ public:
 private:
     cocos2d::CCLabelBMFont
         *pingLabel = nullptr,
+        *frameStatsLabel = nullptr,
+        *clockStatsLabel = nullptr,
         *versionLabel = nullptr;
 };
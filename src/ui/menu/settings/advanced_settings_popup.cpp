@@ -1,5 +1,7 @@
 #include "advanced_settings_popup.hpp"
 
+#include <audio/voice_playback_manager.hpp>
+#include <globed/benchmarks.hpp>
 #include <managers/account.hpp>
 #include <managers/settings.hpp>
 #include <net/manager.hpp>
@@ -68,6 +70,14 @@ bool AdvancedSettingsPopup::setup() {
         .pos(rlayout.center - CCPoint{0.f, 60.f})
         .parent(menu);
 
+    Build<ButtonSprite>::create("Benchmarks", "bigFont.fnt", "GJ_button_01.png", 0.75f)
+        .scale(0.8f)
+        .intoMenuItem([this](auto) {
+            globed::bench::runAll();
+        })
+        .pos(rlayout.center - CCPoint{0.f, 90.f})
+        .parent(menu);
+
     auto* thing = Build(CCMenuItemToggler::createWithStandardSprites(this, menu_selector(AdvancedSettingsPopup::onPacketLog), 0.7f))
         .parent(menu)
         .collect();
@@ -80,6 +90,7 @@ bool AdvancedSettingsPopup::setup() {
 void AdvancedSettingsPopup::onPacketLog(CCObject* p) {
     bool enabled = !static_cast<CCMenuItemToggler*>(p)->isOn();
     NetworkManager::get().togglePacketLogging(enabled);
+    VoicePlaybackManager::get().setTraceRecording(enabled);
 }
 
 AdvancedSettingsPopup* AdvancedSettingsPopup::create() {
@@ -281,6 +281,8 @@ void GlobedSettingsLayer::createSettingsCells(int category) {
             registerSetting(cat, settings.dummySetting, "Keybinds", "Opens the <cg>Keybinds Settings</c>.", Type::KeybindSettings);
             registerSetting(cat, settings.globed.fragmentationLimit, "Packet limit", "Press the \"Test\" button to calibrate the maximum packet size. Should fix some of the issues with players not appearing in a level.", Type::PacketFragmentation);
             registerSetting(cat, settings.globed.forceTcp, "Force TCP", "Forces the use of TCP for <cg>all packets</c>. This may help with some connection issues, but it also may result in higher latency and less smooth gameplay. <cy>Reconnect to the server to see changes.</c>");
+            registerSetting(cat, settings.globed.batchedUdp, "Batched networking", "Receives and sends multiple UDP packets at once, which lowers CPU usage in levels with many players. Disable this if you are experiencing connection issues. <cy>Reconnect to the server to see changes.</c>");
+            registerSetting(cat, settings.globed.deltaPlayerData, "Compact player data", "Sends only what changed in player data since the last keyframe, which uses much less bandwidth in levels with many players. Only has an effect on servers that support it. Note: this feature is <cp>experimental</c>.");
             registerSetting(cat, settings.globed.showRelays, "Show server relays", "Shows <cg>server relays</c> in the server list, if the current server has any. Relays can help if experiencing connection issues. Note: this feature is <cp>experimental</c>.");
 
 #ifndef GEODE_IS_ANDROID
@@ -314,6 +316,7 @@ void GlobedSettingsLayer::createSettingsCells(int category) {
             registerSetting(cat, settings.communication.onlyFriends, "Only friends", "When enabled, you won't hear players that are not on your friend list in-game.");
             registerSetting(cat, settings.communication.lowerAudioLatency, "Lower audio latency", "Decreases the audio buffer size by 2 times, reducing the latency but potentially causing audio issues.");
             registerSetting(cat, settings.communication.tcpAudio, "TCP Voice chat", "Uses TCP instead of UDP for voice chat, may sometimes help with voice chat not working");
+            registerSetting(cat, settings.communication.voiceMixer, "Mix voices", "Plays all players through a single audio stream instead of one per player. Uses less CPU in levels with many people talking.");
             registerSetting(cat, settings.communication.deafenNotification, "Deafen notification", "Shows a notification when you deafen & undeafen.");
             registerSetting(cat, settings.communication.audioDevice, "Audio device", "The input device used for recording your voice.", Type::AudioDevice);
             // MAKE_SETTING(communication, voiceLoopback, "Voice loopback", "When enabled, you will hear your own voice as you speak.");
@@ -345,6 +348,7 @@ void GlobedSettingsLayer::createSettingsCells(int category) {
             registerSetting(cat, settings.players.hideNearby, "Hide nearby players", "Increases the transparency of players as they get closer to you, so that they don't obstruct your view.");
             registerSetting(cat, settings.players.statusIcons, "Status icons", "Show an icon above a player if they are paused, in practice mode, or currently speaking.");
             registerSetting(cat, settings.players.hidePracticePlayers, "Hide players in practice", "Hide players that are in practice mode.");
+            registerSetting(cat, settings.players.extrapolation, "Predict movement", "When a player's data arrives late, keep moving them along their last known path for a short while instead of freezing them in place.");
         } break;
     }
 }
@@ -1,4 +1,7 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <optional>
 #include <vector>
 #include <queue>
 #include <map>
@@ -238,6 +241,85 @@ public:
     }
 };
 
+/*
+* SpscRing is a bounded lock-free queue for exactly one producer thread and one consumer thread.
+* The indices live on separate cache lines, and each side keeps a cached copy of the other side's index,
+* so in the common case pushing and popping touch no shared cache lines besides the slot itself.
+*/
+
+template <typename T, size_t Capacity> requires (Capacity > 1 && (Capacity & (Capacity - 1)) == 0)
+class SpscRing {
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr size_t MASK = Capacity - 1;
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only. Returns false and leaves `value` untouched if the ring is full.
+    bool tryPush(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - cachedHead_ == Capacity) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == Capacity) {
+                return false;
+            }
+        }
+
+        slots[tail & MASK] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer only.
+    std::optional<T> tryPop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return std::nullopt;
+            }
+        }
+
+        std::optional<T> out = std::move(slots[head & MASK]);
+        // don't keep the moved-from value alive until the slot gets reused
+        slots[head & MASK] = T{};
+        head_.store(head + 1, std::memory_order_release);
+
+        return out;
+    }
+
+    // Approximate when called while the other side is active.
+    size_t size() const {
+        // load head first, the tail can only be ahead of it
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    bool empty() const {
+        return this->size() == 0;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    // written by the consumer
+    alignas(CACHE_LINE) std::atomic<size_t> head_ = 0;
+    size_t cachedTail_ = 0;
+
+    // written by the producer
+    alignas(CACHE_LINE) std::atomic<size_t> tail_ = 0;
+    size_t cachedHead_ = 0;
+
+    alignas(CACHE_LINE) std::array<T, Capacity> slots = {};
+};
+
 template <typename K, typename V>
 std::vector<K> mapKeys(const std::map<K, V>& map) {
     std::vector<K> out;
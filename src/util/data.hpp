@@ -18,6 +18,11 @@ namespace util::data {
     template <typename T>
     concept IsPrimitive = asp::data::is_primitive<T>;
 
+    // Primitives that can be copied in bulk, as their representation only differs from the wire format by endianness.
+    // bool is excluded, because `std::vector<bool>` does not store its elements as bools.
+    template <typename T>
+    concept IsBulkPrimitive = IsPrimitive<T> && !std::is_same_v<T, bool>;
+
     // macos github actions runner has no std::bit_cast support
 #ifdef __cpp_lib_bit_cast
     template <typename To, typename From>
@@ -45,6 +50,16 @@ namespace util::data {
         return val;
     }
 
+    // `maybeByteswap` every element of an array, written so that the compiler can vectorize it
+    template <typename T>
+    inline void maybeByteswapRange(T* data, size_t count) {
+        if constexpr (GLOBED_LITTLE_ENDIAN && sizeof(T) > 1) {
+            for (size_t i = 0; i < count; i++) {
+                data[i] = byteswap(data[i]);
+            }
+        }
+    }
+
     // Converts the bit count into bytes required to fit it.
     // That means, 15 or 16 bits equals 2 bytes, but 17 bits equals 3 bytes.
     constexpr size_t bitsToBytes(size_t bits) {
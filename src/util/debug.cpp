@@ -69,6 +69,71 @@ namespace util::debug {
         }
     }
 
+    void LatencyHistogram::record(Duration latency) {
+        uint64_t micros = latency.micros();
+
+        size_t bucket = 0;
+        while (micros > 1 && bucket < BUCKETS - 1) {
+            micros >>= 1;
+            bucket++;
+        }
+
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+        Snapshot out;
+
+        for (size_t i = 0; i < BUCKETS; i++) {
+            out[i] = buckets[i].load(std::memory_order_relaxed);
+        }
+
+        return out;
+    }
+
+    void LatencyHistogram::reset() {
+        for (auto& bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void LatencyHistogram::print(std::string_view name, const Snapshot& snapshot) {
+        size_t total = 0;
+        for (size_t count : snapshot) {
+            total += count;
+        }
+
+        if (total == 0) {
+            log::debug("{}: no samples", name);
+            return;
+        }
+
+        auto formatBucket = [](size_t i) {
+            return Duration::fromMicros((uint64_t) 1 << i).toString();
+        };
+
+        // find the bucket that contains the median sample
+        size_t seen = 0, median = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += snapshot[i];
+            if (seen * 2 >= total) {
+                median = i;
+                break;
+            }
+        }
+
+        log::debug("{}: {} samples, median in [{}, {})", name, total, formatBucket(median), formatBucket(median + 1));
+
+        for (size_t i = 0; i < BUCKETS; i++) {
+            if (snapshot[i] == 0) continue;
+
+            log::debug(
+                "  [{}, {}): {} ({:.1f}%)",
+                formatBucket(i), formatBucket(i + 1), snapshot[i], snapshot[i] * 100.0 / total
+            );
+        }
+    }
+
     void PacketLogSummary::print() {
         log::debug("====== Packet summary ======");
         if (total == 0) {
@@ -83,6 +148,10 @@ namespace util::debug {
                 format::formatBytes(totalBytesIn)
             );
             log::debug("Average bytes per packet: {}", format::formatBytes((uint64_t)bytesPerPacket));
+            log::debug("Allocations avoided on receive: {}", allocationsAvoided);
+            LatencyHistogram::print("Send latency", sendLatency);
+            log::debug("Inbound queue depth: {} (high-water mark: {}), coalesced packets: {}", inboundQueueDepth, inboundQueueHighWater, coalescedPackets);
+            log::debug("Dropped UDP datagrams: {}", droppedDatagrams);
 
             // sort packets by the counts
             std::vector<std::pair<packetid_t, size_t>> pc(packetCounts.begin(), packetCounts.end());
@@ -110,6 +179,39 @@ namespace util::debug {
 #endif // GLOBED_DEBUG_PACKETS
     }
 
+    void PacketLogger::recordAllocationsAvoided(size_t count) {
+#ifdef GLOBED_DEBUG_PACKETS
+        allocationsAvoided.fetch_add(count, std::memory_order_relaxed);
+#endif // GLOBED_DEBUG_PACKETS
+    }
+
+    void PacketLogger::recordSendLatency(Duration latency) {
+#ifdef GLOBED_DEBUG_PACKETS
+        sendLatency.record(latency);
+#endif
+    }
+
+    void PacketLogger::recordQueueDepth(size_t depth) {
+#ifdef GLOBED_DEBUG_PACKETS
+        inboundQueueDepth.store(depth, std::memory_order_relaxed);
+
+        size_t highWater = inboundQueueHighWater.load(std::memory_order_relaxed);
+        while (depth > highWater && !inboundQueueHighWater.compare_exchange_weak(highWater, depth, std::memory_order_relaxed)) {}
+#endif
+    }
+
+    void PacketLogger::recordCoalesced(size_t count) {
+#ifdef GLOBED_DEBUG_PACKETS
+        coalescedPackets.fetch_add(count, std::memory_order_relaxed);
+#endif
+    }
+
+    void PacketLogger::recordDroppedDatagram() {
+#ifdef GLOBED_DEBUG_PACKETS
+        droppedDatagrams.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
     PacketLogSummary PacketLogger::getSummary() {
         PacketLogSummary summary = {};
 
@@ -136,6 +238,12 @@ namespace util::debug {
 
         summary.bytesPerPacket = (float)summary.totalBytes / summary.total;
         summary.encryptedRatio = (float)summary.totalEncrypted / summary.total;
+        summary.allocationsAvoided = allocationsAvoided.load(std::memory_order_relaxed);
+        summary.sendLatency = sendLatency.snapshot();
+        summary.inboundQueueDepth = inboundQueueDepth.load(std::memory_order_relaxed);
+        summary.inboundQueueHighWater = inboundQueueHighWater.load(std::memory_order_relaxed);
+        summary.coalescedPackets = coalescedPackets.load(std::memory_order_relaxed);
+        summary.droppedDatagrams = droppedDatagrams.load(std::memory_order_relaxed);
 
         return summary;
     }
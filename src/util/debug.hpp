@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <atomic>
 #include <unordered_map>
 
 #include <asp/sync.hpp>
@@ -54,6 +56,24 @@ namespace util::debug {
         std::unordered_map<std::string, WatcherEntry> _entries;
     };
 
+    // Histogram of latencies with power of two buckets in microseconds, bucket `i` holds values in [2^i, 2^(i+1)).
+    // The first bucket also holds anything below 1us and the last one anything above. Thread safe.
+    class LatencyHistogram {
+    public:
+        static constexpr size_t BUCKETS = 24;
+        using Snapshot = std::array<size_t, BUCKETS>;
+
+        void record(asp::time::Duration latency);
+        Snapshot snapshot() const;
+        void reset();
+
+        // log every non-empty bucket along with the total count and the median bucket
+        static void print(std::string_view name, const Snapshot& snapshot);
+
+    private:
+        std::array<std::atomic<size_t>, BUCKETS> buckets = {};
+    };
+
     struct PacketLog {
         packetid_t id;
         bool encrypted;
@@ -79,15 +99,37 @@ namespace util::debug {
         float bytesPerPacket;
         float encryptedRatio;
 
+        // heap allocations skipped thanks to pooled receive buffers and borrowed packet fields
+        size_t allocationsAvoided;
+
+        // time between a packet being queued with `NetworkManager::send` and it being handed to the socket
+        LatencyHistogram::Snapshot sendLatency;
+
+        // packets waiting for the main thread to dispatch them, as of the last received packet
+        size_t inboundQueueDepth;
+        size_t inboundQueueHighWater;
+        // level data packets that were merged into a newer one because the inbound queue overflowed
+        size_t coalescedPackets;
+        // UDP datagrams that were skipped because they failed to decode
+        size_t droppedDatagrams;
+
         void print();
     };
 
     class PacketLogger : public SingletonLeakBase<PacketLogger> {
     public:
         void record(packetid_t id, bool encrypted, bool outgoing, size_t bytes);
+        void recordAllocationsAvoided(size_t count);
+        void recordSendLatency(asp::time::Duration latency);
+        void recordQueueDepth(size_t depth);
+        void recordCoalesced(size_t count);
+        void recordDroppedDatagram();
         PacketLogSummary getSummary();
     private:
         collections::CappedQueue<PacketLog, 25000> queue;
+        std::atomic<size_t> allocationsAvoided = 0;
+        LatencyHistogram sendLatency;
+        std::atomic<size_t> inboundQueueDepth = 0, inboundQueueHighWater = 0, coalescedPackets = 0, droppedDatagrams = 0;
     };
 
     std::string hexDumpAddress(uintptr_t addr, size_t bytes);
@@ -1,4 +1,9 @@
 #include "math.hpp"
 
 namespace util::math {
-}
\ No newline at end of file
+    void lerpSlow(const float* from, const float* to, const float* ratio, float* out, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = from[i] + (to[i] - from[i]) * ratio[i];
+        }
+    }
+}
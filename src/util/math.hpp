@@ -1,6 +1,7 @@
 #pragma once
 #include <cmath>
 #include <limits>
+#include <optional>
 #include <stdexcept>
 #include <type_traits>
 #include <stdint.h>
@@ -49,6 +50,29 @@ namespace util::math {
         return ((!std::isnan(args)) && ...);
     }
 
+    // Rounds `value * scale` to the nearest integer, returns nullopt if the result does not fit in `T`
+    template <std::integral T>
+    inline std::optional<T> quantize(float value, float scale) {
+        float q = std::round(value * scale);
+
+        if (!std::isfinite(q) || q < (float) std::numeric_limits<T>::min() || q > (float) std::numeric_limits<T>::max()) {
+            return std::nullopt;
+        }
+
+        return static_cast<T>(q);
+    }
+
+    // `out[i] = from[i] + (to[i] - from[i]) * ratio[i]`, without simd. `util::simd::lerp` picks the fastest implementation
+    void lerpSlow(const float* from, const float* to, const float* ratio, float* out, size_t count);
+
+    // Signed difference between two angles in degrees, in the range [-180, 180)
+    inline float angleDifference(float from, float to) {
+        float diff = std::fmod(to - from + 180.f, 360.f);
+        if (diff < 0.f) diff += 360.f;
+
+        return diff - 180.f;
+    }
+
     // floating point math is fun
 
     // `val1` == `val2`
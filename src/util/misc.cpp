@@ -52,6 +52,20 @@ namespace util::misc {
         return static_cast<float>(sum / static_cast<double>(samples));
     }
 
+    float mixPcm(float* dest, const float* src, size_t samples, float gain) {
+        return simd::mixPcm(dest, src, samples, gain);
+    }
+
+    float mixPcmSlow(float* dest, const float* src, size_t samples, float gain) {
+        double sum = 0.0f;
+        for (size_t i = 0; i < samples; i++) {
+            dest[i] += src[i] * gain;
+            sum += static_cast<double>(std::abs(src[i]));
+        }
+
+        return static_cast<float>(sum / static_cast<double>(samples));
+    }
+
     bool compareName(std::string_view nv1, std::string_view nv2) {
         std::string name1(nv1);
         std::string name2(nv2);
@@ -96,6 +96,11 @@ namespace util::misc {
 
     float pcmVolumeSlow(const float* pcm, size_t samples);
 
+    // Add `src` multiplied by `gain` to `dest`, returns the average volume of `src`
+    float mixPcm(float* dest, const float* src, size_t samples, float gain);
+
+    float mixPcmSlow(float* dest, const float* src, size_t samples, float gain);
+
     bool compareName(std::string_view name1, std::string_view name2);
 
     bool isEditorCollabLevel(LevelId levelId);
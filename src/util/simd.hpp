@@ -5,5 +5,11 @@
 namespace util::simd {
     float calcPcmVolume(const float* pcm, size_t samples);
 
+    // Add `src` multiplied by `gain` to `dest`, returns the volume of `src` (same as `calcPcmVolume`)
+    float mixPcm(float* dest, const float* src, size_t samples, float gain);
+
+    // Linearly interpolate every element, `out[i] = from[i] + (to[i] - from[i]) * ratio[i]`. `out` may be the same array as `from` or `to`
+    void lerp(const float* from, const float* to, const float* ratio, float* out, size_t count);
+
     uint32_t adler32(const uint8_t* data, size_t len);
 }
\ No newline at end of file